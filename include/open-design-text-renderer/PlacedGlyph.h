@@ -1,6 +1,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -13,7 +14,19 @@ namespace odtr {
 struct FontSpecifier {
     /// Font face Id.
     std::string faceId;
-
+    /**
+     * Internal - handle of the face within the context which shaped the text, used to skip the lookup by name.
+     * It is not serialized and not meaningful in other contexts, leave it unset. Ignored by the comparisons,
+     * font specifiers are identified by faceId only.
+     */
+    uint32_t faceHandle = UINT32_MAX;
+
+    bool operator==(const FontSpecifier& other) const {
+        return faceId == other.faceId;
+    }
+    bool operator!=(const FontSpecifier& other) const {
+        return !(*this == other);
+    }
     /// Comparison operator - used to make this struct a map key.
     bool operator<(const FontSpecifier& other) const {
         return faceId < other.faceId;
@@ -32,6 +45,10 @@ struct PlacedGlyph {
     uint32_t color;
     /// Index of the glyph within the input text.
     size_t index = 0;
+    /// Index of the line the glyph is placed on, see PlacedTextData::lineBounds.
+    size_t lineIndex = 0;
+    /// Bounds of the glyph bitmap at scale 1 (approximate for other scales due to hinting and rounding).
+    FRectangle bounds = {};
 };
 using PlacedGlyphs = std::vector<PlacedGlyph>;
 using PlacedGlyphsPerFont = std::map<FontSpecifier, PlacedGlyphs>;
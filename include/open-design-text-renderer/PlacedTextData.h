@@ -12,6 +12,7 @@ struct PlacedTextData
     PlacedTextData() = default;
     PlacedTextData(PlacedGlyphsPerFont &&glyphs_,
                    PlacedDecorations &&decorations_,
+                   std::vector<FRectangle> &&lineBounds_,
                    const FRectangle &textBounds_,
                    const Matrix3f &transform_);
 
@@ -19,6 +20,8 @@ struct PlacedTextData
     PlacedGlyphsPerFont glyphs;
     /// Decorations and their placements.
     PlacedDecorations decorations;
+    /// Bounds of the glyphs on each line at scale 1, indexed by PlacedGlyph::lineIndex. Used to skip invisible lines when drawing.
+    std::vector<FRectangle> lineBounds;
     /// Text bounds within the layer.
     FRectangle textBounds;
     /// Text transfomation within the layer.
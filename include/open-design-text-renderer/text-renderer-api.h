@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <string>
 #include <vector>
@@ -16,6 +17,11 @@ struct Context;
 struct TextShape;
 struct PlacedTextData;
 
+/// Default memory limit of the rendered glyphs cache in bytes.
+constexpr size_t DEFAULT_GLYPH_CACHE_BUDGET = 16 << 20;
+/// Default memory limit of the text shaping results cache in bytes.
+constexpr size_t DEFAULT_SHAPING_CACHE_BUDGET = 4 << 20;
+
 struct ContextOptions
 {
     using LogFuncType = std::function<void(const std::string&)>;
@@ -23,6 +29,51 @@ struct ContextOptions
     LogFuncType errorFunc;
     LogFuncType warnFunc;
     LogFuncType infoFunc;
+
+    /**
+     * Memory limit of the rendered glyphs cache in bytes, 0 disables the cache.
+     */
+    size_t glyphCacheBudget = DEFAULT_GLYPH_CACHE_BUDGET;
+
+    /**
+     * Memory limit of the text shaping results cache in bytes, 0 disables the cache.
+     */
+    size_t shapingCacheBudget = DEFAULT_SHAPING_CACHE_BUDGET;
+
+    /**
+     * Number of threads used by batch operations (shapeTexts, drawTexts) and by shapeText and reshapeText
+     * of texts with many paragraphs, 0 for the number of hardware threads. The threads are started on first use.
+     * The default 1 runs everything on the calling thread, with more threads the log functions may be called
+     * from the worker threads.
+     */
+    size_t threadCount = 1;
+
+    /**
+     * Directory of the persistent cache of shaped texts, shared by contexts and processes. Empty disables the cache.
+     * Texts found in the cache are not shaped again, which requires the same fonts to be loaded.
+     */
+    std::string shapeCacheDirectory;
+
+    /**
+     * Size limit of the files in @a shapeCacheDirectory in bytes, the least recently used ones are removed when exceeded.
+     */
+    size_t shapeCacheDiskBudget = 256 << 20;
+
+    /**
+     * Memory map the font files of addFontFile where supported, instead of reading them into the memory.
+     * A mapped file must not be truncated or replaced in place while the context exists, the process is killed
+     * by SIGBUS when the faces read the missing data. Enable only for files which don't change, such as bundled fonts.
+     */
+    bool mapFontFiles = false;
+};
+
+struct CacheStatistics
+{
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+    size_t entries;
+    size_t bytes;
 };
 
 struct Rectangle
@@ -73,15 +124,30 @@ struct DrawTextResult
 typedef Context* ContextHandle;
 typedef TextShape* TextShapeHandle;
 
+struct DrawJob
+{
+    TextShapeHandle textShape;
+
+    /**
+     * Buffer to draw into, see @a drawText.
+     */
+    void* pixels;
+    int width;
+    int height;
+
+    DrawOptions drawOptions;
+};
+
 /**
  * @brief Creates and initializes Text Renderer's context.
  *
  * A context represent a particular configuration of the engine, it
  * encapsulates a set of fonts and text shapes.
  *
- * Calls on different contexts are thread safe, however, calls using a single
+ * Calls on different contexts are thread safe. Draw calls (drawText, drawTexts)
+ * using a single context may run concurrently, other calls using a single
  * context need to be performed either from a single thread or properly
- * synchronized.
+ * synchronized with all the calls using the context.
  *
  * @param options       context configuration
  *
@@ -104,7 +170,8 @@ void destroyContext(ContextHandle ctx);
  *
  * Can be called repeatedly with the same @a filename to load multiple faces
  * from a collection. In that case, there's only a single copy of the font data
- * in the internal memory, unless override is set to @a true.
+ * in the internal memory, unless override is set to @a true. The file is read into
+ * the memory, or memory mapped if enabled by @a ContextOptions::mapFontFiles.
  *
  * Note that @a override causes all the other previously loaded faces to drop.
  * All subsequent shape or draw calls that contain a text depending on one of
@@ -126,9 +193,9 @@ bool addFontFile(ContextHandle ctx,
 /**
  * @brief Loads a single font face from a font or fonts collection stored in memory.
  *
- * In memory version of @see addFontFile. Multiple calls with the same data
- * pointer internally reuse data from the previous call, unless override is set to
- * @a true.
+ * In memory version of @see addFontFile. The data is copied, unless a font of
+ * equal content was added already, also from a file, in which case its data and
+ * faces are reused.
  *
  * Caller is free to release the @a data after the function returns.
  *
@@ -172,6 +239,22 @@ TextShapeHandle shapeText(ContextHandle ctx,
                           const octopus::Text& text);
 
 
+/**
+ * @brief Shapes multiple Octopus texts in parallel, see @a ContextOptions::threadCount.
+ *
+ * The results are identical to calling @a shapeText for each of the texts in order.
+ *
+ * @param ctx           context handle
+ * @param texts         array of @a count Octopus text objects
+ * @param count         number of texts
+ * @param textShapes    output array of @a count shaped text handles, null for texts which failed to shape
+ */
+void shapeTexts(ContextHandle ctx,
+                const octopus::Text* texts,
+                size_t count,
+                TextShapeHandle* textShapes);
+
+
 /**
  * @brief Destroys multiple text shapes created by @a shapeText call.
  *
@@ -200,6 +283,24 @@ bool reshapeText(ContextHandle ctx,
                  const octopus::Text& text);
 
 
+/**
+ * @brief Changes the frame size of an existing text shape, e.g. when the frame is resized interactively.
+ *
+ * The text is not shaped again, only broken into lines of the new width and laid out.
+ *
+ * @param ctx         context handle
+ * @param textShape   existing text shape handle
+ * @param width       new frame width
+ * @param height      new frame height
+ *
+ * @returns     boolean value indicating success of the call
+ */
+bool resizeTextFrame(ContextHandle ctx,
+                     TextShapeHandle textShape,
+                     float width,
+                     float height);
+
+
 /**
  * @brief For a given text shape returns its "logical bounds" (i.e. a frame that contains the text) with text transformation applied.
  *
@@ -274,6 +375,23 @@ DrawTextResult drawText(ContextHandle ctx,
                         const DrawOptions& drawOptions = {});
 
 
+/**
+ * @brief Draws multiple text shapes in parallel, see @a ContextOptions::threadCount.
+ *
+ * The results are identical to calling @a drawText for each of the jobs in order.
+ * Buffers of the jobs must not overlap.
+ *
+ * @param ctx         context handle
+ * @param jobs        array of @a count draw jobs
+ * @param count       number of jobs
+ * @param results     optional output array of @a count draw results
+ **/
+void drawTexts(ContextHandle ctx,
+               const DrawJob* jobs,
+               size_t count,
+               DrawTextResult* results = nullptr);
+
+
 /**
  * @brief Provides read-only access to the shaped text data.
  *
@@ -287,6 +405,62 @@ DrawTextResult drawText(ContextHandle ctx,
 const PlacedTextData *getShapedText(ContextHandle ctx,
                                     TextShapeHandle textShape);
 
+/**
+ * @brief Serializes the shaped text data into a compact versioned binary blob, e.g. to be stored or drawn by another process.
+ *
+ * The blob refers to the fonts by their PostScript names, the context drawing the deserialized data needs to have them loaded.
+ *
+ * @param ctx         context handle
+ * @param textShape   text shape handle
+ * @param compress    if true, the blob is compressed with LZ4
+ *
+ * @returns         the blob, empty on failure
+ */
+std::vector<std::uint8_t> serializeShapedText(ContextHandle ctx,
+                                              TextShapeHandle textShape,
+                                              bool compress = true);
+
+/**
+ * @brief Restores the shaped text data serialized by @a serializeShapedText, possibly in another process.
+ *
+ * @param ctx         context handle
+ * @param data        pointer to the blob
+ * @param length      length of the blob
+ *
+ * @returns         shaped text data to be drawn by @a drawShapedText, null if the blob is invalid or of another version
+ */
+std::unique_ptr<PlacedTextData> deserializeShapedText(ContextHandle ctx,
+                                                      const std::uint8_t* data,
+                                                      size_t length);
+
+/**
+ * @brief Computes dimensions of a raster that contains all the deserialized shaped text drawn with a certain @a drawOptions.
+ *
+ * @see getDrawBufferDimensions for text shapes
+ */
+Dimensions getDrawBufferDimensions(ContextHandle ctx,
+                                   const PlacedTextData& shapedText,
+                                   const DrawOptions& drawOptions = {});
+
+/**
+ * @brief Draws deserialized shaped text data into a buffer, without the text it was shaped from.
+ *
+ * @see drawText for the buffer format and the draw options
+ *
+ * @param ctx         context handle
+ * @param shapedText  shaped text data, see @a deserializeShapedText
+ * @param pixels      pointer to the start of a buffer to draw into
+ * @param width       number of columns in the buffer
+ * @param height      number of rows in the buffer
+ * @param drawOptions draw configuration
+ *
+ * @returns   result of the draw call
+ **/
+DrawTextResult drawShapedText(ContextHandle ctx,
+                              const PlacedTextData& shapedText,
+                              void* pixels, int width, int height,
+                              const DrawOptions& drawOptions = {});
+
 /**
  * @brief Determines whether the font is a color font (e.g. contains emojis)
  * 
@@ -298,6 +472,37 @@ const PlacedTextData *getShapedText(ContextHandle ctx,
 bool isColorFont(ContextHandle ctx,
                  const std::string& faceId);
 
+/**
+ * @brief Returns usage statistics of the context's rendered glyphs cache.
+ *
+ * @param ctx        context handle
+ *
+ * @returns          cache hits, misses and evictions since the context creation, current number of entries and their size in bytes
+ */
+CacheStatistics getGlyphCacheStatistics(ContextHandle ctx);
+
+/**
+ * @brief Returns usage statistics of the context's text shaping results cache.
+ *
+ * Each shaped run of characters with uniform format counts as a hit or a miss.
+ *
+ * @param ctx        context handle
+ *
+ * @returns          cache hits, misses and evictions since the context creation, current number of entries and their size in bytes
+ */
+CacheStatistics getShapingCacheStatistics(ContextHandle ctx);
+
+/**
+ * @brief Returns usage statistics of the context's persistent cache of shaped texts, see @a ContextOptions::shapeCacheDirectory.
+ *
+ * Each text shaped by @a shapeText or @a shapeTexts which isn't shared with another text shape counts as a hit or a miss.
+ *
+ * @param ctx        context handle
+ *
+ * @returns          cache hits, misses and evictions since the context creation, current number of files and their size in bytes
+ */
+CacheStatistics getShapeDiskCacheStatistics(ContextHandle ctx);
+
 #ifdef FT_LOAD_DEFAULT // FreeType included by user before ODTR (FreeType dependency is not publicly exposed)
 
 /**
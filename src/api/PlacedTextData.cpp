@@ -5,10 +5,12 @@ namespace odtr {
 
 PlacedTextData::PlacedTextData(PlacedGlyphsPerFont &&glyphs_,
                                PlacedDecorations &&decorations_,
+                               std::vector<FRectangle> &&lineBounds_,
                                const FRectangle &textBounds_,
                                const Matrix3f &textTransform_) :
     glyphs(std::move(glyphs_)),
     decorations(std::move(decorations_)),
+    lineBounds(std::move(lineBounds_)),
     textBounds(textBounds_),
     textTransform(textTransform_) {
 }
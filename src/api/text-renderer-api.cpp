@@ -4,16 +4,19 @@
 #include "../compat/affine-transform.h"
 #include "../compat/basic-types.h"
 
+#include "../fonts/FaceTable.h"
 #include "../fonts/FontManager.h"
 
 #include "../text-renderer/Config.h"
 #include "../text-renderer/Context.h"
+#include "../text-renderer/PlacedTextSerialization.h"
 #include "../text-renderer/text-renderer.h"
 #include "../text-renderer/TextShape.h"
 #include "../text-renderer/types.h"
 
 #include "../utils/utils.h"
 #include "../utils/Log.h"
+#include "../utils/ThreadPool.h"
 #include "../utils/fmt.h"
 
 #include "../vendor/fmt/core.h"
@@ -22,8 +25,10 @@
 
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace odtr {
@@ -36,34 +41,138 @@ compat::FRectangle convertRect(const odtr::FRectangle& r) {
     return compat::FRectangle{r.l, r.t, r.w, r.h};
 }
 
+/// Replaces the placed text of the text shape by the one of an identical text, shared by other text shapes.
+bool takeSharedPlacedText(ContextHandle ctx,
+                          TextShapeHandle textShape,
+                          const PlacedTextCache::Key& key)
+{
+    PlacedTextCache::PlacedTextPtr placedText = ctx->placedTextCache.find(key);
+    if (placedText == nullptr) {
+        return false;
+    }
+
+    // the retained paragraph shapes belong to the placed text of the text shape
+    if (placedText != textShape->data) {
+        textShape->data = std::move(placedText);
+        textShape->shapeData.reset();
+    }
+    textShape->dirty = false;
+    return true;
+}
+
+/// Reads the placed text of the input from the persistent cache, fills @a diskKey to store a newly shaped text under.
+TextShape::DataPtr findStoredPlacedText(ContextHandle ctx,
+                                        const priv::TextShapeInput& textShapeInput,
+                                        const FaceTable& faces,
+                                        std::optional<ContentHash>& diskKey)
+{
+    if (ctx->placedTextDiskCache == nullptr) {
+        return nullptr;
+    }
+
+    diskKey = PlacedTextDiskCache::makeKey(textShapeInput, ctx->config, faces);
+    return diskKey.has_value() ? ctx->placedTextDiskCache->find(*diskKey) : nullptr;
+}
+
+/// Calls @a draw with the faces of the context, or with a leased instance of them while another draw uses them.
+template <typename DrawFunction>
+auto drawWithFaces(ContextHandle ctx, const DrawFunction& draw)
+{
+    FontManager& fontManager = ctx->getFontManager();
+    if (const std::unique_lock<std::mutex> facesLock = fontManager.tryLockFacesTable()) {
+        return draw(fontManager.facesTable());
+    }
+
+    const FacesTableLease faces = fontManager.leaseFacesTable();
+    return draw(*faces);
+}
+
+DrawTextResult drawPlacedTextData(ContextHandle ctx,
+                                  const PlacedTextData& placedTextData,
+                                  void* pixels, int width, int height,
+                                  const DrawOptions& drawOptions)
+{
+    const compat::Rectangle viewArea = drawOptions.viewArea.has_value()
+        ? convertRect(drawOptions.viewArea.value())
+        : compat::INFINITE_BOUNDS;
+
+    const priv::TextDrawResult result = drawWithFaces(ctx, [&](const FaceTable& faces) {
+        return priv::drawPlacedText(*ctx,
+                                    faces,
+                                    placedTextData,
+                                    drawOptions.scale,
+                                    viewArea,
+                                    pixels, width, height);
+    });
+
+    if (result) {
+        const auto& drawOutput = result.value();
+        return {
+            utils::castRectangle(drawOutput.drawBounds), utils::castMatrix(drawOutput.transform),
+            false
+        };
+    }
+
+    return {{}, {}, true};
+}
+
 bool sanitizeShape(ContextHandle ctx,
                    TextShapeHandle textShape)
 {
     if (textShape->dirty) {
-        priv::PlacedTextResult placedShapeResult = priv::shapePlacedText(*ctx, *textShape->input);
+        const FaceTable& faces = ctx->getFontManager().facesTable();
+        const PlacedTextCache::Key key = PlacedTextCache::makeKey(*textShape->input, faces);
+        if (takeSharedPlacedText(ctx, textShape, key)) {
+            return true;
+        }
+
+        priv::TextShapeDataPtr shapeData;
+        priv::PlacedTextResult placedShapeResult = priv::shapePlacedText(*ctx, faces, *textShape->input, shapeData);
         if (!placedShapeResult) {
             ctx->getLogger().error("Text reshaping failed with error: {}", errorToString(placedShapeResult.error()));
             return false;
         }
 
         textShape->data = placedShapeResult.moveValue();
+        textShape->shapeData = std::move(shapeData);
         textShape->dirty = false;
+        ctx->placedTextCache.insert(key, textShape->data);
     }
     return true;
 }
 
+/// Reshapes a dirty shape, serialized with concurrent draw calls.
+bool lockAndSanitizeShape(ContextHandle ctx,
+                          TextShapeHandle textShape)
+{
+    std::lock_guard<std::mutex> lock(ctx->shapesMutex);
+    if (!textShape->dirty) {
+        return true;
+    }
+
+    // a concurrent draw may be using the faces
+    const std::unique_lock<std::mutex> facesLock = ctx->getFontManager().lockFacesTable();
+    return sanitizeShape(ctx, textShape);
+}
+
 }
 
 ContextHandle createContext(const ContextOptions& options)
 {
     auto logger = std::make_unique<utils::Log>(options.errorFunc, options.warnFunc, options.infoFunc);
-    auto fontManager = std::make_unique<FontManager>(*logger.get());
 
-    return new Context{
-        priv::Config{},
-        std::move(logger),
-        std::move(fontManager),
-    };
+    ContextHandle ctx = new Context(std::move(logger), options.glyphCacheBudget, options.shapingCacheBudget, options.threadCount, options.mapFontFiles);
+
+    if (!options.shapeCacheDirectory.empty()) {
+        auto diskCache = std::make_unique<PlacedTextDiskCache>(options.shapeCacheDirectory, options.shapeCacheDiskBudget);
+        if (diskCache->enabled()) {
+            ctx->placedTextDiskCache = std::move(diskCache);
+        } else {
+            ctx->getLogger().warn("Shape cache directory {} is not available.", options.shapeCacheDirectory);
+        }
+    }
+
+    return ctx;
 }
 
 void destroyContext(ContextHandle ctx)
@@ -90,10 +199,15 @@ bool addFontFile(ContextHandle ctx,
 
     auto result = ctx->fontManager->loadFaceFromFileAs(filename, postScriptName, inFontFaceName);
 
+    // faces might have been replaced
+    ctx->glyphCache.clear();
+    ctx->shapingCache.clear();
+
     for (const auto& shape : ctx->shapes) {
         for (const auto& face : facesToUpdate) {
             shape->onFontFaceChanged(face);
         }
+        shape->onFontFaceAdded(postScriptName);
     }
 
     return result;
@@ -118,10 +232,15 @@ bool addFontBytes(ContextHandle ctx,
     // TODO get rid of const_cast
     auto result = ctx->fontManager->loadFaceAs(postScriptName, postScriptName, inFontFaceName, BufferView(const_cast<std::uint8_t *>(data), length));
 
+    // faces might have been replaced
+    ctx->glyphCache.clear();
+    ctx->shapingCache.clear();
+
     for (const auto& shape : ctx->shapes) {
         for (const auto& face : facesToUpdate) {
             shape->onFontFaceChanged(face);
         }
+        shape->onFontFaceAdded(postScriptName);
     }
 
     return result;
@@ -152,16 +271,158 @@ TextShapeHandle shapeText(ContextHandle ctx,
         return nullptr;
     }
 
-    priv::PlacedTextResult placedShapeResult = priv::shapePlacedText(*ctx, *textShapeInput);
+    // identical texts share the placed text, only the first one is shaped
+    const FaceTable& faces = ctx->getFontManager().facesTable();
+    const PlacedTextCache::Key key = PlacedTextCache::makeKey(*textShapeInput, faces);
+    if (PlacedTextCache::PlacedTextPtr placedText = ctx->placedTextCache.find(key)) {
+        ctx->shapes.emplace_back(std::make_unique<TextShape>(std::move(textShapeInput), std::move(placedText)));
+        return ctx->shapes.back().get();
+    }
+
+    // a text shaped by an earlier context needs no shaping either
+    std::optional<ContentHash> diskKey;
+    if (TextShape::DataPtr placedText = findStoredPlacedText(ctx, *textShapeInput, faces, diskKey)) {
+        ctx->placedTextCache.insert(key, placedText);
+        ctx->shapes.emplace_back(std::make_unique<TextShape>(std::move(textShapeInput), std::move(placedText)));
+        return ctx->shapes.back().get();
+    }
+
+    priv::TextShapeDataPtr shapeData;
+    priv::PlacedTextResult placedShapeResult = priv::shapePlacedText(*ctx, faces, *textShapeInput, shapeData);
     if (!placedShapeResult) {
         ctx->getLogger().error("Text shaping failed with error: {}", errorToString(placedShapeResult.error()));
         return nullptr;
     }
 
     ctx->shapes.emplace_back(std::make_unique<TextShape>(std::move(textShapeInput), placedShapeResult.moveValue()));
+    ctx->shapes.back()->shapeData = std::move(shapeData);
+    ctx->placedTextCache.insert(key, ctx->shapes.back()->data);
+    if (diskKey.has_value()) {
+        ctx->placedTextDiskCache->insert(*diskKey, *ctx->shapes.back()->data);
+    }
     return ctx->shapes.back().get();
 }
 
+void shapeTexts(ContextHandle ctx,
+                const octopus::Text* texts,
+                size_t count,
+                TextShapeHandle* textShapes)
+{
+    if (ctx == nullptr) {
+        return;
+    }
+
+    std::vector<priv::TextShapeInputPtr> textShapeInputs(count);
+    std::vector<std::optional<PlacedTextCache::Key>> keys(count);
+    std::vector<TextShape::DataPtr> placedTexts(count);
+    std::vector<priv::TextShapeDataPtr> shapeDatas(count);
+
+    const auto preprocessSingleText = [ctx, texts, &textShapeInputs, &keys](size_t i, const FaceTable& faces) {
+        if (texts[i].value.empty()) {
+            return;
+        }
+
+        priv::TextShapeInputPtr textShapeInput = priv::preprocessText(*ctx, texts[i]);
+        if (textShapeInput == nullptr) {
+            ctx->getLogger().error("Text preprocessing failed.");
+            return;
+        }
+
+        keys[i] = PlacedTextCache::makeKey(*textShapeInput, faces);
+        textShapeInputs[i] = std::move(textShapeInput);
+    };
+
+    const auto shapeSingleText = [ctx, &textShapeInputs, &placedTexts, &shapeDatas](size_t i, const FaceTable& faces) {
+        std::optional<ContentHash> diskKey;
+        placedTexts[i] = findStoredPlacedText(ctx, *textShapeInputs[i], faces, diskKey);
+        if (placedTexts[i] != nullptr) {
+            return;
+        }
+
+        priv::PlacedTextResult placedShapeResult = priv::shapePlacedText(*ctx, faces, *textShapeInputs[i], shapeDatas[i]);
+        if (!placedShapeResult) {
+            ctx->getLogger().error("Text shaping failed with error: {}", errorToString(placedShapeResult.error()));
+            return;
+        }
+
+        placedTexts[i] = placedShapeResult.moveValue();
+        if (diskKey.has_value()) {
+            ctx->placedTextDiskCache->insert(*diskKey, *placedTexts[i]);
+        }
+    };
+
+    utils::ThreadPool* threadPool = ctx->getThreadPool();
+    if (threadPool) {
+        threadPool->parallelFor(count, [ctx, &preprocessSingleText](size_t i, size_t) {
+            preprocessSingleText(i, ctx->getFontManager().facesTable());
+        });
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            preprocessSingleText(i, ctx->getFontManager().facesTable());
+        }
+    }
+
+    // identical texts share the placed text, only the first one of them is shaped
+    std::vector<size_t> shapedIndices;
+    std::vector<size_t> firstIdentical(count);
+    std::unordered_multimap<std::size_t, size_t> shapedByHash;
+    for (size_t i = 0; i < count; ++i) {
+        if (!keys[i].has_value()) {
+            continue;
+        }
+        placedTexts[i] = ctx->placedTextCache.find(*keys[i]);
+        if (placedTexts[i] != nullptr) {
+            continue;
+        }
+
+        firstIdentical[i] = i;
+        const auto [first, last] = shapedByHash.equal_range(keys[i]->hash);
+        for (auto it = first; it != last; ++it) {
+            if (*keys[it->second] == *keys[i]) {
+                firstIdentical[i] = it->second;
+                break;
+            }
+        }
+        if (firstIdentical[i] == i) {
+            shapedByHash.emplace(keys[i]->hash, i);
+            shapedIndices.push_back(i);
+        }
+    }
+
+    if (threadPool) {
+        // each worker shapes with its own instances of the faces
+        threadPool->parallelFor(shapedIndices.size(), [ctx, &shapeSingleText, &shapedIndices](size_t i, size_t) {
+            const FacesTableLease faces = ctx->getFontManager().leaseFacesTable();
+            shapeSingleText(shapedIndices[i], *faces);
+        });
+    } else {
+        for (const size_t i : shapedIndices) {
+            shapeSingleText(i, ctx->getFontManager().facesTable());
+        }
+    }
+
+    for (const size_t i : shapedIndices) {
+        if (placedTexts[i] != nullptr) {
+            ctx->placedTextCache.insert(*keys[i], placedTexts[i]);
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        TextShape::DataPtr placedText = placedTexts[i];
+        if (placedText == nullptr && keys[i].has_value()) {
+            placedText = placedTexts[firstIdentical[i]];
+        }
+
+        if (placedText != nullptr) {
+            ctx->shapes.emplace_back(std::make_unique<TextShape>(std::move(textShapeInputs[i]), std::move(placedText)));
+            ctx->shapes.back()->shapeData = std::move(shapeDatas[i]);
+            textShapes[i] = ctx->shapes.back().get();
+        } else {
+            textShapes[i] = nullptr;
+        }
+    }
+}
+
 void destroyTextShapes(ContextHandle ctx,
                        TextShapeHandle* textShapes,
                        size_t count)
@@ -193,7 +454,31 @@ bool reshapeText(ContextHandle ctx,
         return false;
     }
 
-    priv::PlacedTextResult textShapeResult = priv::shapePlacedText(*ctx, *textShapeInput);
+    // another text shape may hold the same text already
+    const FaceTable &faces = ctx->getFontManager().facesTable();
+    const PlacedTextCache::Key key = PlacedTextCache::makeKey(*textShapeInput, faces);
+    if (takeSharedPlacedText(ctx, textShape, key)) {
+        textShape->input = std::move(textShapeInput);
+        return true;
+    }
+
+    // a change of colors, decorations or font sizes only doesn't require shaping
+    if (!textShape->dirty) {
+        if (priv::restylePlacedText(*ctx, faces, *textShape->input, *textShapeInput, textShape->shapeData, textShape->data)) {
+            textShape->input = std::move(textShapeInput);
+            ctx->placedTextCache.insert(key, textShape->data);
+            return true;
+        }
+        // the scaled glyphs only approximate a shaped text, so they are not shared with texts shaped later
+        if (priv::resizePlacedText(*ctx, faces, *textShape->input, *textShapeInput, textShape->shapeData, textShape->data)) {
+            textShape->input = std::move(textShapeInput);
+            return true;
+        }
+    }
+
+    // the paragraphs which didn't change since the last shaping are not shaped again
+    priv::TextShapeDataPtr shapeData = textShape->dirty ? nullptr : std::move(textShape->shapeData);
+    priv::PlacedTextResult textShapeResult = priv::shapePlacedText(*ctx, faces, *textShapeInput, shapeData);
     if (!textShapeResult) {
         ctx->getLogger().error("reshaping of a text failed with error: {}", (int)textShapeResult.error());
         return false;
@@ -201,6 +486,42 @@ bool reshapeText(ContextHandle ctx,
 
     textShape->input = std::move(textShapeInput);
     textShape->data = textShapeResult.moveValue();
+    textShape->shapeData = std::move(shapeData);
+    textShape->dirty = false;
+    ctx->placedTextCache.insert(key, textShape->data);
+    return true;
+}
+
+bool resizeTextFrame(ContextHandle ctx,
+                     TextShapeHandle textShape,
+                     float width,
+                     float height)
+{
+    if (ctx == nullptr || textShape == nullptr) {
+        return false;
+    }
+
+    textShape->input->frameSize = compat::Vector2f{width, height};
+
+    const FaceTable &faces = ctx->getFontManager().facesTable();
+    const PlacedTextCache::Key key = PlacedTextCache::makeKey(*textShape->input, faces);
+    if (takeSharedPlacedText(ctx, textShape, key)) {
+        return true;
+    }
+
+    // the glyphs shaped the last time are only broken into lines again
+    priv::TextShapeDataPtr shapeData = textShape->dirty ? nullptr : std::move(textShape->shapeData);
+    priv::PlacedTextResult textShapeResult = priv::reflowPlacedText(*ctx, faces, *textShape->input, shapeData);
+    if (!textShapeResult) {
+        ctx->getLogger().error("resizing of a text frame failed with error: {}", (int)textShapeResult.error());
+        textShape->dirty = true;
+        return false;
+    }
+
+    textShape->data = textShapeResult.moveValue();
+    textShape->shapeData = std::move(shapeData);
+    textShape->dirty = false;
+    ctx->placedTextCache.insert(key, textShape->data);
     return true;
 }
 
@@ -211,7 +532,7 @@ FRectangle getBounds(ContextHandle ctx,
         return {};
     }
 
-    if (textShape && sanitizeShape(ctx, textShape)) {
+    if (textShape && lockAndSanitizeShape(ctx, textShape)) {
         return utils::castFRectangle(convertRect(textShape->getData().textBounds));
     }
     return {};
@@ -239,7 +560,7 @@ Dimensions getDrawBufferDimensions(ContextHandle ctx,
         return {};
     }
 
-    if (textShape && sanitizeShape(ctx, textShape)) {
+    if (textShape && lockAndSanitizeShape(ctx, textShape)) {
         const compat::Rectangle viewArea = drawOptions.viewArea.has_value() ? convertRect(drawOptions.viewArea.value()) : compat::INFINITE_BOUNDS;
         const compat::Rectangle drawBounds = priv::computeDrawBounds(*ctx, textShape->getData(), drawOptions.scale, viewArea);
 
@@ -257,27 +578,79 @@ DrawTextResult drawText(ContextHandle ctx,
         return {{}, {}, true};
     }
 
-    if (textShape && sanitizeShape(ctx, textShape)) {
-        const compat::Rectangle viewArea = drawOptions.viewArea.has_value()
-            ? convertRect(drawOptions.viewArea.value())
-            : compat::INFINITE_BOUNDS;
+    if (textShape == nullptr) {
+        return {{}, {}, true};
+    }
+
+    if (lockAndSanitizeShape(ctx, textShape)) {
+        return drawPlacedTextData(ctx, textShape->getData(), pixels, width, height, drawOptions);
+    }
 
-        const priv::TextDrawResult result = priv::drawPlacedText(*ctx,
-                                                                 textShape->getData(),
-                                                                 drawOptions.scale,
-                                                                 viewArea,
-                                                                 pixels, width, height);
+    return {{}, {}, true};
+}
 
-        if (result) {
-            const auto& drawOutput = result.value();
-            return {
-                utils::castRectangle(drawOutput.drawBounds), utils::castMatrix(drawOutput.transform),
-                false
-            };
+void drawTexts(ContextHandle ctx,
+               const DrawJob* jobs,
+               size_t count,
+               DrawTextResult* results)
+{
+    if (ctx == nullptr) {
+        return;
+    }
+
+    // reshaping modifies the context, so it must not happen in parallel
+    std::vector<bool> valid(count);
+    {
+        std::lock_guard<std::mutex> lock(ctx->shapesMutex);
+        const std::unique_lock<std::mutex> facesLock = ctx->getFontManager().lockFacesTable();
+        for (size_t i = 0; i < count; ++i) {
+            valid[i] = jobs[i].textShape && sanitizeShape(ctx, jobs[i].textShape);
         }
     }
 
-    return {{}, {}, true};
+    const auto drawSingleText = [ctx, jobs, results, &valid](size_t i, const FaceTable& faces) {
+        const DrawJob& job = jobs[i];
+        DrawTextResult drawResult {{}, {}, true};
+
+        if (valid[i]) {
+            const compat::Rectangle viewArea = job.drawOptions.viewArea.has_value()
+                ? convertRect(job.drawOptions.viewArea.value())
+                : compat::INFINITE_BOUNDS;
+
+            const priv::TextDrawResult result = priv::drawPlacedText(*ctx,
+                                                                     faces,
+                                                                     job.textShape->getData(),
+                                                                     job.drawOptions.scale,
+                                                                     viewArea,
+                                                                     job.pixels, job.width, job.height);
+
+            if (result) {
+                const auto& drawOutput = result.value();
+                drawResult = {
+                    utils::castRectangle(drawOutput.drawBounds), utils::castMatrix(drawOutput.transform),
+                    false
+                };
+            }
+        }
+
+        if (results) {
+            results[i] = drawResult;
+        }
+    };
+
+    if (utils::ThreadPool* threadPool = ctx->getThreadPool()) {
+        // each worker draws with its own instances of the faces, the glyph cache is shared
+        threadPool->parallelFor(count, [ctx, &drawSingleText](size_t i, size_t) {
+            const FacesTableLease faces = ctx->getFontManager().leaseFacesTable();
+            drawSingleText(i, *faces);
+        });
+    } else {
+        drawWithFaces(ctx, [count, &drawSingleText](const FaceTable& faces) {
+            for (size_t i = 0; i < count; ++i) {
+                drawSingleText(i, faces);
+            }
+        });
+    }
 }
 
 const PlacedTextData *getShapedText(ContextHandle ctx,
@@ -286,12 +659,64 @@ const PlacedTextData *getShapedText(ContextHandle ctx,
         return nullptr;
     }
 
-    if (textShape && sanitizeShape(ctx, textShape) && textShape->data != nullptr) {
+    if (textShape && lockAndSanitizeShape(ctx, textShape) && textShape->data != nullptr) {
         return textShape->data.get();
     }
     return nullptr;
 }
 
+std::vector<std::uint8_t> serializeShapedText(ContextHandle ctx,
+                                              TextShapeHandle textShape,
+                                              bool compress) {
+    if (ctx == nullptr) {
+        return {};
+    }
+
+    if (textShape && lockAndSanitizeShape(ctx, textShape)) {
+        return priv::serializePlacedText(textShape->getData(), compress);
+    }
+    return {};
+}
+
+std::unique_ptr<PlacedTextData> deserializeShapedText(ContextHandle ctx,
+                                                      const std::uint8_t* data,
+                                                      size_t length) {
+    if (ctx == nullptr) {
+        return nullptr;
+    }
+
+    priv::PlacedTextDeserializeResult result = priv::deserializePlacedText(data, length);
+    if (!result) {
+        ctx->getLogger().error("Shaped text deserialization failed with error: {}", errorToString(result.error()));
+        return nullptr;
+    }
+    return result.moveValue();
+}
+
+Dimensions getDrawBufferDimensions(ContextHandle ctx,
+                                   const PlacedTextData& shapedText,
+                                   const DrawOptions& drawOptions) {
+    if (ctx == nullptr) {
+        return {};
+    }
+
+    const compat::Rectangle viewArea = drawOptions.viewArea.has_value() ? convertRect(drawOptions.viewArea.value()) : compat::INFINITE_BOUNDS;
+    const compat::Rectangle drawBounds = priv::computeDrawBounds(*ctx, shapedText, drawOptions.scale, viewArea);
+
+    return { drawBounds.w, drawBounds.h };
+}
+
+DrawTextResult drawShapedText(ContextHandle ctx,
+                              const PlacedTextData& shapedText,
+                              void* pixels, int width, int height,
+                              const DrawOptions& drawOptions) {
+    if (ctx == nullptr) {
+        return {{}, {}, true};
+    }
+
+    return drawPlacedTextData(ctx, shapedText, pixels, width, height, drawOptions);
+}
+
 bool isColorFont(ContextHandle ctx,
                  const std::string &faceId) {
     if (ctx == nullptr) {
@@ -304,6 +729,32 @@ bool isColorFont(ContextHandle ctx,
     return faceItem->face->isColorFont();
 }
 
+CacheStatistics getGlyphCacheStatistics(ContextHandle ctx) {
+    if (ctx == nullptr) {
+        return {};
+    }
+
+    const GlyphCache::Statistics stats = ctx->glyphCache.statistics();
+    return { stats.hits, stats.misses, stats.evictions, stats.entries, stats.bytes };
+}
+
+CacheStatistics getShapingCacheStatistics(ContextHandle ctx) {
+    if (ctx == nullptr) {
+        return {};
+    }
+
+    const ShapingCache::Statistics stats = ctx->shapingCache.statistics();
+    return { stats.hits, stats.misses, stats.evictions, stats.entries, stats.bytes };
+}
+
+CacheStatistics getShapeDiskCacheStatistics(ContextHandle ctx) {
+    if (ctx == nullptr || ctx->placedTextDiskCache == nullptr) {
+        return {};
+    }
+
+    const PlacedTextDiskCache::Statistics stats = ctx->placedTextDiskCache->statistics();
+    return { stats.hits, stats.misses, stats.evictions, stats.entries, stats.bytes };
+}
 
 FT_Face getFreetypeFace(ContextHandle ctx,
                         const std::string& faceId) {
@@ -0,0 +1,60 @@
+#include "content_hash.h"
+
+#include <cstring>
+
+ContentHasher::ContentHasher()
+{
+    crypto_blake2b_general_init(&ctx_, std::tuple_size<ContentHash>::value, nullptr, 0);
+}
+
+ContentHasher& ContentHasher::add(const void* data, std::size_t size)
+{
+    crypto_blake2b_update(&ctx_, static_cast<const std::uint8_t*>(data), size);
+    return *this;
+}
+
+ContentHasher& ContentHasher::add(std::uint64_t value)
+{
+    std::uint8_t bytes[8];
+    for (int i = 0; i < 8; ++i) {
+        bytes[i] = static_cast<std::uint8_t>(value >> (8 * i));
+    }
+    return add(bytes, sizeof(bytes));
+}
+
+ContentHasher& ContentHasher::add(float value)
+{
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return add(static_cast<std::uint64_t>(bits));
+}
+
+ContentHasher& ContentHasher::add(const std::string& value)
+{
+    add(static_cast<std::uint64_t>(value.size()));
+    return add(value.data(), value.size());
+}
+
+ContentHash ContentHasher::finish()
+{
+    ContentHash hash;
+    crypto_blake2b_final(&ctx_, hash.data());
+    return hash;
+}
+
+ContentHash hashContent(const void* data, std::size_t size)
+{
+    return ContentHasher().add(data, size).finish();
+}
+
+std::string toHexString(const ContentHash& hash)
+{
+    static const char digits[] = "0123456789abcdef";
+
+    std::string result(2 * hash.size(), '0');
+    for (std::size_t i = 0; i < hash.size(); ++i) {
+        result[2 * i] = digits[hash[i] >> 4];
+        result[2 * i + 1] = digits[hash[i] & 0x0f];
+    }
+    return result;
+}
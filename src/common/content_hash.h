@@ -0,0 +1,41 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+extern "C" {
+#include "../vendor/monocypher/monocypher.h"
+}
+
+/// 256-bit BLAKE2b digest identifying a content, e.g. font data or a text shaping input.
+using ContentHash = std::array<std::uint8_t, 32>;
+
+/**
+ * Incremental BLAKE2b hashing of a content.
+ *
+ * Numbers are added in little-endian order, strings are prefixed by their length,
+ * so that the digest only depends on the values and not the platform.
+ */
+class ContentHasher
+{
+public:
+    ContentHasher();
+
+    ContentHasher& add(const void* data, std::size_t size);
+    ContentHasher& add(std::uint64_t value);
+    ContentHasher& add(float value);
+    ContentHasher& add(const std::string& value);
+
+    ContentHash finish();
+
+private:
+    crypto_blake2b_ctx ctx_;
+};
+
+/// Computes the digest of a buffer.
+ContentHash hashContent(const void* data, std::size_t size);
+
+/// Lowercase hexadecimal representation of the digest.
+std::string toHexString(const ContentHash& hash);
@@ -0,0 +1,306 @@
+#include "blend-ops.h"
+
+#include "pixel-conversion.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ODTR_BLEND_SSE2
+#endif
+
+namespace odtr {
+namespace compat {
+
+/*
+ * Fixed point formulation of the source-over operator (all values 0 .. 255):
+ *
+ *   mask:  out = (C*A*m + D*(255*255 - A*m)) / (255*255)
+ *   color: out = S + D*(255 - Sa) / 255
+ *
+ * where C, A is the tint color and its alpha, m the mask coverage, S, Sa the premultiplied
+ * source pixel and its alpha and D the destination. Both products of the mask formula are
+ * divided by 255 using a 16-bit multiply-high by 257 and the sum is rounded by div255, so that
+ * every intermediate value fits a 16-bit lane.
+ */
+
+namespace {
+
+constexpr std::uint32_t ONE_SQUARED = 255u * 255u;
+
+/// Rounded division by 255, exact for x <= 65535 - 128.
+inline std::uint32_t div255(std::uint32_t x) {
+    x += 128u;
+    return (x + (x >> 8)) >> 8;
+}
+
+struct MaskColor
+{
+    /// Color channels premultiplied by alpha, scaled by 255 (R*A, G*A, B*A, 255*A).
+    std::uint32_t c[4];
+    std::uint32_t alpha;
+};
+
+MaskColor prepareMaskColor(Pixel32 color) {
+    const std::uint32_t a = color >> 24 & 0xffu;
+    return MaskColor {
+        {
+            (color & 0xffu) * a,
+            (color >> 8 & 0xffu) * a,
+            (color >> 16 & 0xffu) * a,
+            255u * a,
+        },
+        a
+    };
+}
+
+inline Pixel32 blendMaskPixel(Pixel32 d, std::uint32_t m, const MaskColor& color) {
+    const std::uint32_t m257 = m * 257u;
+    const std::uint32_t w = ONE_SQUARED - color.alpha * m;
+    Pixel32 result = 0u;
+    for (int i = 0; i < 4; ++i) {
+        const std::uint32_t dc = d >> (8 * i) & 0xffu;
+        const std::uint32_t sum = ((color.c[i] * m257) >> 16) + ((w * (dc * 257u)) >> 16);
+        result |= div255(sum) << (8 * i);
+    }
+    return result;
+}
+
+inline Pixel32 blendPremultipliedPixel(Pixel32 d, Pixel32 s) {
+    const std::uint32_t ia = 255u - (s >> 24);
+    Pixel32 result = 0u;
+    for (int i = 0; i < 4; ++i) {
+        const std::uint32_t dc = d >> (8 * i) & 0xffu;
+        const std::uint32_t sc = s >> (8 * i) & 0xffu;
+        const std::uint32_t v = sc + div255(dc * ia);
+        result |= (v > 255u ? 255u : v) << (8 * i);
+    }
+    return result;
+}
+
+#if defined(__AVX2__)
+
+inline __m256i div255(__m256i x) {
+    x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+/// Blends 4 pixels, all operands are 16-bit lanes.
+inline __m256i blendMask4(__m256i d, __m256i m, __m256i c, __m256i a) {
+    const __m256i m257 = _mm256_mullo_epi16(m, _mm256_set1_epi16(257));
+    const __m256i w = _mm256_sub_epi16(_mm256_set1_epi16(static_cast<short>(ONE_SQUARED)), _mm256_mullo_epi16(a, m));
+    const __m256i src = _mm256_mulhi_epu16(c, m257);
+    const __m256i dst = _mm256_mulhi_epu16(w, _mm256_mullo_epi16(d, _mm256_set1_epi16(257)));
+    return div255(_mm256_add_epi16(src, dst));
+}
+
+void blendMaskRow(Pixel32* dst, const Pixel8* mask, int width, const MaskColor& color) {
+    const __m256i c = _mm256_setr_epi16(
+        static_cast<short>(color.c[0]), static_cast<short>(color.c[1]), static_cast<short>(color.c[2]), static_cast<short>(color.c[3]),
+        static_cast<short>(color.c[0]), static_cast<short>(color.c[1]), static_cast<short>(color.c[2]), static_cast<short>(color.c[3]),
+        static_cast<short>(color.c[0]), static_cast<short>(color.c[1]), static_cast<short>(color.c[2]), static_cast<short>(color.c[3]),
+        static_cast<short>(color.c[0]), static_cast<short>(color.c[1]), static_cast<short>(color.c[2]), static_cast<short>(color.c[3]));
+    const __m256i a = _mm256_set1_epi16(static_cast<short>(color.alpha));
+
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const __m128i m8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(mask + x));
+        const __m128i m2 = _mm_unpacklo_epi8(m8, m8);
+        const __m256i mLo = _mm256_cvtepu8_epi16(_mm_unpacklo_epi16(m2, m2));
+        const __m256i mHi = _mm256_cvtepu8_epi16(_mm_unpackhi_epi16(m2, m2));
+
+        const __m256i dLo = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + x)));
+        const __m256i dHi = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + x + 4)));
+
+        const __m256i packed = _mm256_packus_epi16(blendMask4(dLo, mLo, c, a), blendMask4(dHi, mHi, c, a));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), _mm256_permute4x64_epi64(packed, 0xd8));
+    }
+    for (; x < width; ++x) {
+        dst[x] = blendMaskPixel(dst[x], mask[x], color);
+    }
+}
+
+/// Blends 4 pixels, all operands are 16-bit lanes.
+inline __m256i blendPremultiplied4(__m256i d, __m256i s) {
+    const __m256i sa = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, 0xff), 0xff);
+    return div255(_mm256_mullo_epi16(d, _mm256_sub_epi16(_mm256_set1_epi16(255), sa)));
+}
+
+void blendPremultipliedRow(Pixel32* dst, const Pixel32* src, int width) {
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const __m128i sLo8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+        const __m128i sHi8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x + 4));
+        const __m256i dLo = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + x)));
+        const __m256i dHi = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + x + 4)));
+
+        const __m256i packed = _mm256_packus_epi16(
+            blendPremultiplied4(dLo, _mm256_cvtepu8_epi16(sLo8)),
+            blendPremultiplied4(dHi, _mm256_cvtepu8_epi16(sHi8)));
+        const __m256i scaledDst = _mm256_permute4x64_epi64(packed, 0xd8);
+        const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), _mm256_adds_epu8(s, scaledDst));
+    }
+    for (; x < width; ++x) {
+        dst[x] = blendPremultipliedPixel(dst[x], src[x]);
+    }
+}
+
+#elif defined(ODTR_BLEND_SSE2)
+
+inline __m128i div255(__m128i x) {
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+/// Blends 2 pixels, all operands are 16-bit lanes.
+inline __m128i blendMask2(__m128i d, __m128i m, __m128i c, __m128i a) {
+    const __m128i m257 = _mm_mullo_epi16(m, _mm_set1_epi16(257));
+    const __m128i w = _mm_sub_epi16(_mm_set1_epi16(static_cast<short>(ONE_SQUARED)), _mm_mullo_epi16(a, m));
+    const __m128i src = _mm_mulhi_epu16(c, m257);
+    const __m128i dst = _mm_mulhi_epu16(w, _mm_mullo_epi16(d, _mm_set1_epi16(257)));
+    return div255(_mm_add_epi16(src, dst));
+}
+
+void blendMaskRow(Pixel32* dst, const Pixel8* mask, int width, const MaskColor& color) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c = _mm_setr_epi16(
+        static_cast<short>(color.c[0]), static_cast<short>(color.c[1]), static_cast<short>(color.c[2]), static_cast<short>(color.c[3]),
+        static_cast<short>(color.c[0]), static_cast<short>(color.c[1]), static_cast<short>(color.c[2]), static_cast<short>(color.c[3]));
+    const __m128i a = _mm_set1_epi16(static_cast<short>(color.alpha));
+
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        std::int32_t m4;
+        std::memcpy(&m4, mask + x, sizeof(m4));
+        const __m128i m1 = _mm_cvtsi32_si128(m4);
+        const __m128i m2 = _mm_unpacklo_epi8(m1, m1);
+        const __m128i m = _mm_unpacklo_epi16(m2, m2);
+
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + x));
+
+        const __m128i lo = blendMask2(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(m, zero), c, a);
+        const __m128i hi = blendMask2(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(m, zero), c, a);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(lo, hi));
+    }
+    for (; x < width; ++x) {
+        dst[x] = blendMaskPixel(dst[x], mask[x], color);
+    }
+}
+
+/// Blends 2 pixels, all operands are 16-bit lanes.
+inline __m128i blendPremultiplied2(__m128i d, __m128i s) {
+    const __m128i sa = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xff), 0xff);
+    return div255(_mm_mullo_epi16(d, _mm_sub_epi16(_mm_set1_epi16(255), sa)));
+}
+
+void blendPremultipliedRow(Pixel32* dst, const Pixel32* src, int width) {
+    const __m128i zero = _mm_setzero_si128();
+
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + x));
+
+        const __m128i lo = blendPremultiplied2(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(s, zero));
+        const __m128i hi = blendPremultiplied2(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(s, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_adds_epu8(s, _mm_packus_epi16(lo, hi)));
+    }
+    for (; x < width; ++x) {
+        dst[x] = blendPremultipliedPixel(dst[x], src[x]);
+    }
+}
+
+#else
+
+void blendMaskRow(Pixel32* dst, const Pixel8* mask, int width, const MaskColor& color) {
+    for (int x = 0; x < width; ++x) {
+        if (mask[x]) {
+            dst[x] = blendMaskPixel(dst[x], mask[x], color);
+        }
+    }
+}
+
+void blendPremultipliedRow(Pixel32* dst, const Pixel32* src, int width) {
+    for (int x = 0; x < width; ++x) {
+        if (src[x]) {
+            dst[x] = blendPremultipliedPixel(dst[x], src[x]);
+        }
+    }
+}
+
+#endif
+
+} // namespace
+
+void blendMask(Pixel32* dst, int dstStride,
+               const Pixel8* mask, int maskStride,
+               int width, int height,
+               Pixel32 color) {
+    const MaskColor maskColor = prepareMaskColor(color);
+    for (int y = 0; y < height; ++y, dst += dstStride, mask += maskStride) {
+        blendMaskRow(dst, mask, width, maskColor);
+    }
+}
+
+void blendPremultiplied(Pixel32* dst, int dstStride,
+                        const Pixel32* src, int srcStride,
+                        int width, int height) {
+    for (int y = 0; y < height; ++y, dst += dstStride, src += srcStride) {
+        blendPremultipliedRow(dst, src, width);
+    }
+}
+
+void blendMaskReference(Pixel32* dst, int dstStride,
+                        const Pixel8* mask, int maskStride,
+                        int width, int height,
+                        Pixel32 color) {
+    Color premultipliedColor = pixelToColor(color);
+    premultipliedColor.r *= premultipliedColor.a;
+    premultipliedColor.g *= premultipliedColor.a;
+    premultipliedColor.b *= premultipliedColor.a;
+
+    for (int y = 0; y < height; ++y, dst += dstStride, mask += maskStride) {
+        for (int x = 0; x < width; ++x) {
+            const float letterAlpha = mask[x] / 255.f;
+            Color srcColor = premultipliedColor;
+            srcColor.r *= letterAlpha;
+            srcColor.g *= letterAlpha;
+            srcColor.b *= letterAlpha;
+            srcColor.a *= letterAlpha;
+
+            Color dstColor = pixelToColor(dst[x]);
+            dstColor.r *= 1 - srcColor.a;
+            dstColor.g *= 1 - srcColor.a;
+            dstColor.b *= 1 - srcColor.a;
+            dstColor.a *= 1 - srcColor.a;
+
+            dst[x] = colorToPixel(srcColor + dstColor);
+        }
+    }
+}
+
+void blendPremultipliedReference(Pixel32* dst, int dstStride,
+                                 const Pixel32* src, int srcStride,
+                                 int width, int height) {
+    for (int y = 0; y < height; ++y, dst += dstStride, src += srcStride) {
+        for (int x = 0; x < width; ++x) {
+            // color glyphs are already alpha premultiplied
+            const Color srcColor = pixelToColor(src[x]);
+
+            Color dstColor = pixelToColor(dst[x]);
+            dstColor.r *= 1 - srcColor.a;
+            dstColor.g *= 1 - srcColor.a;
+            dstColor.b *= 1 - srcColor.a;
+            dstColor.a *= 1 - srcColor.a;
+
+            dst[x] = colorToPixel(srcColor + dstColor);
+        }
+    }
+}
+
+} // namespace compat
+} // namespace odtr
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "basic-types.h"
+
+namespace odtr {
+namespace compat {
+
+/**
+ * Source-over blending of an 8-bit coverage mask tinted by @a color (straight alpha) onto premultiplied RGBA pixels.
+ *
+ * Uses 8-bit fixed point arithmetic, vectorized with AVX2 or SSE2 when available. The result differs from
+ * blendMaskReference by at most 1 per channel. Strides are in pixels, the area must be already clipped.
+ */
+void blendMask(Pixel32* dst, int dstStride,
+               const Pixel8* mask, int maskStride,
+               int width, int height,
+               Pixel32 color);
+
+/**
+ * Source-over blending of premultiplied RGBA pixels onto premultiplied RGBA pixels.
+ *
+ * Uses 8-bit fixed point arithmetic, vectorized with AVX2 or SSE2 when available. The result differs from
+ * blendPremultipliedReference by at most 1 per channel. Strides are in pixels, the area must be already clipped.
+ */
+void blendPremultiplied(Pixel32* dst, int dstStride,
+                        const Pixel32* src, int srcStride,
+                        int width, int height);
+
+/// Floating point reference implementation of blendMask.
+void blendMaskReference(Pixel32* dst, int dstStride,
+                        const Pixel8* mask, int maskStride,
+                        int width, int height,
+                        Pixel32 color);
+
+/// Floating point reference implementation of blendPremultiplied.
+void blendPremultipliedReference(Pixel32* dst, int dstStride,
+                                 const Pixel32* src, int srcStride,
+                                 int width, int height);
+
+} // namespace compat
+} // namespace odtr
@@ -52,33 +52,36 @@ void FaceTable::initialize(FreetypeHandle& ft)
 }
 
 FaceTable::LoadFaceAsResult FaceTable::loadFace(const std::string& storageKey, const std::string& faceKey,
-                                                const std::string& faceName, BufferView fontData)
+                                                const std::string& faceName, const FontStorage::ContentPtr& fontData)
 {
-    FT_FaceHandle faceHandle(ft_, fontData);
+    const BufferView data = fontData->view();
+    FT_FaceHandle faceHandle(ft_, data);
     if (!faceHandle) {
         return false;
     }
 
     for (auto faceIdx = 0; faceIdx < faceHandle->num_faces; ++faceIdx) {
-        FacePtr facePtr(new Face(*ft_, fontData.data(), static_cast<int>(fontData.size()), faceIdx));
-        const auto& origName = facePtr->getPostScriptName();
+        FacePtr facePtr = acquireFace(data, faceIdx);
+        const std::string origName = facePtr->getPostScriptName();
 
         if (origName == faceName || faceName.empty()) {
             const auto& key = faceKey.empty() ? origName : faceKey;
-            if (!loadItem(key, {facePtr, storageKey, false})) {
+            if (!loadItem(key, {facePtr, storageKey, false, 0, fontData})) {
                 return false;
             }
             return LoadFaceAsResultRec{origName, key};
         }
+        discardUnusedFace(facePtr);
     }
 
     return false;
 }
 
 
-FacesNames FaceTable::loadFaces(const std::string& storageKey, const FacesNames& faces, BufferView fontData)
+FacesNames FaceTable::loadFaces(const std::string& storageKey, const FacesNames& faces, const FontStorage::ContentPtr& fontData)
 {
-    FT_FaceHandle faceHandle(ft_, fontData);
+    const BufferView data = fontData->view();
+    FT_FaceHandle faceHandle(ft_, data);
     if (!faceHandle) {
         return {};
     }
@@ -86,59 +89,109 @@ FacesNames FaceTable::loadFaces(const std::string& storageKey, const FacesNames&
     FacesNames loadedNames;
 
     for (auto faceIdx = 0; faceIdx < faceHandle->num_faces; ++faceIdx) {
-        FacePtr facePtr(new Face(*ft_, fontData.data(), static_cast<int>(fontData.size()), faceIdx));
-        const auto& name = facePtr->getPostScriptName();
+        FacePtr facePtr = acquireFace(data, faceIdx);
+        const std::string name = facePtr->getPostScriptName();
 
-        if(wantFace(faces, name) && loadItem(name, {facePtr, storageKey, false})) {
+        if(wantFace(faces, name) && loadItem(name, {facePtr, storageKey, false, 0, fontData})) {
             loadedNames.push_back(name);
         }
+        discardUnusedFace(facePtr);
     }
 
     return loadedNames;
 }
 
-FacesNames FaceTable::loadAllFaces(const std::string& storageKey, BufferView fontData) {
+FacesNames FaceTable::loadAllFaces(const std::string& storageKey, const FontStorage::ContentPtr& fontData) {
     return loadFaces(storageKey, {}, fontData);
 }
 
+void FaceTable::loadInstancesOf(const FaceTable& original)
+{
+    discardFaces();
+    ft_ = original.ft_;
+
+    // the same handles as in the original
+    faceHandles_ = original.faceHandles_;
+    loadedItems_ = original.loadedItems_;
+    faceItems_.resize(original.faceItems_.size());
+
+    // the names sharing a face share its instance too
+    std::unordered_map<const Face*, FacePtr> instances;
+    for (std::size_t i = 0; i < original.faceItems_.size(); ++i) {
+        const Item& faceRec = original.faceItems_[i];
+
+        if (faceRec.face != nullptr) {
+            FacePtr& facePtr = instances[faceRec.face];
+            if (facePtr == nullptr) {
+                facePtr = FacePtr(new Face(*ft_, *faceRec.face));
+            }
+            faceItems_[i] = {facePtr, faceRec.storageKey, faceRec.fallback, faceRec.generation, faceRec.fontData};
+            ++faceUsers_[facePtr];
+        }
+    }
+}
+
 void FaceTable::unloadFacesByStorageKey(const std::string& storageKey)
 {
-    for (auto it = std::begin(faceItems_); it != std::end(faceItems_); ++it) {
-        if (it->second.storageKey == storageKey) {
-            it->second.face.destroy();
+    for (Item& item : faceItems_) {
+        if (item.face != nullptr && item.storageKey == storageKey) {
+            releaseFace(item.face);
+            item = Item {};
         }
-        it = faceItems_.erase(it);
     }
 }
 
 void FaceTable::discardFaces()
 {
-    for (auto& item : faceItems_)
-        item.second.face.destroy();
-    faceItems_.clear();
+    for (Item& item : faceItems_) {
+        releaseFace(item.face);
+        item = Item {};
+    }
 }
 
 bool FaceTable::exists(const std::string& name) const
 {
-    return faceItems_.find(name) != std::end(faceItems_);
+    return getFaceItem(name) != nullptr;
 }
 
 const FaceTable::Item* FaceTable::getFaceItem(const std::string& name) const
 {
-    auto it = faceItems_.find(name);
-    if (it == std::end(faceItems_)) {
+    return getFaceItem(getFaceHandle(name));
+}
+
+FaceHandle FaceTable::getFaceHandle(const std::string& name) const
+{
+    auto it = faceHandles_.find(name);
+    if (it == std::end(faceHandles_)) {
+        return INVALID_FACE_HANDLE;
+    }
+
+    return it->second;
+}
+
+const FaceTable::Item* FaceTable::getFaceItem(FaceHandle handle) const
+{
+    if (handle >= faceItems_.size() || faceItems_[handle].face == nullptr) {
         return nullptr;
     }
 
-    return &it->second;
+    return &faceItems_[handle];
+}
+
+std::size_t FaceTable::getFaceGeneration(const std::string& name) const
+{
+    const Item* item = getFaceItem(name);
+    return item != nullptr ? item->generation : 0;
 }
 
 FacesNames FaceTable::listAllFacesNames() const
 {
     FacesNames fontNames;
 
-    for (const auto& item : faceItems_) {
-        fontNames.push_back(item.first);
+    for (const auto& [faceName, handle] : faceHandles_) {
+        if (faceItems_[handle].face != nullptr) {
+            fontNames.push_back(faceName);
+        }
     }
 
     return fontNames;
@@ -148,10 +201,10 @@ FacesNames FaceTable::listFacesInStorage(const std::string& storageKey) const
 {
     FacesNames fontNames;
 
-    for (const auto& item : faceItems_) {
-        const auto& [faceName, faceRec] = item;
+    for (const auto& [faceName, handle] : faceHandles_) {
+        const Item& faceRec = faceItems_[handle];
 
-        if (faceRec.storageKey == storageKey) {
+        if (faceRec.face != nullptr && faceRec.storageKey == storageKey) {
             fontNames.push_back(faceName);
         }
     }
@@ -161,13 +214,46 @@ FacesNames FaceTable::listFacesInStorage(const std::string& storageKey) const
 
 bool FaceTable::loadItem(const std::string& name, Item item)
 {
-    auto oldItemIt = faceItems_.find(name);
-    if (oldItemIt != std::end(faceItems_)) {
-        oldItemIt->second.face.destroy();
+    const auto [it, inserted] = faceHandles_.emplace(name, static_cast<FaceHandle>(faceItems_.size()));
+    if (inserted) {
+        faceItems_.emplace_back();
     }
 
-    faceItems_[name] = item;
+    // the face may be the one loaded under the name already
+    ++faceUsers_[item.face];
+
+    Item& faceRec = faceItems_[it->second];
+    releaseFace(faceRec.face);
+    faceRec = item;
+    faceRec.generation = ++loadedItems_;
 
     return item.face->ready();
 }
+
+FacePtr FaceTable::acquireFace(BufferView fontData, FT_Long faceIndex)
+{
+    for (const Item& item : faceItems_) {
+        if (item.face != nullptr && item.face->isLoadedFrom(fontData.data(), static_cast<int>(fontData.size()), faceIndex)) {
+            return item.face;
+        }
+    }
+
+    return FacePtr(new Face(*ft_, fontData.data(), static_cast<int>(fontData.size()), faceIndex));
+}
+
+void FaceTable::releaseFace(FacePtr face)
+{
+    const auto it = faceUsers_.find(face);
+    if (it != faceUsers_.end() && --it->second == 0) {
+        faceUsers_.erase(it);
+        face.destroy();
+    }
+}
+
+void FaceTable::discardUnusedFace(FacePtr face)
+{
+    if (faceUsers_.find(face) == faceUsers_.end()) {
+        face.destroy();
+    }
+}
 } // namespace odtr
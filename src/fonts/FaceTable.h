@@ -1,16 +1,25 @@
 #pragma once
 
+#include "FontStorage.h"
+
 #include "../text-renderer/Face.h"
 
 #include "../common/buffer_view.h"
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace odtr {
 
 /**
  * A table containing FreeType faces
+ *
+ * Each face name gets a handle when first loaded, which stays the same for the lifetime of the table,
+ * even if the face gets unloaded or replaced. Instances of the table keep the handles of the original.
+ *
+ * Names loaded from the same face of the same font data share a single Face, with its FreeType and HarfBuzz objects
+ * and OpenType features. FontStorage stores equal font data once, so this holds for data stored under different keys.
  */
 class FaceTable
 {
@@ -20,6 +29,10 @@ public:
         FacePtr face;
         std::string storageKey;
         bool fallback;
+        /// Distinguishes the faces loaded under the same name, see getFaceGeneration.
+        std::size_t generation = 0;
+        /// Font data of the face, kept alive while the face is loaded even if other data gets stored under the storage key.
+        FontStorage::ContentPtr fontData;
     };
 
     FaceTable() = default;
@@ -52,10 +65,16 @@ public:
      * @return  @a LoadFaceAsResult
      */
     LoadFaceAsResult loadFace(const std::string& storageKey, const std::string& faceKey,
-                              const std::string& faceName, BufferView fontData);
+                              const std::string& faceName, const FontStorage::ContentPtr& fontData);
+
+    FacesNames loadFaces(const std::string& storageKey, const FacesNames& faces, const FontStorage::ContentPtr& fontData);
+    FacesNames loadAllFaces(const std::string& storageKey, const FontStorage::ContentPtr& fontData);
 
-    FacesNames loadFaces(const std::string& storageKey, const FacesNames& faces, BufferView fontData);
-    FacesNames loadAllFaces(const std::string& storageKey, BufferView fontData);
+    /**
+     * Fills the table with new instances of all the faces in @a original, see Face::Face(FT_Library, const Face&).
+     * Faces must not be shared by multiple threads, each thread can use its own instance of the table.
+     */
+    void loadInstancesOf(const FaceTable& original);
 
     void unloadFacesByStorageKey(const std::string& storageKey);
 
@@ -63,16 +82,33 @@ public:
     bool exists(const std::string& name) const;
     const Item* getFaceItem(const std::string& name) const;
 
+    /// Returns the handle of the face, or INVALID_FACE_HANDLE if it was never loaded.
+    FaceHandle getFaceHandle(const std::string& name) const;
+    /// Returns the item of a loaded face, or null.
+    const Item* getFaceItem(FaceHandle handle) const;
+    /// Returns a number which changes whenever a face gets loaded under the name, 0 if no face is loaded.
+    std::size_t getFaceGeneration(const std::string& name) const;
+
     FacesNames listAllFacesNames() const;
     FacesNames listFacesInStorage(const std::string& storageKey) const;
 
 private:
     bool loadItem(const std::string& name, Item item);
 
-    using TableType = std::unordered_map<std::string, Item>;
+    /// Returns the loaded face of the font data and index, or creates a new one.
+    FacePtr acquireFace(BufferView fontData, FT_Long faceIndex);
+    /// Destroys the face once no item holds it.
+    void releaseFace(FacePtr face);
+    /// Destroys a face acquired but not loaded under any name.
+    void discardUnusedFace(FacePtr face);
+
+    using HandleTable = std::unordered_map<std::string, FaceHandle>;
 
     FreetypeHandle* ft_ = nullptr;
-    TableType faceItems_; ///< The key is a Postscript face name
+    HandleTable faceHandles_; ///< The key is a Postscript face name
+    std::vector<Item> faceItems_; ///< Indexed by face handle, unloaded faces have null face
+    std::size_t loadedItems_ = 0; ///< Number of faces ever loaded, the generation of the last one
+    std::unordered_map<const Face*, std::size_t> faceUsers_; ///< Number of items holding each face
 };
 
 } // namespace odtr
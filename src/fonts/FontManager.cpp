@@ -6,14 +6,14 @@
 #include "../utils/Log.h"
 
 #include <algorithm>
-#include <fstream>
 
 namespace odtr {
 
 const std::string FontManager::DEFAULT_EMOJI_FONT = "_default_emoji_font_";
 
-FontManager::FontManager(const utils::Log& log)
+FontManager::FontManager(const utils::Log& log, bool mapFontFiles)
     : log_(log),
+      mapFontFiles_(mapFontFiles),
       ft_(std::make_unique<odtr::FreetypeHandle>()),
       faces_(std::make_unique<odtr::FaceTable>()),
       fontStorage_(std::make_unique<odtr::FontStorage>()),
@@ -25,6 +25,7 @@ FontManager::FontManager(const utils::Log& log)
 
 FontManager::~FontManager()
 {
+    discardFacesTableInstances();
     faces_->discardFaces();
     ft_->deinitialize();
 }
@@ -34,6 +35,78 @@ const odtr::FaceTable& FontManager::facesTable() const
     return *faces_.get();
 }
 
+FacesTableLease FontManager::leaseFacesTable()
+{
+    std::unique_lock<std::mutex> lock(faceInstancesMutex_);
+
+    const std::size_t generation = facesGeneration_;
+    if (!faceInstances_.empty()) {
+        std::unique_ptr<odtr::FaceTable> instance = std::move(faceInstances_.back());
+        faceInstances_.pop_back();
+        return FacesTableLease(*this, std::move(instance), generation);
+    }
+
+    // creating the faces takes a while, other threads may lease meanwhile
+    lock.unlock();
+
+    auto instance = std::make_unique<odtr::FaceTable>();
+    {
+        std::lock_guard<std::mutex> ftLock(ftLibraryMutex_);
+        instance->loadInstancesOf(*faces_);
+    }
+    return FacesTableLease(*this, std::move(instance), generation);
+}
+
+std::unique_lock<std::mutex> FontManager::tryLockFacesTable()
+{
+    return std::unique_lock<std::mutex>(facesMutex_, std::try_to_lock);
+}
+
+std::unique_lock<std::mutex> FontManager::lockFacesTable()
+{
+    return std::unique_lock<std::mutex>(facesMutex_);
+}
+
+void FontManager::returnFacesTable(std::unique_ptr<odtr::FaceTable> faces, std::size_t generation)
+{
+    {
+        std::lock_guard<std::mutex> lock(faceInstancesMutex_);
+        if (generation == facesGeneration_) {
+            faceInstances_.push_back(std::move(faces));
+            return;
+        }
+    }
+
+    std::lock_guard<std::mutex> ftLock(ftLibraryMutex_);
+    faces->discardFaces();
+}
+
+void FontManager::discardFacesTableInstances()
+{
+    std::lock_guard<std::mutex> lock(faceInstancesMutex_);
+    std::lock_guard<std::mutex> ftLock(ftLibraryMutex_);
+
+    for (const auto& instance : faceInstances_) {
+        instance->discardFaces();
+    }
+    faceInstances_.clear();
+    ++facesGeneration_;
+}
+
+FacesTableLease::FacesTableLease(FontManager& manager, std::unique_ptr<odtr::FaceTable> faces, std::size_t generation)
+    : manager_(&manager),
+      faces_(std::move(faces)),
+      generation_(generation)
+{
+}
+
+FacesTableLease::~FacesTableLease()
+{
+    if (faces_) {
+        manager_->returnFacesTable(std::move(faces_), generation_);
+    }
+}
+
 BufferView::BytePtr FontManager::allocFontStorageBuffer(const std::string& key, std::size_t size)
 {
     return fontStorage_->alloc(key, size);
@@ -41,20 +114,22 @@ BufferView::BytePtr FontManager::allocFontStorageBuffer(const std::string& key,
 
 bool FontManager::loadFaceFromStorage(const std::string& key)
 {
-    auto data = fontStorage_->get(key);
+    auto data = fontStorage_->getContent(key);
     if (data) {
-        return loadFaceAs(key, key, "", data);
+        return loadStoredFaceAs(key, key, "", data);
     }
 
     return false;
 }
 
 bool FontManager::loadFaceFromStorageAs(const std::string& storageKey, const std::string& faceKey, const std::string& facePostScriptName) {
-    auto data = fontStorage_->get(storageKey);
+    auto data = fontStorage_->getContent(storageKey);
     if (!data) {
         return false;
     }
 
+    discardFacesTableInstances();
+
     if (auto result = faces_->loadFace(storageKey, faceKey, facePostScriptName, data)) {
         log_.info("face {} from file {} available under key: {} ",
                        result.value().originalFaceName.c_str(),
@@ -69,14 +144,15 @@ bool FontManager::loadFaceFromStorageAs(const std::string& storageKey, const std
 
 FacesNames FontManager::loadFacesFromStorage(const std::string& storageKey, const FacesNames& faces)
 {
-    auto data = fontStorage_->get(storageKey);
+    auto data = fontStorage_->getContent(storageKey);
     if (data) {
+        discardFacesTableInstances();
         auto loadedFaces = faces_->loadFaces(storageKey, faces, data);
 
         if (std::find(std::begin(loadedFaces), std::end(loadedFaces), storageKey) == std::end(loadedFaces)) {
             // storageKey is not among the loaded faces
             auto faceName = faces.size() == 1 ? faces[0] : "";
-            auto loaded = loadFaceAs(storageKey, storageKey, faceName, data);
+            auto loaded = loadStoredFaceAs(storageKey, storageKey, faceName, data);
             if (loaded) {
                 loadedFaces.push_back(storageKey);
             }
@@ -148,6 +224,18 @@ void FontManager::setRequiresDefaultEmojiFont()
 
 bool FontManager::loadFaceAs(const std::string& storageKey, const std::string& faceKey, const std::string& faceName, BufferView data)
 {
+    if (!fontStorage_->storeBytes(storageKey, data.data(), data.size())) {
+        log_.error("Failed to store font data of face {}", faceKey);
+        return false;
+    }
+
+    return loadStoredFaceAs(storageKey, faceKey, faceName, fontStorage_->getContent(storageKey));
+}
+
+bool FontManager::loadStoredFaceAs(const std::string& storageKey, const std::string& faceKey, const std::string& faceName, const FontStorage::ContentPtr& data)
+{
+    discardFacesTableInstances();
+
     auto result = faces_->loadFace(storageKey, faceKey, faceName, data);
     if (!result) {
         log_.error("Failed to load font face ", faceKey);
@@ -164,27 +252,7 @@ bool FontManager::storeFile(const std::string& storageKey, const std::string& fi
         return true;
     }
 
-    std::ifstream ifs(filename, std::ios::binary);
-
-    if (!ifs.is_open()) {
-        return false;
-    }
-
-    ifs.seekg(0, std::ios::end);
-    std::size_t size = ifs.tellg();
-    ifs.seekg(0, std::ios::beg);
-
-    auto buffer = fontStorage_->alloc(storageKey, size);
-    if (!buffer) {
-        log_.error("Failed to allocate font storage.");
-        return false;
-    }
-
-    ifs.read((char*)buffer, size);
-
-    fontStorage_->mark(storageKey, true);
-
-    return true;
+    return fontStorage_->storeFile(storageKey, filename, mapFontFiles_);
 }
 
 } // namespace odtr
@@ -1,10 +1,15 @@
 #pragma once
 
+#include "FontStorage.h"
+
 #include "../common/buffer_view.h"
 #include "../text-renderer/types.h"
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 namespace odtr {
 
@@ -14,14 +19,35 @@ class Log;
 
 class FaceTable;
 class FreetypeHandle;
-class FontStorage;
+class FontManager;
+
+/**
+ * Instance of the faces table borrowed from @a FontManager for use by a single thread,
+ * returned to the manager on destruction.
+ */
+class FacesTableLease
+{
+public:
+    FacesTableLease(FontManager& manager, std::unique_ptr<odtr::FaceTable> faces, std::size_t generation);
+    FacesTableLease(FacesTableLease&& other) = default;
+    ~FacesTableLease();
+
+    const odtr::FaceTable& operator*() const { return *faces_; }
+    const odtr::FaceTable* operator->() const { return faces_.get(); }
+
+private:
+    FontManager* manager_;
+    std::unique_ptr<odtr::FaceTable> faces_;
+    std::size_t generation_;
+};
 
 class FontManager
 {
 public:
     static const std::string DEFAULT_EMOJI_FONT;
 
-    explicit FontManager(const utils::Log& log);
+    /// @param mapFontFiles  whether the font files are memory mapped instead of read into the memory, see FontStorage::storeFile
+    FontManager(const utils::Log& log, bool mapFontFiles);
 
     ~FontManager();
 
@@ -29,6 +55,25 @@ public:
 
     const odtr::FaceTable& facesTable() const;
 
+    /**
+     * Borrows an instance of the faces table for the calling thread. A FreeType face must not be used
+     * by multiple threads at once, so each thread gets its own faces created from the same font data.
+     * Returned instances are reused by subsequent leases until the fonts change.
+     *
+     * Thread-safe, however, fonts must not be loaded while a lease is held.
+     */
+    FacesTableLease leaseFacesTable();
+
+    /**
+     * Locks the faces of @a facesTable for the calling thread, unless another thread holds them (see owns_lock).
+     * A draw call uses the faces while they are free and leases an instance only when they are not, so that
+     * drawing from a single thread doesn't create other instances of the faces.
+     */
+    std::unique_lock<std::mutex> tryLockFacesTable();
+
+    /// Locks the faces of @a facesTable for the calling thread, for shaping while draw calls may run.
+    std::unique_lock<std::mutex> lockFacesTable();
+
     /**
      * Allocs buffer of given size in @a FontStorage and returns pointer to it.
      *
@@ -86,27 +131,47 @@ public:
     void setRequiresDefaultEmojiFont();
 
     /**
-     * Loads font from a given buffer
+     * Loads font from a given buffer. The data is copied to @a FontStorage, unless data of equal content is stored
+     * already, in which case the faces loaded from it are reused too.
      *
-     * @param key      font identifier (typically PostScript name) within @a FontManager
+     * @param key      font identifier (typically PostScript name) within @a FontManager, the storage key of the data
      * @param faceKey  key to store the face in the face table (might be empty)
      * @param faceName face PostScript name as stored in the font file, used to select font from collection, might be empty
-     * @param data     font data passed within non-owning view of the buffer
+     * @param data     font data passed within non-owning view of the buffer, can be released after the call
      *
      * @return
      */
     bool loadFaceAs(const std::string& key, const std::string& faceKey, const std::string& faceName, BufferView data);
 
 private:
+    friend class FacesTableLease;
+
     bool storeFile(const std::string& storageKey, const std::string& filename, bool replace);
 
+    bool loadStoredFaceAs(const std::string& storageKey, const std::string& faceKey, const std::string& faceName, const FontStorage::ContentPtr& data);
+
+    void returnFacesTable(std::unique_ptr<odtr::FaceTable> faces, std::size_t generation);
+    void discardFacesTableInstances();
+
     const utils::Log& log_;
+    const bool mapFontFiles_;
 
     std::unique_ptr<odtr::FreetypeHandle> ft_;
     std::unique_ptr<odtr::FaceTable> faces_;
     std::unique_ptr<odtr::FontStorage> fontStorage_;
 
-    bool requiresDefaultEmojiFont_;
+    /// Instances of the faces table not leased at the moment.
+    std::vector<std::unique_ptr<odtr::FaceTable>> faceInstances_;
+    /// Incremented whenever the fonts change, instances of older generations are discarded when returned.
+    std::size_t facesGeneration_ = 0;
+    std::mutex faceInstancesMutex_;
+    /// Held by the thread drawing with or shaping on behalf of a draw with the faces of @a faces_.
+    std::mutex facesMutex_;
+    /// Serializes creating and destroying the faces of the instances, FreeType requires it for faces of the same library.
+    std::mutex ftLibraryMutex_;
+
+    /// Set while shaping, possibly from multiple threads.
+    std::atomic<bool> requiresDefaultEmojiFont_;
 };
 
 } // namespace odtr
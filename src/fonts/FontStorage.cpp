@@ -1,33 +1,126 @@
 #include "FontStorage.h"
 
+#include <fstream>
 
 namespace odtr {
 
+FontStorage::Content::Content(BufferType buffer) : buffer_(std::move(buffer))
+{
+}
+
+FontStorage::Content::Content(std::unique_ptr<MappedFile> mapping) : mapping_(std::move(mapping))
+{
+}
+
+BufferView FontStorage::Content::view() const {
+    // FreeType only reads the data, the mapping is read-only
+    if (mapping_) {
+        return BufferView(const_cast<Byte*>(mapping_->data()), mapping_->size());
+    }
+    if (buffer_.size()) {
+        return BufferView(const_cast<Byte*>(buffer_.data()), buffer_.size());
+    }
+    return BufferView::createEmpty();
+}
+
+const ContentHash& FontStorage::Content::hash() const {
+    if (!hash_.has_value()) {
+        const BufferView data = view();
+        hash_ = hashContent(data.data(), data.size());
+    }
+    return *hash_;
+}
+
 Byte *FontStorage::alloc(const FontStorage::Key& name, std::size_t size) {
-    auto [it, _] = storage_.insert(std::make_pair(name, Item { BufferType {}, false }));
+    auto content = std::make_shared<Content>(BufferType(size));
+    Byte *buffer = content->buffer_.data();
+
+    Item &item = storage_[name];
+    item.content = std::move(content);
+    item.success = false;
+
+    return buffer;
+}
+
+bool FontStorage::storeFile(const FontStorage::Key& name, const std::string& filename, bool map) {
+    if (map) {
+        if (std::unique_ptr<MappedFile> mapping = MappedFile::open(filename)) {
+            storeContent(name, std::make_shared<Content>(std::move(mapping)));
+            return true;
+        }
+    }
+
+    std::ifstream ifs(filename, std::ios::binary);
+
+    if (!ifs.is_open()) {
+        return false;
+    }
+
+    ifs.seekg(0, std::ios::end);
+    std::size_t size = ifs.tellg();
+    ifs.seekg(0, std::ios::beg);
+
+    auto buffer = alloc(name, size);
+    if (!buffer && size) {
+        return false;
+    }
+
+    ifs.read((char*)buffer, size);
+
+    mark(name, true);
 
-    it->second.buffer.resize(size);
+    return true;
+}
+
+bool FontStorage::storeBytes(const FontStorage::Key& name, const Byte* data, std::size_t size) {
+    if (data == nullptr || size == 0) {
+        return false;
+    }
 
-    return it->second.buffer.data();
+    // an equal content is not copied at all
+    std::optional<ContentHash> hash;
+    if (ContentPtr content = findContent(BufferView(const_cast<Byte*>(data), size), hash)) {
+        Item &item = storage_[name];
+        item.content = std::move(content);
+        item.success = true;
+        return true;
+    }
+
+    auto content = std::make_shared<Content>(BufferType(data, data + size));
+    content->hash_ = hash;
+    storeContent(name, std::move(content));
+    return true;
 }
 
 BufferView FontStorage::get(const FontStorage::Key& name) {
     auto it = storage_.find(name);
 
-    if (it != std::end(storage_) && it->second.buffer.size()) {
-        if (it->second.success) {
-            return BufferView(it->second.buffer.data(), it->second.buffer.size());
-        }
+    if (it != std::end(storage_) && it->second.success) {
+        return it->second.content->view();
     }
 
     return BufferView::createEmpty();
 }
 
+FontStorage::ContentPtr FontStorage::getContent(const FontStorage::Key& name) const {
+    auto it = storage_.find(name);
+
+    if (it != std::end(storage_) && it->second.success) {
+        return it->second.content;
+    }
+
+    return nullptr;
+}
+
 void FontStorage::mark(const FontStorage::Key& name, bool success) {
     auto it = storage_.find(name);
 
-    if (it != std::end(storage_) && it->second.buffer.size()) {
-        it->second.success = success;
+    if (it != std::end(storage_) && it->second.content->view()) {
+        if (success && !it->second.success) {
+            storeContent(name, std::move(it->second.content));
+        } else {
+            it->second.success = success;
+        }
     }
 }
 
@@ -35,4 +128,43 @@ bool FontStorage::contains(const FontStorage::Key& name) const {
     return storage_.find(name) != std::end(storage_);
 }
 
+FontStorage::ContentPtr FontStorage::findContent(BufferView data, std::optional<ContentHash>& hash) {
+    const auto [first, last] = contents_.equal_range(data.size());
+    for (auto it = first; it != last; ) {
+        ContentPtr content = it->second.lock();
+        if (content == nullptr) {
+            it = contents_.erase(it);
+            continue;
+        }
+        ++it;
+
+        if (content->view().data() == data.data()) {
+            return content;
+        }
+        if (!hash.has_value()) {
+            hash = hashContent(data.data(), data.size());
+        }
+        if (content->hash() == *hash) {
+            return content;
+        }
+    }
+
+    return nullptr;
+}
+
+void FontStorage::storeContent(const FontStorage::Key& name, ContentPtr content) {
+    std::optional<ContentHash> hash = content->hash_;
+    ContentPtr equalContent = findContent(content->view(), hash);
+    if (equalContent == nullptr) {
+        // the digest is kept for comparisons with the contents stored later
+        content->hash_ = hash;
+        contents_.emplace(content->view().size(), content);
+        equalContent = std::move(content);
+    }
+
+    Item &item = storage_[name];
+    item.content = std::move(equalContent);
+    item.success = true;
+}
+
 } // namespace odtr
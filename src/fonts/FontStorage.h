@@ -1,8 +1,13 @@
 #pragma once
 
+#include "MappedFile.h"
+
 #include "../common/buffer_view.h"
+#include "../common/content_hash.h"
 #include "../text-renderer/base-types.h"
 
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -10,26 +15,77 @@
 
 namespace odtr {
 
+/**
+ * Font data stored under keys, typically file names or PostScript names.
+ *
+ * Data of equal content is stored only once, whatever the keys it's stored under, so that the faces loaded
+ * from it can be shared too, see FaceTable. Contents are compared by their size first, the digest of a content
+ * is only computed once another content of the same size is stored.
+ */
 class FontStorage
 {
 public:
     using Key = std::string;
 
+    /// Font data shared by the keys it's stored under, kept alive by the faces loaded from it.
+    class Content
+    {
+    public:
+        explicit Content(BufferType buffer);
+        explicit Content(std::unique_ptr<MappedFile> mapping);
+
+        BufferView view() const;
+
+        /// Digest of the data, computed on the first call.
+        const ContentHash& hash() const;
+
+    private:
+        friend class FontStorage;
+
+        BufferType buffer_;
+        /// Mapping of the font file, used instead of the buffer if not null
+        std::unique_ptr<MappedFile> mapping_;
+        mutable std::optional<ContentHash> hash_;
+    };
+    using ContentPtr = std::shared_ptr<const Content>;
+
     Byte *alloc(const Key& name, std::size_t size);
 
+    /**
+     * Stores the content of a file, replacing the previous data stored under @a name. The file is read into a buffer,
+     * or memory mapped if @a map is set and mapping is possible. A mapped file must not be truncated or replaced
+     * in place while its content is used, reading the missing pages raises SIGBUS.
+     *
+     * @return  false if the file can't be read
+     */
+    bool storeFile(const Key& name, const std::string& filename, bool map);
+
+    /// Stores a copy of the data, unless an equal content is stored already, replacing the previous data stored under @a name.
+    bool storeBytes(const Key& name, const Byte* data, std::size_t size);
+
     BufferView get(const Key& name);
 
+    /// Returns the content stored under @a name, which keeps its data alive even if replaced later, or null.
+    ContentPtr getContent(const Key& name) const;
+
     void mark(const Key& name, bool success);
 
     bool contains(const Key& name) const;
 
 private:
     struct Item {
-        BufferType buffer;
+        ContentPtr content;
         bool success;
     };
 
+    /// Returns a stored content equal to the data, or null.
+    ContentPtr findContent(BufferView data, std::optional<ContentHash>& hash);
+    /// Stores @a content under @a name, or the equal stored content instead.
+    void storeContent(const Key& name, ContentPtr content);
+
     std::unordered_map<Key, Item> storage_;
+    /// Contents stored under any key by their size
+    std::unordered_multimap<std::size_t, std::weak_ptr<const Content>> contents_;
 };
 
 } // namespace odtr
@@ -0,0 +1,54 @@
+#include "MappedFile.h"
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#define ODTR_MMAP_AVAILABLE
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace odtr {
+
+std::unique_ptr<MappedFile> MappedFile::open(const std::string& filename)
+{
+#ifdef ODTR_MMAP_AVAILABLE
+    const int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat fileStat;
+    if (::fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0) {
+        ::close(fd);
+        return nullptr;
+    }
+
+    const std::size_t size = static_cast<std::size_t>(fileStat.st_size);
+    void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping stays valid without the descriptor
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+
+    return std::unique_ptr<MappedFile>(new MappedFile(static_cast<const Byte*>(data), size));
+#else
+    (void) filename;
+    return nullptr;
+#endif
+}
+
+MappedFile::MappedFile(const Byte* data, std::size_t size)
+    : data_(data), size_(size)
+{
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef ODTR_MMAP_AVAILABLE
+    ::munmap(const_cast<Byte*>(data_), size_);
+#endif
+}
+
+} // namespace odtr
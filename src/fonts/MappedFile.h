@@ -0,0 +1,37 @@
+#pragma once
+
+#include "../text-renderer/base-types.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace odtr {
+
+/**
+ * Read-only memory mapping of a file.
+ *
+ * The pages are loaded on demand and shared with other mappings of the file, also by other processes.
+ * Available on Unix-like platforms except Emscripten, elsewhere the file can't be mapped.
+ */
+class MappedFile
+{
+public:
+    /// Maps the whole file, null if it can't be mapped, is empty or the platform doesn't support mapping.
+    static std::unique_ptr<MappedFile> open(const std::string& filename);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    const Byte* data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+private:
+    MappedFile(const Byte* data, std::size_t size);
+
+    const Byte* data_;
+    std::size_t size_;
+};
+
+} // namespace odtr
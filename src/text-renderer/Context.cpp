@@ -3,8 +3,21 @@
 #include "text-renderer.h"
 #include "../fonts/FontManager.h"
 
+#include <algorithm>
+#include <thread>
+#include <utility>
+
 namespace odtr {
 
+Context::Context(std::unique_ptr<utils::Log> logger, std::size_t glyphCacheBudget, std::size_t shapingCacheBudget, std::size_t threadCount, bool mapFontFiles) :
+    logger(std::move(logger)),
+    fontManager(std::make_unique<FontManager>(*this->logger, mapFontFiles)),
+    glyphCache(glyphCacheBudget),
+    shapingCache(shapingCacheBudget),
+    threadCount(threadCount)
+{
+}
+
 const utils::Log& Context::getLogger() const
 {
     return *logger.get();
@@ -30,4 +43,18 @@ int Context::removeInactiveShapes()
     return int(before - shapes.size());
 }
 
+utils::ThreadPool* Context::getThreadPool()
+{
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+    std::lock_guard<std::mutex> lock(threadPoolMutex);
+    if (!threadPool) {
+        const std::size_t count = threadCount != 0 ? threadCount : std::max(1u, std::thread::hardware_concurrency());
+        if (count > 1) {
+            threadPool = std::make_unique<utils::ThreadPool>(count);
+        }
+    }
+#endif
+    return threadPool.get();
+}
+
 }
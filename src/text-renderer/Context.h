@@ -2,10 +2,17 @@
 
 #include "../fonts/FontManager.h"
 #include "../text-renderer/Config.h"
+#include "GlyphCache.h"
+#include "PlacedTextCache.h"
+#include "PlacedTextDiskCache.h"
+#include "ShapingCache.h"
 #include "TextShape.h"
+#include "../unicode/Analyzer.h"
 #include "../utils/Log.h"
+#include "../utils/ThreadPool.h"
 
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <vector>
@@ -16,6 +23,8 @@ class FontManager;
 
 struct Context
 {
+    Context(std::unique_ptr<utils::Log> logger, std::size_t glyphCacheBudget, std::size_t shapingCacheBudget, std::size_t threadCount, bool mapFontFiles);
+
     priv::Config config;
 
     std::unique_ptr<utils::Log> logger = utils::Log::createNoLog();
@@ -23,12 +32,35 @@ struct Context
 
     std::vector<std::unique_ptr<TextShape>> shapes;
 
+    GlyphCache glyphCache;
+    ShapingCache shapingCache;
+
+    /// Number of threads running batch operations, 0 for the number of hardware threads.
+    std::size_t threadCount = 0;
+    std::unique_ptr<utils::ThreadPool> threadPool;
+    std::mutex threadPoolMutex;
+
+    /// Serializes reshaping of dirty shapes by concurrent draw calls.
+    std::mutex shapesMutex;
+
+    /// ICU objects reused for analysis of the paragraphs.
+    unicode::AnalyzerPool unicodeAnalyzers;
+
+    /// Placed texts shared by the text shapes of identical texts.
+    PlacedTextCache placedTextCache;
+
+    /// Placed texts persisted across contexts, null if disabled.
+    std::unique_ptr<PlacedTextDiskCache> placedTextDiskCache;
+
     const utils::Log& getLogger() const;
 
     const FontManager& getFontManager() const;
     FontManager& getFontManager();
 
     int removeInactiveShapes();
+
+    /// Returns the thread pool for batch operations, created on the first call. Null if there is a single thread.
+    utils::ThreadPool* getThreadPool();
 };
 
 }
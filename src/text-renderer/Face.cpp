@@ -1,7 +1,11 @@
 #include "Face.h"
 #include "../otf/otf.h"
+#include "../common/hash_utils.hpp"
 // REFACTOR
 // #include "logging/BasicLogger.h"
+#include <hb-ot.h>
+#include <algorithm>
+#include <iterator>
 #include <limits>
 #include <string>
 #include <cassert>
@@ -10,32 +14,73 @@ namespace odtr {
 
 using namespace compat;
 
-Face::Face(FT_Library ftLibrary, const char* filename, FT_Long faceIndex) : hbFont_(nullptr)
+namespace {
+
+/// Faces with more glyphs are not searched for kerning pairs of the space, their space is assumed to be kerned.
+constexpr FT_Long MAX_KERNING_SCAN_GLYPHS = 8192;
+
+/// Whether a lookup of the GSUB or GPOS table matches or produces @a glyph.
+bool isGlyphInLookups(hb_face_t* hbFace, hb_tag_t tableTag, hb_codepoint_t glyph)
+{
+    hb_set_t* glyphs = hb_set_create();
+    bool found = false;
+    const unsigned int lookupCount = hb_ot_layout_table_get_lookup_count(hbFace, tableTag);
+    for (unsigned int i = 0; i < lookupCount && !found; ++i) {
+        hb_ot_layout_lookup_collect_glyphs(hbFace, tableTag, i, glyphs, glyphs, glyphs, glyphs);
+        found = hb_set_has(glyphs, glyph);
+    }
+    hb_set_destroy(glyphs);
+    return found;
+}
+
+}
+
+Face::Face(FT_Library ftLibrary, const char* filename, FT_Long faceIndex) : hbFont_(nullptr), filename_(filename), faceIndex_(faceIndex)
 {
-    FreetypeHandle::error = FT_New_Face(ftLibrary, filename, faceIndex, &ftFace_);
-    if (FreetypeHandle::checkOk(__func__)) {
+    const FT_Error error = FT_New_Face(ftLibrary, filename, faceIndex, &ftFace_);
+    if (FreetypeHandle::checkOk(error, __func__)) {
         initialize();
         if (auto featuresResult = otf::listFeatures(filename)) {
-            features_ = featuresResult.moveValue();
+            features_ = std::make_shared<const otf::Features>(featuresResult.moveValue());
         }
     } else {
         ftFace_ = nullptr;
     }
 }
 
-Face::Face(FT_Library ftLibrary, const byte* fileBytes, int length, FT_Long faceIndex) : hbFont_(nullptr)
+Face::Face(FT_Library ftLibrary, const byte* fileBytes, int length, FT_Long faceIndex) : hbFont_(nullptr), fileBytes_(fileBytes), fileLength_(length), faceIndex_(faceIndex)
 {
-    FreetypeHandle::error = FT_New_Memory_Face(ftLibrary, fileBytes, length, faceIndex, &ftFace_);
-    if (FreetypeHandle::checkOk(__func__)) {
+    const FT_Error error = FT_New_Memory_Face(ftLibrary, fileBytes, length, faceIndex, &ftFace_);
+    if (FreetypeHandle::checkOk(error, __func__)) {
         initialize();
         if (auto featuresResult = otf::listFeatures(fileBytes, length)) {
-            features_ = featuresResult.moveValue();
+            features_ = std::make_shared<const otf::Features>(featuresResult.moveValue());
         }
     } else {
         ftFace_ = nullptr;
     }
 }
 
+Face::Face(FT_Library ftLibrary, const Face& origin) :
+    hbFont_(nullptr),
+    filename_(origin.filename_),
+    fileBytes_(origin.fileBytes_),
+    fileLength_(origin.fileLength_),
+    faceIndex_(origin.faceIndex_),
+    origin_(origin.origin())
+{
+    const FT_Error error = fileBytes_
+        ? FT_New_Memory_Face(ftLibrary, fileBytes_, fileLength_, faceIndex_, &ftFace_)
+        : FT_New_Face(ftLibrary, filename_.c_str(), faceIndex_, &ftFace_);
+    if (FreetypeHandle::checkOk(error, __func__)) {
+        initialize();
+        params_ = origin.params_;
+        features_ = origin.features_;
+    } else {
+        ftFace_ = nullptr;
+    }
+}
+
 void Face::initialize()
 {
     recreateHBFont();
@@ -46,7 +91,6 @@ void Face::initialize()
     params_.isColor = isColorFont();
     params_.scalable = FT_IS_SCALABLE(ftFace_);
     params_.loadflags = params_.isColor ? FT_LOAD_COLOR : FT_LOAD_DEFAULT;
-    FreetypeHandle::error = FT_Err_Ok;
 }
 
 void Face::recreateHBFont()
@@ -60,9 +104,14 @@ void Face::recreateHBFont()
 
 Face::~Face()
 {
-    hb_font_destroy(hbFont_);
-    FreetypeHandle::error = FT_Done_Face(ftFace_);
-    FreetypeHandle::checkOk(__func__);
+    for (const SizeInstance& instance : sizes_) {
+        destroySizeInstance(instance);
+    }
+    if (sizes_.empty()) {
+        hb_font_destroy(hbFont_);
+    }
+    const FT_Error error = FT_Done_Face(ftFace_);
+    FreetypeHandle::checkOk(error, __func__);
 }
 
 bool Face::ready() const
@@ -158,13 +207,65 @@ hb_font_t* Face::getHbFont() const
 
 Result<font_size,bool> Face::setSize(font_size size)
 {
+    if (!sizes_.empty() && sizes_.front().requestedSize == size) {
+        return sizes_.front().selectedSize;
+    }
+
+    auto it = std::find_if(sizes_.begin(), sizes_.end(), [size](const SizeInstance& instance) {
+        return instance.requestedSize == size;
+    });
+
+    if (it != sizes_.end()) {
+        const FT_Error error = FT_Activate_Size(it->ftSize);
+        if (!FreetypeHandle::checkOk(error, __func__)) {
+            return false;
+        }
+        std::rotate(sizes_.begin(), it, std::next(it));
+    } else {
+        Result<SizeInstance,bool> instanceResult = createSizeInstance(size);
+        if (!instanceResult) {
+            if (!sizes_.empty()) {
+                FT_Activate_Size(sizes_.front().ftSize);
+            }
+            return false;
+        }
+        if (sizes_.empty()) {
+            // the default hb_font_t doesn't match any size instance
+            hb_font_destroy(hbFont_);
+        }
+        if (sizes_.size() >= MAX_SIZE_INSTANCES) {
+            destroySizeInstance(sizes_.back());
+            sizes_.pop_back();
+        }
+        sizes_.insert(sizes_.begin(), instanceResult.moveValue());
+    }
+
+    hbFont_ = sizes_.front().hbFont;
+    return sizes_.front().selectedSize;
+}
+
+Result<Face::SizeInstance,bool> Face::createSizeInstance(font_size size)
+{
+    FT_Size ftSize = nullptr;
+    FT_Error error = FT_New_Size(ftFace_, &ftSize);
+    if (!FreetypeHandle::checkOk(error, __func__)) {
+        return false;
+    }
+    error = FT_Activate_Size(ftSize);
+    if (!FreetypeHandle::checkOk(error, __func__)) {
+        FT_Done_Size(ftSize);
+        return false;
+    }
+
     auto selectedSize = size;
     auto charSize = FreetypeHandle::to26_6fixed(float(size));
     if (params_.scalable) {
-        FreetypeHandle::error = FT_Set_Char_Size(ftFace_, 0, charSize, 0, 0);
+        error = FT_Set_Char_Size(ftFace_, 0, charSize, 0, 0);
     } else {
-        if (ftFace_->num_fixed_sizes == 0)
+        if (ftFace_->num_fixed_sizes == 0) {
+            FT_Done_Size(ftSize);
             return false;
+        }
 
         int best_match = 0;
         int diff = std::numeric_limits<int>::max();
@@ -176,17 +277,55 @@ Result<font_size,bool> Face::setSize(font_size size)
             }
         }
         selectedSize = font_size(FreetypeHandle::from26_6fixed(ftFace_->available_sizes[best_match].size));
-        FreetypeHandle::error = FT_Select_Size(ftFace_, best_match);
+        error = FT_Select_Size(ftFace_, best_match);
     }
 
-    // need to create new hb_font after resizing the FT_Face
-    recreateHBFont();
-
-    if (!FreetypeHandle::checkOk(__func__)) {
+    if (!FreetypeHandle::checkOk(error, __func__)) {
+        FT_Done_Size(ftSize);
         return false;
     }
 
-    return selectedSize;
+    // hb_font_t takes its scale from the active size of the FT_Face
+    hb_font_t* hbFont = hb_ft_font_create_referenced(ftFace_);
+
+    return SizeInstance { size, selectedSize, ftSize, hbFont, computeMetrics(), std::make_unique<SizeGlyphCache>() };
+}
+
+void Face::destroySizeInstance(const SizeInstance& instance)
+{
+    hb_font_destroy(instance.hbFont);
+    const FT_Error error = FT_Done_Size(instance.ftSize);
+    FreetypeHandle::checkOk(error, __func__);
+}
+
+Face::Metrics Face::computeMetrics() const
+{
+    if (params_.scalable) {
+        return Metrics {
+            scaleFontUnits(ftFace_->ascender, true),
+            scaleFontUnits(ftFace_->descender, true),
+            scaleFontUnits(ftFace_->height, true),
+        };
+    }
+
+    // the values in size->metrics are rounded for historical reasons and therefore less desirable
+    // however "global" values in font units are not present in bitmap fonts
+    // see docs for FT_Size_Metrics and FT_FaceRec for more info
+    return Metrics {
+        FreetypeHandle::from26_6fixed(ftFace_->size->metrics.ascender),
+        FreetypeHandle::from26_6fixed(ftFace_->size->metrics.descender),
+        FreetypeHandle::from26_6fixed(ftFace_->size->metrics.height),
+    };
+}
+
+Face::Metrics Face::getMetrics() const
+{
+    return sizes_.empty() ? computeMetrics() : sizes_.front().metrics;
+}
+
+Face::SizeGlyphCache* Face::activeGlyphCache() const
+{
+    return sizes_.empty() ? nullptr : sizes_.front().glyphCache.get();
 }
 
 const std::string& Face::getPostScriptName() const
@@ -194,24 +333,125 @@ const std::string& Face::getPostScriptName() const
     return postscriptName_;
 }
 
+bool Face::MetricsGlyphKey::operator==(const MetricsGlyphKey& other) const
+{
+    return codepoint == other.codepoint &&
+           offsetX == other.offsetX &&
+           offsetY == other.offsetY &&
+           vectorScale == other.vectorScale &&
+           bitmapScale == other.bitmapScale &&
+           disableHinting == other.disableHinting;
+}
+
+std::size_t Face::MetricsGlyphKeyHasher::operator()(const MetricsGlyphKey& key) const
+{
+    std::size_t seed = 0;
+    hash_combine(seed, key.codepoint);
+    hash_combine(seed, key.offsetX);
+    hash_combine(seed, key.offsetY);
+    hash_combine(seed, key.vectorScale);
+    hash_combine(seed, key.bitmapScale);
+    hash_combine(seed, key.disableHinting);
+    return seed;
+}
+
 GlyphPtr Face::acquireGlyph(FT_UInt codepoint, const Vector2f& offset, const ScaleParams& scale, bool render, bool disableHinting) const
 {
     auto params = params_;
     if (disableHinting) {
         params.loadflags |= FT_LOAD_NO_HINTING /*| FT_LOAD_NO_AUTOHINT*/;
     }
-    acquisitor_.setup(params, ftFace_);
-    return acquisitor_.acquire(codepoint, offset, scale, render);
+
+    SizeGlyphCache* glyphCache = activeGlyphCache();
+    if (glyphCache == nullptr) {
+        return acquisitor_.acquire(ftFace_, params, codepoint, offset, scale, render);
+    }
+
+    if (render) {
+        GlyphPtr glyph = renderOutline(*glyphCache, codepoint, offset, scale, params, disableHinting);
+        return glyph ? std::move(glyph) : acquisitor_.acquire(ftFace_, params, codepoint, offset, scale, render);
+    }
+
+    // the offset is passed to FreeType in 26.6 format
+    const MetricsGlyphKey key {
+        codepoint,
+        static_cast<FT_Pos>(FreetypeHandle::to26_6fixed(offset.x)),
+        static_cast<FT_Pos>(FreetypeHandle::to26_6fixed(offset.y)),
+        scale.vectorScale,
+        scale.bitmapScale,
+        disableHinting
+    };
+
+    if (const GlyphPtr* cached = glyphCache->metricsGlyphs.find(key)) {
+        return (*cached)->clone();
+    }
+
+    GlyphPtr glyph = acquisitor_.acquire(ftFace_, params, codepoint, offset, scale, render);
+    if (glyph) {
+        glyphCache->metricsGlyphs.insert(key, glyph->clone());
+    }
+    return glyph;
+}
+
+GlyphPtr Face::renderOutline(SizeGlyphCache& glyphCache, FT_UInt codepoint, const Vector2f& offset,
+                             const ScaleParams& scale, const GlyphAcquisitor::Parameters& params, bool disableHinting) const
+{
+    OutlineCache& outlines = glyphCache.outlines[disableHinting ? 1 : 0];
+
+    const GlyphAcquisitor::LoadedOutlinePtr* outline = outlines.find(codepoint);
+    if (outline == nullptr) {
+        outline = &outlines.insert(codepoint, acquisitor_.loadOutline(ftFace_, params, codepoint));
+    }
+
+    if (!*outline) {
+        return nullptr;
+    }
+
+    return acquisitor_.render(**outline, offset, scale);
 }
 
 FT_Fixed Face::getGlyphAdvance(hb_codepoint_t codepoint) const
 {
+    SizeGlyphCache* glyphCache = activeGlyphCache();
+    if (glyphCache != nullptr) {
+        const auto it = glyphCache->advances.find(codepoint);
+        if (it != glyphCache->advances.end()) {
+            return it->second;
+        }
+    }
+
     FT_Fixed advance;
-    FreetypeHandle::error = FT_Get_Advance(ftFace_, codepoint, params_.loadflags, &advance);
-    FreetypeHandle::checkOk(__func__);
+    const FT_Error error = FT_Get_Advance(ftFace_, codepoint, params_.loadflags, &advance);
+    FreetypeHandle::checkOk(error, __func__);
+
+    if (glyphCache != nullptr) {
+        glyphCache->advances.emplace(codepoint, advance);
+    }
     return advance;
 }
 
+Vector2f Face::getGlyphBearing(FT_UInt codepoint) const
+{
+    SizeGlyphCache* glyphCache = activeGlyphCache();
+    if (glyphCache != nullptr) {
+        const auto it = glyphCache->bearings.find(codepoint);
+        if (it != glyphCache->bearings.end()) {
+            return it->second;
+        }
+    }
+
+    auto params = params_;
+    params.loadflags |= FT_LOAD_NO_HINTING;
+
+    const GlyphPtr glyph = acquisitor_.acquire(ftFace_, params, codepoint, {}, {1.0f, 1.0f}, false);
+    const Vector2f bearing = glyph ? Vector2f { glyph->metricsBearing.x, glyph->metricsBearing.y } : Vector2f {};
+
+    if (glyphCache != nullptr) {
+        glyphCache->bearings.emplace(codepoint, bearing);
+    }
+    return bearing;
+}
+
 bool Face::hasGlyph(qchar cp) const
 {
     auto idx = FT_Get_Char_Index(ftFace_, cp);
@@ -220,7 +460,39 @@ bool Face::hasGlyph(qchar cp) const
 
 bool Face::hasOpenTypeFeature(const std::string& featureTag) const
 {
-    return features_.hasFeature(featureTag);
+    return features_ && features_->hasFeature(featureTag);
+}
+
+bool Face::spaceAffectsShaping() const
+{
+    std::call_once(spaceShapingFlag_, [this]() {
+        const FT_UInt space = FT_Get_Char_Index(ftFace_, ' ');
+        if (space == 0 || hbFont_ == nullptr) {
+            return;
+        }
+
+        hb_face_t* hbFace = hb_font_get_face(hbFont_);
+        if (isGlyphInLookups(hbFace, HB_OT_TAG_GSUB, space) || isGlyphInLookups(hbFace, HB_OT_TAG_GPOS, space)) {
+            return;
+        }
+
+        if (FT_HAS_KERNING(ftFace_)) {
+            if (ftFace_->num_glyphs > MAX_KERNING_SCAN_GLYPHS) {
+                return;
+            }
+            for (FT_UInt glyph = 0; glyph < static_cast<FT_UInt>(ftFace_->num_glyphs); ++glyph) {
+                FT_Vector before {}, after {};
+                FT_Get_Kerning(ftFace_, glyph, space, FT_KERNING_UNSCALED, &before);
+                FT_Get_Kerning(ftFace_, space, glyph, FT_KERNING_UNSCALED, &after);
+                if (before.x != 0 || after.x != 0) {
+                    return;
+                }
+            }
+        }
+
+        spaceAffectsShaping_ = false;
+    });
+    return spaceAffectsShaping_;
 }
 
 float Face::scaleFontUnits(int fontParam, bool y_scale) const
@@ -8,8 +8,13 @@
 #include "../otf/otf.h"
 
 #include "../common/result.hpp"
+#include "../utils/LruMap.h"
 
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace odtr {
 
@@ -22,6 +27,12 @@ class Face
 public:
     Face(FT_Library ftLibrary, const char* filename, FT_Long faceIndex);
     Face(FT_Library ftLibrary, const compat::byte* fileBytes, int length, FT_Long faceIndex);
+    /**
+     * Creates another instance of @a origin from the same font data, with its own FreeType and HarfBuzz objects,
+     * so that both can be used by different threads. The parsed OpenType features are shared.
+     * The font data must outlive both instances.
+     */
+    Face(FT_Library ftLibrary, const Face& origin);
     Face(const Face&) = delete;
     ~Face();
     Face& operator=(const Face&) = delete;
@@ -39,11 +50,39 @@ public:
     FT_Face getFtFace() const { return ftFace_; }
     hb_font_t* getHbFont() const;
 
+    /**
+     * Activates the requested size. Each size is backed by its own FT_Size and hb_font_t
+     * instance, kept for subsequent calls, so switching between recently used sizes is cheap.
+     *
+     * @return  the actual size, which may differ from @a size for bitmap fonts
+     */
     Result<font_size, bool> setSize(font_size size);
-    void setFlags(FT_Int32 loadflags) const { params_.loadflags = loadflags; }
+
+    /// Vertical metrics of the face at the active size, in pixels
+    struct Metrics
+    {
+        float ascender;
+        float descender;
+        float height;   //!< Default line height
+    };
+
+    /**
+     * Returns the vertical metrics of the active size. For scalable faces these are computed
+     * from the values in font units, as the ones in FT_Size_Metrics are rounded.
+     */
+    Metrics getMetrics() const;
 
     const std::string& getPostScriptName() const;
 
+    /// The face this instance was created from, or the face itself. Identifies the face in caches.
+    const Face* origin() const { return origin_ ? origin_ : this; }
+
+    /// Whether the face was created from the face at @a faceIndex of the font data at @a fileBytes.
+    bool isLoadedFrom(const compat::byte* fileBytes, int length, FT_Long faceIndex) const
+    {
+        return fileBytes_ == fileBytes && fileLength_ == length && faceIndex_ == faceIndex;
+    }
+
     /**
      * @brief One call to (acquire glyphs to) rule them all.
      *
@@ -51,8 +90,12 @@ public:
      * @param xOffset         Sub-pixel offset of glyph, should be <0, 1>
      * @param scale           Render scale
      * @param render          Whether to render a scalable glyph to bitmap. Not applicable to bitmap fonts.
+     *                        If not, a MetricsGlyph with the dimensions the bitmap would have is returned.
      *
      * @return              Glyph ready to be drawn onto bitmap or scaled as vector shape.
+     *
+     * Glyphs which are not rendered are cached for the active size. Outlines of rendered glyphs are cached
+     * for the active size too, so that rendering at another offset or scale only transforms and scan converts them.
      */
     GlyphPtr acquireGlyph(FT_UInt codepoint,
                           const compat::Vector2f& offset,
@@ -61,28 +104,113 @@ public:
                           bool disableHinting = false) const;
 
     /**
-     * Get glyph advance right from the face.
+     * Get glyph advance at the active size, loaded from the face once per size.
      */
     FT_Fixed getGlyphAdvance(hb_codepoint_t codepoint) const;
 
+    /**
+     * Get unhinted bearing of the glyph at the active size, see Glyph::metricsBearing.
+     * Loaded from the face once per size.
+     */
+    compat::Vector2f getGlyphBearing(FT_UInt codepoint) const;
+
     bool hasGlyph(compat::qchar cp) const;
 
     bool hasOpenTypeFeature(const std::string& featureTag) const;
 
+    /**
+     * Whether the space glyph takes part in the substitutions or positioning of the face (GSUB, GPOS or kern table).
+     * If not, words separated by spaces are shaped the same on their own as within the text. Determined on the first call.
+     */
+    bool spaceAffectsShaping() const;
+
 private:
+    /// Identifies a glyph acquired without rendering, see GlyphAcquisitor::acquireSlot
+    struct MetricsGlyphKey
+    {
+        FT_UInt codepoint;
+        FT_Pos offsetX, offsetY;    //!< 26.6
+        RenderScale vectorScale;
+        RenderScale bitmapScale;
+        bool disableHinting;
+
+        bool operator==(const MetricsGlyphKey& other) const;
+    };
+
+    struct MetricsGlyphKeyHasher
+    {
+        std::size_t operator()(const MetricsGlyphKey& key) const;
+    };
+
+    /// Maximal number of glyphs acquired without rendering cached per size, the least recently used ones are evicted first.
+    static constexpr std::size_t MAX_METRICS_GLYPHS = 4096;
+    /// Maximal number of outlines cached per size, the least recently used ones are evicted first.
+    static constexpr std::size_t MAX_OUTLINES = 1024;
+
+    using OutlineCache = utils::LruMap<FT_UInt, GlyphAcquisitor::LoadedOutlinePtr>;
+
+    /// Metrics and outlines of glyphs loaded at a single size
+    struct SizeGlyphCache
+    {
+        std::unordered_map<FT_UInt, FT_Fixed> advances;
+        std::unordered_map<FT_UInt, compat::Vector2f> bearings;
+        utils::LruMap<MetricsGlyphKey, GlyphPtr, MetricsGlyphKeyHasher> metricsGlyphs { MAX_METRICS_GLYPHS };
+        /// Indexed by disableHinting, null for glyphs which are not outlines
+        OutlineCache outlines[2] { OutlineCache(MAX_OUTLINES), OutlineCache(MAX_OUTLINES) };
+    };
+
+    /// FreeType size object with the matching HarfBuzz font
+    struct SizeInstance
+    {
+        font_size requestedSize;
+        font_size selectedSize;
+        FT_Size ftSize;
+        hb_font_t* hbFont;
+        Metrics metrics;
+        std::unique_ptr<SizeGlyphCache> glyphCache;
+    };
+
+    /// Maximal number of size instances kept by a face, the least recently used ones are released first.
+    static constexpr std::size_t MAX_SIZE_INSTANCES = 8;
+
     void initialize();
 
     void recreateHBFont();
 
+    Result<SizeInstance, bool> createSizeInstance(font_size size);
+    void destroySizeInstance(const SizeInstance& instance);
+
+    /// Computes the metrics of the active FreeType size.
+    Metrics computeMetrics() const;
+    /// Metrics cache of the active size, null if no size was set.
+    SizeGlyphCache* activeGlyphCache() const;
+
+    /// Renders the glyph from its cached outline, null if the glyph is not an outline.
+    GlyphPtr renderOutline(SizeGlyphCache& glyphCache, FT_UInt codepoint, const compat::Vector2f& offset,
+                           const ScaleParams& scale, const GlyphAcquisitor::Parameters& params, bool disableHinting) const;
+
     FT_Face ftFace_;
     hb_font_t* hbFont_;
 
+    /// Font source, to create other instances of the face
+    std::string filename_;
+    const compat::byte* fileBytes_ = nullptr;
+    int fileLength_ = 0;
+    FT_Long faceIndex_ = 0;
+    const Face* origin_ = nullptr;
+
+    /// Size instances ordered from the most recently used one, which is the active one.
+    std::vector<SizeInstance> sizes_;
+
     std::string postscriptName_;
 
     mutable GlyphAcquisitor::Parameters params_;
-    mutable GlyphAcquisitor acquisitor_;
+    const GlyphAcquisitor acquisitor_;
+
+    std::shared_ptr<const otf::Features> features_;
 
-    otf::Features features_;
+    mutable std::once_flag spaceShapingFlag_;
+    mutable bool spaceAffectsShaping_ = true;
 };
 
 /**
@@ -0,0 +1,97 @@
+#include "FormatRuns.h"
+
+#include <algorithm>
+
+namespace odtr {
+namespace priv {
+
+bool equalFormats(const ImmediateFormat& a, const ImmediateFormat& b)
+{
+    return
+        equalLayoutFormats(a, b) &&
+        a.color == b.color &&
+        a.decorations == b.decorations;
+}
+
+bool equalLayoutFormats(const ImmediateFormat& a, const ImmediateFormat& b)
+{
+    return
+        static_cast<const GlyphFormat&>(a) == static_cast<const GlyphFormat&>(b) &&
+        a.lineHeight == b.lineHeight &&
+        a.minLineHeight == b.minLineHeight &&
+        a.maxLineHeight == b.maxLineHeight &&
+        a.letterSpacing == b.letterSpacing &&
+        a.paragraphSpacing == b.paragraphSpacing &&
+        a.paragraphIndent == b.paragraphIndent &&
+        a.align == b.align &&
+        a.kerning == b.kerning &&
+        a.uppercase == b.uppercase &&
+        a.lowercase == b.lowercase;
+}
+
+void FormatRuns::append(int len, const ImmediateFormatPtr& format)
+{
+    if (len <= 0) {
+        return;
+    }
+
+    if (!runs_.empty() && (runs_.back().format == format || equalFormats(*runs_.back().format, *format))) {
+        runs_.back().end += len;
+    } else {
+        const int start = length();
+        runs_.push_back(Run { start, start + len, format });
+    }
+}
+
+FormatRuns FormatRuns::slice(int start, int len) const
+{
+    FormatRuns result;
+    if (len <= 0) {
+        return result;
+    }
+
+    const int end = start + len;
+    for (std::size_t i = findRun(start); i < runs_.size() && runs_[i].start < end; ++i) {
+        const int runStart = std::max(runs_[i].start, start);
+        const int runEnd = std::min(runs_[i].end, end);
+        result.runs_.push_back(Run { runStart - start, runEnd - start, runs_[i].format });
+    }
+
+    return result;
+}
+
+std::size_t FormatRuns::findRun(int pos) const
+{
+    const auto it = std::upper_bound(runs_.begin(), runs_.end(), pos, [](int p, const Run& run) {
+        return p < run.end;
+    });
+    return static_cast<std::size_t>(std::distance(runs_.begin(), it));
+}
+
+std::size_t FormatRuns::split(int pos)
+{
+    const std::size_t i = findRun(pos);
+    if (i == runs_.size() || runs_[i].start == pos) {
+        return i;
+    }
+
+    Run tail = runs_[i];
+    tail.start = pos;
+    runs_[i].end = pos;
+    runs_.insert(runs_.begin() + i + 1, std::move(tail));
+
+    return i + 1;
+}
+
+void FormatRuns::merge(std::size_t first, std::size_t last)
+{
+    for (std::size_t i = last; i > first && i < runs_.size(); --i) {
+        if (equalFormats(*runs_[i - 1].format, *runs_[i].format)) {
+            runs_[i - 1].end = runs_[i].end;
+            runs_.erase(runs_.begin() + i);
+        }
+    }
+}
+
+} // namespace priv
+} // namespace odtr
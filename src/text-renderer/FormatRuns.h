@@ -0,0 +1,89 @@
+#pragma once
+
+#include "text-format.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace odtr {
+namespace priv {
+
+/// Compares all the properties of the formats, unlike ImmediateFormat::operator== comparing only the glyph format.
+bool equalFormats(const ImmediateFormat& a, const ImmediateFormat& b);
+
+/// Compares the properties of the formats affecting the layout, all except the color and decorations.
+bool equalLayoutFormats(const ImmediateFormat& a, const ImmediateFormat& b);
+
+/**
+ * Formats of a text as runs of characters sharing a single format object.
+ *
+ * Memory and processing time depend on the number of style runs, rather than the text length.
+ * Adjacent runs always have different formats.
+ */
+class FormatRuns
+{
+public:
+    /// Characters in the range [start, end) have the format.
+    struct Run
+    {
+        int start, end;
+        ImmediateFormatPtr format;
+    };
+    using Runs = std::vector<Run>;
+
+    bool empty() const { return runs_.empty(); }
+    /// Number of characters covered by the runs.
+    int length() const { return runs_.empty() ? 0 : runs_.back().end; }
+
+    const Runs& runs() const { return runs_; }
+
+    /// Appends @a len characters, merged into the last run if the format equals.
+    void append(int len, const ImmediateFormatPtr& format);
+
+    /// Returns the runs of characters [start, start + len), with indices relative to @a start.
+    FormatRuns slice(int start, int len) const;
+
+    /// Index of the run containing the character at @a pos.
+    std::size_t findRun(int pos) const;
+
+    const ImmediateFormatPtr& formatPtrAt(int pos) const { return runs_[findRun(pos)].format; }
+    const ImmediateFormat& at(int pos) const { return *formatPtrAt(pos); }
+
+    /**
+     * Changes the format of characters [start, end). The @a modifier is called with a copy
+     * of the format of each run within the range.
+     */
+    template <typename Modifier>
+    void modify(int start, int end, const Modifier& modifier);
+
+private:
+    /// Splits the run containing @a pos, so that a run starts at @a pos. Returns index of the run.
+    std::size_t split(int pos);
+    /// Merges runs with equal formats within [first, last] run indices.
+    void merge(std::size_t first, std::size_t last);
+
+    Runs runs_;
+};
+
+template <typename Modifier>
+void FormatRuns::modify(int start, int end, const Modifier& modifier)
+{
+    if (start >= end) {
+        return;
+    }
+
+    const std::size_t first = split(start);
+    const std::size_t last = split(end);
+
+    for (std::size_t i = first; i < last; ++i) {
+        ImmediateFormat format = *runs_[i].format;
+        modifier(format);
+        runs_[i].format = std::make_shared<const ImmediateFormat>(std::move(format));
+    }
+
+    merge(first > 0 ? first - 1 : 0, last < runs_.size() ? last : runs_.size() - 1);
+}
+
+} // namespace priv
+} // namespace odtr
@@ -4,7 +4,9 @@
 #include "../fonts/FaceTable.h"
 #include "../fonts/FontManager.h"
 #include "../utils/Log.h"
+#include "../unicode/Analyzer.h"
 #include "../unicode/EmojiTable.h"
+#include "../unicode/SimpleText.h"
 
 #include <unicode/ubidi.h>
 #include <unicode/uchar.h>
@@ -19,7 +21,8 @@ using namespace compat;
 
 int FormattedParagraph::extractParagraph(FormattedParagraph& output,
                                          const qchar* string,
-                                         const ImmediateFormat* format,
+                                         const FormatRuns& format,
+                                         int start,
                                          int limit)
 {
     // 0x2029 is paragraph separator
@@ -29,13 +32,13 @@ int FormattedParagraph::extractParagraph(FormattedParagraph& output,
     auto isBreak = [&](const qchar& c) { return std::find(breaks.begin(), breaks.end(), c) != breaks.end(); };
 
     int pos = 0;
-    while (pos < limit && string[pos] != 0 && !isBreak(string[pos]))
+    while (pos < limit && string[start + pos] != 0 && !isBreak(string[start + pos]))
         ++pos;
 
     if (pos != 0)
-        output.append(string, format, pos);
+        output.append(string + start, format.slice(start, pos), pos);
     else
-        output.append(0x2028, *format); // append a blank line
+        output.append(0x2028, format.formatPtrAt(start)); // append a blank line
 
     return ++pos;
 }
@@ -51,11 +54,9 @@ const qchar* FormattedParagraph::getText() const
     return &text_[0];
 }
 
-const ImmediateFormat* FormattedParagraph::getFormat() const
+const FormatRuns& FormattedParagraph::getFormat() const
 {
-    if (format_.empty())
-        return nullptr;
-    return &format_[0];
+    return format_;
 }
 
 int FormattedParagraph::getLength() const
@@ -63,51 +64,53 @@ int FormattedParagraph::getLength() const
     return (int)text_.size();
 }
 
-void FormattedParagraph::append(qchar character, const ImmediateFormat& format)
+void FormattedParagraph::append(qchar character, const ImmediateFormatPtr& format)
 {
     text_.push_back(character);
-    this->format_.push_back(format);
+    this->format_.append(1, format);
 }
 
-void FormattedParagraph::append(const qchar* characters, const ImmediateFormat* format, int len)
+void FormattedParagraph::append(const qchar* characters, const FormatRuns& format, int len)
 {
     text_.insert(text_.end(), characters, characters + len);
-    this->format_.insert(this->format_.end(), format, format + len);
+    for (const FormatRuns::Run& run : format.runs()) {
+        this->format_.append(run.end - run.start, run.format);
+    }
 }
 
-struct UBidiHandle
+void FormattedParagraph::updateUText()
 {
-    /* implicit */ UBidiHandle(UBiDi* obj)
-        : obj(obj)
-    { }
-
-    bool operator!() const { return obj == nullptr; }
-
-    /* implicit */ operator UBiDi*() const { return obj; }
+    utext_ = ustring::fromUTF32(reinterpret_cast<const UChar32*>(text_.data()), (int) text_.size());
+}
 
-    ~UBidiHandle()
-    {
-        ubidi_close(obj);
+bool FormattedParagraph::analyzeBidi(unicode::Analyzer& analyzer)
+{
+    simple_ = unicode::isSimpleText(text_.data(), text_.size());
+    if (simple_) {
+        // the same result as of the BiDi algorithm - a single left-to-right run
+        const int len = static_cast<int>(text_.size());
+        baseDirection_ = static_cast<TextDirection>(unicode::hasStrongLeftToRight(text_.data(), text_.size()) ? UBIDI_LTR : UBIDI_NEUTRAL);
+        visualRuns_.push_back({0, len, TextDirection::LEFT_TO_RIGHT, 0.0f});
+
+        format_.modify(0, len, [](ImmediateFormat& format) {
+            format.direction = TextDirection::LEFT_TO_RIGHT;
+        });
+
+        return true;
     }
 
-private:
-    UBiDi* obj;
-};
-
-bool FormattedParagraph::analyzeBidi()
-{
     UErrorCode errorCode = U_ZERO_ERROR;
-    const ustring utext = ustring::fromUTF32(reinterpret_cast<const UChar32*>(text_.data()), (int) text_.size());
-    const int32_t uLen = utext.length();
-    const UBiDiDirection baseDir = ubidi_getBaseDirection(utext.getBuffer(), uLen);
+    updateUText();
+    const int32_t uLen = utext_.length();
+    const UBiDiDirection baseDir = ubidi_getBaseDirection(utext_.getBuffer(), uLen);
     baseDirection_ = static_cast<TextDirection>(baseDir);
-    UBidiHandle ubidi = ubidi_openSized(uLen, 0, &errorCode);
+    UBiDi* ubidi = analyzer.bidi();
 
-    if (!ubidi || U_FAILURE(errorCode)) {
+    if (!ubidi) {
         log_.warn("BiDi error: Cannot allocate structure.");
         return false;
     }
-    ubidi_setPara(ubidi, utext.getBuffer(), uLen, /*baseDir*/ UBIDI_LTR, NULL, &errorCode);
+    ubidi_setPara(ubidi, utext_.getBuffer(), uLen, /*baseDir*/ UBIDI_LTR, NULL, &errorCode);
 
     if (U_FAILURE(errorCode)) {
         log_.warn("BiDi error: Cannot perform reordering.");
@@ -125,21 +128,24 @@ bool FormattedParagraph::analyzeBidi()
         // returns the directionality of the run, UBIDI_LTR==0 or UBIDI_RTL==1, never UBIDI_MIXED, never UBIDI_NEUTRAL
         // (see docs)
         const TextDirection dir = static_cast<TextDirection>(ubidi_getVisualRun(ubidi, i, &start, &length));
-        visualRuns_.push_back({start, start + length, dir});
+        visualRuns_.push_back({start, start + length, dir, 0.0f});
     }
 
     for (const VisualRun &run : visualRuns_) {
         // i iterates over UTF-16 code units, j iterates over UTF-32 code points
-        const int32_t start = utext.getChar32Start(static_cast<int32_t>(run.start));
-        for (int32_t i = start, j = start; i < run.end; i = utext.getChar32Limit(++i), ++j) {
-            format_[j].direction = run.dir;
-        }
+        const int32_t start = utext_.getChar32Start(static_cast<int32_t>(run.start));
+        int32_t j = start;
+        for (int32_t i = start; i < run.end; i = utext_.getChar32Limit(++i), ++j) { }
+
+        format_.modify(start, j, [&run](ImmediateFormat& format) {
+            format.direction = run.dir;
+        });
     }
 
     return true;
 }
 
-void FormattedParagraph::applyFormatModifiers(FontManager& fontManager)
+void FormattedParagraph::applyFormatModifiers(const FaceTable& faces, FontManager& fontManager)
 {
     auto convertUpperCase = [](qchar& cp) {
         cp = (qchar)u_toupper((UChar32)cp);
@@ -151,36 +157,68 @@ void FormattedParagraph::applyFormatModifiers(FontManager& fontManager)
 
     const auto& emojiTable = unicode::EmojiTable::instance();
 
-    for (auto i = 0ul; i < text_.size(); ++i) {
-        if (format_[i].uppercase) {
-            convertUpperCase(text_[i]);
-        }
+    std::vector<std::size_t> emojiIndices;
+    bool textModified = false;
+
+    // faces are looked up by name only once per style run, later on by the handle
+    format_.modify(0, format_.length(), [&faces](ImmediateFormat& format) {
+        format.faceHandle = faces.getFaceHandle(format.faceId);
+    });
+
+    for (const FormatRuns::Run& run : format_.runs()) {
+        const ImmediateFormat& format = *run.format;
+        const FaceTable::Item* faceItem = faces.getFaceItem(format.faceHandle);
 
-        if (format_[i].lowercase) {
-            convertLowerCase(text_[i]);
+        for (std::size_t i = run.start; i < static_cast<std::size_t>(run.end); ++i) {
+            const qchar original = text_[i];
+
+            if (format.uppercase) {
+                convertUpperCase(text_[i]);
+            }
+
+            if (format.lowercase) {
+                convertLowerCase(text_[i]);
+            }
+
+            if (text_[i] == '\t' && format.tabStops.size() == 0) {
+                // symbol is tab, but there's no tabstop record
+                // replace tab with large space
+                text_[i] = 0x2003 /* Em space*/;
+            }
+
+            textModified = textModified || text_[i] != original;
+
+            if (requiresEmojiFont(i, faceItem, emojiTable)) {
+                emojiIndices.push_back(i);
+            }
         }
+    }
 
-        if (text_[i] == '\t' && format_[i].tabStops.size() == 0) {
-            // symbol is tab, but there's no tabstop record
-            // replace tab with large space
-            text_[i] = 0x2003 /* Em space*/;
+    if (textModified) {
+        simple_ = unicode::isSimpleText(text_.data(), text_.size());
+        if (!simple_) {
+            updateUText();
         }
+    }
 
-        resolveEmoji(i, fontManager, emojiTable);
+    if (!emojiIndices.empty()) {
+        const FaceHandle emojiFaceHandle = faces.getFaceHandle(FontManager::DEFAULT_EMOJI_FONT);
+        for (std::size_t i : emojiIndices) {
+            format_.modify(static_cast<int>(i), static_cast<int>(i) + 1, [emojiFaceHandle](ImmediateFormat& format) {
+                format.faceId = FontManager::DEFAULT_EMOJI_FONT;
+                format.faceHandle = emojiFaceHandle;
+            });
+        }
+        fontManager.setRequiresDefaultEmojiFont();
     }
 }
 
-void FormattedParagraph::resolveEmoji(std::size_t glyphIndex, FontManager& fontManager, const unicode::EmojiTable& emojiTable)
+bool FormattedParagraph::requiresEmojiFont(std::size_t glyphIndex, const FaceTable::Item* faceItem, const unicode::EmojiTable& emojiTable) const
 {
-    const FaceTable::Item* faceItem = fontManager.facesTable().getFaceItem(format_[glyphIndex].faceId);
-
     const bool hasGlyph = faceItem && faceItem->face->hasGlyph(text_[glyphIndex]);
 
     // TODO: Detect if the glyph is an SVG glyph within the font face and use default emoji font
-    if (!hasGlyph && emojiTable.lookup(text_[glyphIndex])) {
-        format_[glyphIndex].faceId = FontManager::DEFAULT_EMOJI_FONT;
-        fontManager.setRequiresDefaultEmojiFont();
-    }
+    return !hasGlyph && emojiTable.lookup(text_[glyphIndex]);
 }
 
 } // namespace priv
@@ -1,13 +1,17 @@
 #pragma once
 
 #include "base.h"
+#include "FormatRuns.h"
 #include "text-format.h"
 
 #include "VisualRun.h"
 
+#include "../fonts/FaceTable.h"
+
 namespace odtr {
 
 namespace unicode {
+class Analyzer;
 class EmojiTable;
 }
 
@@ -20,36 +24,47 @@ class FontManager;
 namespace priv {
 
 /**
- * Internal representation of a single paragraph, with format properties evaluated for each character.
+ * Internal representation of a single paragraph, with format properties evaluated into style runs.
  */
 class FormattedParagraph
 {
     friend class ParagraphShape;
 
 public:
-    static int extractParagraph(FormattedParagraph& output, const compat::qchar* string, const ImmediateFormat* format, int limit);
+    /**
+     * Extracts a paragraph starting at @a start from the text, up to @a limit characters.
+     *
+     * @return  number of characters consumed, including the paragraph separator
+     */
+    static int extractParagraph(FormattedParagraph& output, const compat::qchar* string, const FormatRuns& format, int start, int limit);
 
     explicit FormattedParagraph(const utils::Log& log);
     const compat::qchar* getText() const;
-    const ImmediateFormat* getFormat() const;
+    const FormatRuns& getFormat() const;
     int getLength() const;
-    void append(compat::qchar character, const ImmediateFormat& format);
-    void append(const compat::qchar* characters, const ImmediateFormat* format, int len);
+    void append(compat::qchar character, const ImmediateFormatPtr& format);
+    void append(const compat::qchar* characters, const FormatRuns& format, int len);
     /// Use the Unicode Bidirectional Algorithm and get visual runs.
-    bool analyzeBidi();
-    void applyFormatModifiers(FontManager& fontManager);
+    bool analyzeBidi(unicode::Analyzer& analyzer);
+    void applyFormatModifiers(const FaceTable& faces, FontManager& fontManager);
 
 private:
+    /// Converts the text to UTF-16, shared by the BiDi and line breaking analysis.
+    void updateUText();
+
     /**
-     * If a glyph at given @a glyphIndex encodes an emoji symbol and it's not contained in the original face,
-     * the face used is set to default emoji instead.
+     * If a glyph at given @a glyphIndex encodes an emoji symbol and it's not contained in the original face
+     * given by @a faceItem, the default emoji face has to be used instead.
      */
-    void resolveEmoji(std::size_t glyphIndex, FontManager& fontManager, const unicode::EmojiTable& emojiTable);
+    bool requiresEmojiFont(std::size_t glyphIndex, const FaceTable::Item* faceItem, const unicode::EmojiTable& emojiTable) const;
 
     const utils::Log& log_;
 
     std::vector<compat::qchar> text_;
-    std::vector<ImmediateFormat> format_;
+    /// UTF-16 text, only for text which is not simple, see unicode::isSimpleText
+    ustring utext_;
+    bool simple_ = false;
+    FormatRuns format_;
     std::vector<VisualRun> visualRuns_;
     TextDirection baseDirection_;
 };
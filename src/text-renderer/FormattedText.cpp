@@ -14,6 +14,17 @@ namespace priv {
 
 using namespace compat;
 
+bool FormattedText::FormattingParams::operator==(const FormattingParams& other) const
+{
+    return
+        verticalAlign == other.verticalAlign &&
+        boundsMode == other.boundsMode &&
+        baseline == other.baseline &&
+        horizontalPositioning == other.horizontalPositioning &&
+        baselinePolicy == other.baselinePolicy &&
+        overflowPolicy == other.overflowPolicy;
+}
+
 FormattedText::FormattedText(VerticalAlign verticalAlign,
                              BoundsMode boundsMode,
                              float baseline,
@@ -167,7 +178,7 @@ void FormattedText::addFormatModifier(const FormatModifier& formatModifier)
     formatModifiers_.push_back(formatModifier);
 }
 
-void FormattedText::generateFormat(std::vector<ImmediateFormat>& format) const
+FormatRuns FormattedText::generateFormat() const
 {
     // update modifier values to account for various multi byte encoding
     // octopus is utf-8 while the modifier ranges are utf-16
@@ -180,75 +191,116 @@ void FormattedText::generateFormat(std::vector<ImmediateFormat>& format) const
         cumulativeLengths.push_back(cumulativeLengths[i] + utf16CharSize);
     }
 
-    const unsigned int textLen = static_cast<unsigned int>(text_.size());
-    format.assign(textLen, baseFormat_);
-
+    const int textLen = static_cast<int>(text_.size());
+
+    // UTF-16 offset to a character index, offsets within a character or past the text are ignored
+    const auto toCharIndex = [&cumulativeLengths, textLen](int utf16Offset) {
+        const auto it = std::lower_bound(cumulativeLengths.begin(), cumulativeLengths.end(), utf16Offset);
+        return (it != cumulativeLengths.end() && *it == utf16Offset)
+            ? static_cast<int>(std::distance(cumulativeLengths.begin(), it))
+            : textLen + 1;
+    };
+
+    struct ModifierRange
+    {
+        int start, end;
+    };
+    std::vector<ModifierRange> ranges;
+    ranges.reserve(formatModifiers_.size());
+
+    // characters between two subsequent boundaries are affected by the same modifiers
+    std::vector<int> boundaries = { 0, textLen };
     for (const FormatModifier& modifier : formatModifiers_) {
-        auto pos = std::distance(cumulativeLengths.begin(),
-                                 std::find(cumulativeLengths.begin(), cumulativeLengths.end(), modifier.range.start));
-        auto end = std::distance(cumulativeLengths.begin(),
-                                 std::find(cumulativeLengths.begin(), cumulativeLengths.end(), modifier.range.end));
-
-        for (; pos < end && pos < textLen; ++pos) {
-            if (modifier.types & FormatModifier::FACE) {
-                format[pos].faceId = modifier.face;
-            }
-            if (modifier.types & FormatModifier::SIZE) {
-                format[pos].size = modifier.size;
-            }
-            if (modifier.types & FormatModifier::LINE_HEIGHT) {
-                format[pos].lineHeight = modifier.lineHeight;
-                format[pos].minLineHeight = modifier.minLineHeight;
-                format[pos].maxLineHeight = modifier.maxLineHeight;
-            }
-            if (modifier.types & FormatModifier::LETTER_SPACING) {
-                format[pos].letterSpacing = modifier.letterSpacing;
-            }
-            if (modifier.types & FormatModifier::PARAGRAPH_SPACING) {
-                format[pos].paragraphSpacing = modifier.paragraphSpacing;
-            }
-            if (modifier.types & FormatModifier::COLOR) {
-                format[pos].color = modifier.color;
-            }
-            if (modifier.types & FormatModifier::DECORATION) {
-                if (modifier.decoration != Decoration::NONE) {
-                    format[pos].decorations.emplace_back(modifier.decoration);
-                }
-            }
-            if (modifier.types & FormatModifier::ALIGN) {
-                format[pos].align = modifier.align;
-            }
-            if (modifier.types & FormatModifier::KERNING) {
-                format[pos].kerning = modifier.kerning;
-            }
-            if (modifier.types & FormatModifier::LIGATURES) {
-                format[pos].ligatures = modifier.ligatures;
-            }
-            if (modifier.types & FormatModifier::UPPERCASE) {
-                format[pos].uppercase = modifier.uppercase;
-                format[pos].lowercase = !modifier.uppercase;
-            }
-            if (modifier.types & FormatModifier::LOWERCASE) {
-                format[pos].lowercase = modifier.lowercase;
-                format[pos].uppercase = !modifier.lowercase;
-            }
-            if (modifier.types & FormatModifier::TYPE_FEATURE) {
-                format[pos].features = modifier.features;
-            }
-            if (modifier.types & FormatModifier::TAB_STOPS) {
-                format[pos].tabStops = modifier.tabStops;
+        const int start = toCharIndex(modifier.range.start);
+        const int end = std::min(toCharIndex(modifier.range.end), textLen);
+        ranges.push_back(ModifierRange { start, end });
+        if (start < end) {
+            boundaries.push_back(start);
+            boundaries.push_back(end);
+        }
+    }
+    std::sort(boundaries.begin(), boundaries.end());
+    boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+
+    FormatRuns format;
+    const ImmediateFormatPtr baseFormat = std::make_shared<const ImmediateFormat>(baseFormat_);
+
+    for (std::size_t b = 0; b + 1 < boundaries.size(); ++b) {
+        const int start = boundaries[b];
+        const int end = boundaries[b + 1];
+
+        ImmediateFormatPtr runFormat = baseFormat;
+        for (std::size_t m = 0; m < formatModifiers_.size(); ++m) {
+            if (ranges[m].start <= start && end <= ranges[m].end) {
+                ImmediateFormat modified = *runFormat;
+                applyFormatModifier(modified, formatModifiers_[m]);
+                runFormat = std::make_shared<const ImmediateFormat>(std::move(modified));
             }
         }
+
+        format.append(end - start, runFormat);
+    }
+
+    return format;
+}
+
+void FormattedText::applyFormatModifier(ImmediateFormat& format, const FormatModifier& modifier)
+{
+    if (modifier.types & FormatModifier::FACE) {
+        format.faceId = modifier.face;
+    }
+    if (modifier.types & FormatModifier::SIZE) {
+        format.size = modifier.size;
+    }
+    if (modifier.types & FormatModifier::LINE_HEIGHT) {
+        format.lineHeight = modifier.lineHeight;
+        format.minLineHeight = modifier.minLineHeight;
+        format.maxLineHeight = modifier.maxLineHeight;
+    }
+    if (modifier.types & FormatModifier::LETTER_SPACING) {
+        format.letterSpacing = modifier.letterSpacing;
+    }
+    if (modifier.types & FormatModifier::PARAGRAPH_SPACING) {
+        format.paragraphSpacing = modifier.paragraphSpacing;
+    }
+    if (modifier.types & FormatModifier::COLOR) {
+        format.color = modifier.color;
+    }
+    if (modifier.types & FormatModifier::DECORATION) {
+        if (modifier.decoration != Decoration::NONE) {
+            format.decorations.emplace_back(modifier.decoration);
+        }
+    }
+    if (modifier.types & FormatModifier::ALIGN) {
+        format.align = modifier.align;
+    }
+    if (modifier.types & FormatModifier::KERNING) {
+        format.kerning = modifier.kerning;
+    }
+    if (modifier.types & FormatModifier::LIGATURES) {
+        format.ligatures = modifier.ligatures;
+    }
+    if (modifier.types & FormatModifier::UPPERCASE) {
+        format.uppercase = modifier.uppercase;
+        format.lowercase = !modifier.uppercase;
+    }
+    if (modifier.types & FormatModifier::LOWERCASE) {
+        format.lowercase = modifier.lowercase;
+        format.uppercase = !modifier.lowercase;
+    }
+    if (modifier.types & FormatModifier::TYPE_FEATURE) {
+        format.features = modifier.features;
+    }
+    if (modifier.types & FormatModifier::TAB_STOPS) {
+        format.tabStops = modifier.tabStops;
     }
 }
 
 ImmediateFormat FormattedText::firstFormat() const
 {
-    std::vector<ImmediateFormat> textFormat;
-    generateFormat(textFormat);
+    const FormatRuns textFormat = generateFormat();
 
-    return textFormat.empty() ? baseFormat_ : textFormat[0];
-    return textFormat[0];
+    return textFormat.empty() ? baseFormat_ : *textFormat.runs().front().format;
 }
 
 const FormattedText::FormattingParams &FormattedText::formattingParams() const {
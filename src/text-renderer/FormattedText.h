@@ -7,6 +7,7 @@
 
 #include "../compat/basic-types.h"
 
+#include "FormatRuns.h"
 #include "text-format.h"
 
 
@@ -32,6 +33,9 @@ public:
         HorizontalPositionPolicy horizontalPositioning;
         BaselinePolicy baselinePolicy;
         OverflowPolicy overflowPolicy;
+
+        bool operator==(const FormattingParams& other) const;
+        bool operator!=(const FormattingParams& other) const { return !(*this == other); }
     };
 
     FormattedText(VerticalAlign verticalAlign,
@@ -66,7 +70,8 @@ public:
     void resetText(const std::string& str);
     void commitText();
     void addFormatModifier(const FormatModifier& formatModifier);
-    void generateFormat(std::vector<ImmediateFormat>& format) const;
+    /// Evaluates the format modifiers into style runs.
+    FormatRuns generateFormat() const;
     ImmediateFormat firstFormat() const;
 
     const FormattingParams &formattingParams() const;
@@ -98,6 +103,8 @@ private:
 
     compat::qchar replace(compat::qchar cp);
 
+    static void applyFormatModifier(ImmediateFormat& format, const FormatModifier& modifier);
+
     void scale(float scale);
 
     ImmediateFormat baseFormat_;
@@ -18,13 +18,13 @@ bool FreetypeHandle::initialize() {
                       FREETYPE_PATCH,
                       HB_VERSION_STRING);
     */
-    error = FT_Init_FreeType(&ft_);
-    return checkOk(__func__);
+    const FT_Error error = FT_Init_FreeType(&ft_);
+    return checkOk(error, __func__);
 }
 
 void FreetypeHandle::deinitialize() {
-    error = FT_Done_FreeType(ft_);
-    checkOk(__func__);
+    const FT_Error error = FT_Done_FreeType(ft_);
+    checkOk(error, __func__);
 }
 
 FreetypeHandle::operator FT_Library() const {
@@ -81,7 +81,7 @@ const char* FreetypeHandle::getErrorMessage(FT_Error err)
     return "Unknown Freetype error";
 }
 
-bool FreetypeHandle::checkOk(const char* func)
+bool FreetypeHandle::checkOk(FT_Error error, const char* func)
 {
     if (error == FT_Err_Ok) {
         return true;
@@ -89,10 +89,7 @@ bool FreetypeHandle::checkOk(const char* func)
 
     // FT Error codes: https://freetype.org/freetype2/docs/reference/ft2-error_code_values.html
     // Log::instance.logf(Log::TEXT_RENDERER, Log::ERROR, "Freetype error in function %s: (%d) %s.", func, error, getErrorMessage(error));
-    error = FT_Err_Ok;
     return false;
 }
 
-FT_Error FreetypeHandle::error = FT_Err_Ok;
-
 } // namespace odtr
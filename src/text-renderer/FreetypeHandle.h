@@ -31,9 +31,8 @@ public:
     static FT_F26Dot6 ceil26_6 (FT_F26Dot6 x) { return (x + 63) & -64; } ///< See FreeType outlines tutorial
 
     static const char* getErrorMessage(FT_Error err);
-    static bool checkOk(const char* func);
-
-    static FT_Error error;
+    /// Checks the error code returned by a FreeType call made in @a func.
+    static bool checkOk(FT_Error error, const char* func);
 
 private:
     FT_Library ft_;
@@ -1,7 +1,9 @@
 #include "Glyph.h"
 #include "../compat/bitmap-ops.hpp"
+#include "../compat/blend-ops.h"
 #include "../compat/pixel-conversion.h"
 
+#include <algorithm>
 #include <cmath>
 
 namespace odtr {
@@ -171,6 +173,15 @@ bool ColorGlyph::putBitmap(const FT_Bitmap &bitmap) {
     return true;
 }
 
+/// Returns the part of a bitmap placed at @a pos which lies within the destination, in bitmap coordinates.
+static Rectangle clipToDestination(const IPoint2& pos, int width, int height, const IDims2& dDims) {
+    const int l = std::max(0, -pos.x);
+    const int t = std::max(0, -pos.y);
+    const int r = std::min(width, dDims.x - pos.x);
+    const int b = std::min(height, dDims.y - pos.y);
+    return { l, t, r - l, b - t };
+}
+
 void GrayGlyph::blit(Pixel32* dst, const IDims2& dDims, const Vector2i& offset) const
 {
     if (!bitmap_ || !bitmap_->pixels()) {
@@ -183,38 +194,16 @@ void GrayGlyph::blit(Pixel32* dst, const IDims2& dDims, const Vector2i& offset)
         return;
     }
 
-    Color premultipliedColor = pixelToColor(color_);
-    premultipliedColor.r *= premultipliedColor.a;
-    premultipliedColor.g *= premultipliedColor.a;
-    premultipliedColor.b *= premultipliedColor.a;
-
-    Pixel8 *src = bitmap_->pixels();
-
-    for (int sy = 0; sy < bitmap_->height(); ++sy) {
-        for (int sx = 0; sx < bitmap_->width(); ++sx, ++src) {
-            const int dx = destPos_.x + sx + offset.x;
-            const int dy = destPos_.y + sy + offset.y;
-
-            if (dx < 0 || dy < 0 || dx >= dDims.x || dy >= dDims.y) {
-                continue;
-            }
-
-            const float letterAlpha = *src / 255.f;
-            Color srcColor = premultipliedColor;
-            srcColor.r *= letterAlpha;
-            srcColor.g *= letterAlpha;
-            srcColor.b *= letterAlpha;
-            srcColor.a *= letterAlpha;
-
-            Color dstColor = pixelToColor(dst[dDims.x * dy + dx]);
-            dstColor.r *= 1 - srcColor.a;
-            dstColor.g *= 1 - srcColor.a;
-            dstColor.b *= 1 - srcColor.a;
-            dstColor.a *= 1 - srcColor.a;
-
-            dst[dDims.x * dy + dx] = colorToPixel(srcColor + dstColor);
-        }
+    const IPoint2 pos = destPos_ + offset;
+    const Rectangle area = clipToDestination(pos, bitmap_->width(), bitmap_->height(), dDims);
+    if (area.w <= 0 || area.h <= 0) {
+        return;
     }
+
+    blendMask(dst + dDims.x * (pos.y + area.t) + pos.x + area.l, dDims.x,
+              bitmap_->pixels() + bitmap_->width() * area.t + area.l, bitmap_->width(),
+              area.w, area.h,
+              color_);
 }
 
 void ColorGlyph::blit(Pixel32* dst, const IDims2& dDims, const Vector2i& offset) const
@@ -229,29 +218,26 @@ void ColorGlyph::blit(Pixel32* dst, const IDims2& dDims, const Vector2i& offset)
         return;
     }
 
-    Pixel32 *src = bitmap_->pixels();
-
-    for (int sy = 0; sy < bitmap_->height(); ++sy) {
-        for (int sx = 0; sx < bitmap_->width(); ++sx, ++src) {
-            const int dx = destPos_.x + sx + offset.x;
-            const int dy = destPos_.y + sy + offset.y;
-
-            if (dx < 0 || dy < 0 || dx >= dDims.x || dy >= dDims.y) {
-                continue;
-            }
+    const IPoint2 pos = destPos_ + offset;
+    const Rectangle area = clipToDestination(pos, bitmap_->width(), bitmap_->height(), dDims);
+    if (area.w <= 0 || area.h <= 0) {
+        return;
+    }
 
-            // color glyphs are already alpha premultiplied
-            const Color srcColor = pixelToColor(*src);
+    // color glyphs are already alpha premultiplied
+    blendPremultiplied(dst + dDims.x * (pos.y + area.t) + pos.x + area.l, dDims.x,
+                       bitmap_->pixels() + bitmap_->width() * area.t + area.l, bitmap_->width(),
+                       area.w, area.h);
+}
 
-            Color dstColor = compat::pixelToColor(dst[dDims.x * dy + dx]);
-            dstColor.r *= 1 - srcColor.a;
-            dstColor.g *= 1 - srcColor.a;
-            dstColor.b *= 1 - srcColor.a;
-            dstColor.a *= 1 - srcColor.a;
+std::size_t GrayGlyph::bitmapByteSize() const
+{
+    return bitmap_ ? sizeof(Pixel8) * bitmap_->width() * bitmap_->height() : 0;
+}
 
-            dst[dDims.x * dy + dx] = colorToPixel(srcColor + dstColor);
-        }
-    }
+std::size_t ColorGlyph::bitmapByteSize() const
+{
+    return bitmap_ ? sizeof(Pixel32) * bitmap_->width() * bitmap_->height() : 0;
 }
 
 void GrayGlyph::scaleBitmap(float scale)
@@ -278,4 +264,32 @@ void ColorGlyph::scaleBitmap(float scale)
     }
 }
 
+bool MetricsGlyph::putBitmap(const FT_Bitmap &bitmap)
+{
+    width_ = (int) bitmap.width;
+    height_ = (int) bitmap.rows;
+    if (color_) {
+        // the same pixel modes as in ColorGlyph::putBitmap
+        switch (bitmap.pixel_mode) {
+            case FT_PIXEL_MODE_NONE:
+                return false;
+            case FT_PIXEL_MODE_LCD:
+                width_ = (int) (bitmap.width/3);
+                break;
+            case FT_PIXEL_MODE_LCD_V:
+                height_ = (int) (bitmap.rows/3);
+                break;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+void MetricsGlyph::scaleBitmap(float scale)
+{
+    width_ = (int) ceilf(scale*(float) width_);
+    height_ = (int) ceilf(scale*(float) height_);
+}
+
 } // namespace odtr
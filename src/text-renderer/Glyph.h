@@ -19,6 +19,9 @@ public:
     virtual void setColor(const Pixel32& c) = 0;
     virtual bool putBitmap(const FT_Bitmap &bitmap) = 0;
     virtual void scaleBitmap(float scale) = 0;
+    /// Copy of the glyph sharing the same bitmap.
+    virtual std::unique_ptr<Glyph> clone() const = 0;
+    virtual std::size_t bitmapByteSize() const = 0;
 
     void setDestination(const IPoint2& p);
     const IPoint2 &getDestination() const;
@@ -52,6 +55,8 @@ public:
     void setColor(const Pixel32& color) override { color_ = color; }
     bool putBitmap(const FT_Bitmap &bitmap) override;
     void scaleBitmap(float scale) override;
+    std::unique_ptr<Glyph> clone() const override { return std::make_unique<GrayGlyph>(*this); }
+    std::size_t bitmapByteSize() const override;
 
 private:
     compat::BitmapGrayscalePtr bitmap_;
@@ -71,10 +76,35 @@ public:
     void setColor(const Pixel32& color) override { alpha_ = color >> 24 & 0xff; }
     bool putBitmap(const FT_Bitmap &bitmap) override;
     void scaleBitmap(float scale) override;
+    std::unique_ptr<Glyph> clone() const override { return std::make_unique<ColorGlyph>(*this); }
+    std::size_t bitmapByteSize() const override;
 
 private:
     compat::BitmapRGBAPtr bitmap_;
     Pixel32 alpha_;
 };
 
+//! Carries glyph metrics and the dimensions of its bitmap without rasterizing it
+class MetricsGlyph : public Glyph
+{
+public:
+    //! @param color    Whether the dimensions are those of a ColorGlyph or a GrayGlyph
+    explicit MetricsGlyph(bool color) : color_(color) {}
+
+    void blit(Pixel32*, const IDims2&, const compat::Vector2i&) const override {}
+    int bitmapHeight() const override { return height_; }
+    int bitmapWidth() const override { return width_; }
+    void setColor(const Pixel32&) override {}
+    //! Only takes over the dimensions the rendered glyph would have, the pixel buffer may be empty (preset by FT_Load_Glyph)
+    bool putBitmap(const FT_Bitmap &bitmap) override;
+    void scaleBitmap(float scale) override;
+    std::unique_ptr<Glyph> clone() const override { return std::make_unique<MetricsGlyph>(*this); }
+    std::size_t bitmapByteSize() const override { return 0; }
+
+private:
+    bool color_;
+    int width_ = 0;
+    int height_ = 0;
+};
+
 } // namespace odtr
@@ -57,33 +57,29 @@ GlyphAcquisitor::GlyphAcquisitor()
 {
 }
 
-void GlyphAcquisitor::setup(const Parameters& params, FT_Face ftFace)
+GlyphPtr GlyphAcquisitor::acquire(FT_Face ftFace, const Parameters& params, FT_UInt codepoint, const Vector2f& offset, const ScaleParams& scale, bool render) const
 {
-    params_ = params;
-    ftFace_ = ftFace;
-}
-
-GlyphPtr GlyphAcquisitor::acquire(FT_UInt codepoint, const Vector2f& offset, const ScaleParams& scale, bool render) const
-{
-    const Result<FT_GlyphSlot, bool> slotResult = acquireSlot(codepoint, offset, scale.vectorScale);
+    const Result<FT_GlyphSlot, bool> slotResult = acquireSlot(ftFace, params, codepoint, offset, scale.vectorScale);
     if (!slotResult) {
         return nullptr;
     }
 
     const FT_GlyphSlot glyphSlot = slotResult.value();
 
-    // Fail if the glyph not a supported type. TODO: Add support for rendering SVG glyphs
-    if (render && !(glyphSlot->format == FT_GLYPH_FORMAT_COMPOSITE || glyphSlot->format == FT_GLYPH_FORMAT_BITMAP || glyphSlot->format == FT_GLYPH_FORMAT_OUTLINE)) {
+    // Fail if the glyph not a supported type, without rendering as well so that the layout matches. TODO: Add support for rendering SVG glyphs
+    if (!(glyphSlot->format == FT_GLYPH_FORMAT_COMPOSITE || glyphSlot->format == FT_GLYPH_FORMAT_BITMAP || glyphSlot->format == FT_GLYPH_FORMAT_OUTLINE)) {
         return nullptr;
     }
 
-    GlyphPtr glyph = createGlyph(glyphSlot);
+    // Without rendering, FT_Load_Glyph has already preset the bitmap dimensions and bearings of outline glyphs,
+    // which are the same FT_Render_Glyph produces. Bitmap glyphs are loaded as is.
+    GlyphPtr glyph = render ? createGlyph(params, glyphSlot) : std::make_unique<MetricsGlyph>(params.isColor);
 
     const bool bitmapGlyph = glyphSlot->format == FT_GLYPH_FORMAT_BITMAP; // format will change after FT_Render_Glyph
 
-    if (params_.scalable && render) {
-        FreetypeHandle::error = FT_Render_Glyph(glyphSlot, FT_RENDER_MODE_LIGHT);
-        const bool isRendered = FreetypeHandle::checkOk(__func__);
+    if (params.scalable && render) {
+        const FT_Error error = FT_Render_Glyph(glyphSlot, FT_RENDER_MODE_LIGHT);
+        const bool isRendered = FreetypeHandle::checkOk(error, __func__);
         if (!isRendered) {
             return nullptr;
         }
@@ -91,17 +87,15 @@ GlyphPtr GlyphAcquisitor::acquire(FT_UInt codepoint, const Vector2f& offset, con
 
     RenderScale bmpScaleFactor = scale.bitmapScale;
 
-    if (render) {
-        if (!glyph->putBitmap(glyphSlot->bitmap)) {
-            return nullptr;
-        }
-
-        if (bitmapGlyph && params_.scalable)
-            bmpScaleFactor *= scale.vectorScale;
-        if (bmpScaleFactor != 1.f)
-            glyph->scaleBitmap(bmpScaleFactor);
+    if (!glyph->putBitmap(glyphSlot->bitmap)) {
+        return nullptr;
     }
 
+    if (bitmapGlyph && params.scalable)
+        bmpScaleFactor *= scale.vectorScale;
+    if (bmpScaleFactor != 1.f)
+        glyph->scaleBitmap(bmpScaleFactor);
+
     const RenderScale k = bmpScaleFactor;
     glyph->bitmapBearing.x = int(glyphSlot->bitmap_left * k);
     glyph->bitmapBearing.y = int(glyphSlot->bitmap_top * k);
@@ -113,23 +107,113 @@ GlyphPtr GlyphAcquisitor::acquire(FT_UInt codepoint, const Vector2f& offset, con
     return glyph;
 }
 
-Result<FT_GlyphSlot,bool> GlyphAcquisitor::acquireSlot(FT_UInt codepoint, const Vector2f& offset, RenderScale scale) const
+GlyphAcquisitor::LoadedOutline::~LoadedOutline()
+{
+    if (glyph != nullptr) {
+        FT_Done_Glyph(glyph);
+    }
+}
+
+GlyphAcquisitor::LoadedOutlinePtr GlyphAcquisitor::loadOutline(FT_Face ftFace, const Parameters& params, FT_UInt codepoint) const
+{
+    // color layers are only rendered from a glyph slot
+    if (!params.scalable || params.isColor) {
+        return nullptr;
+    }
+
+    const Result<FT_GlyphSlot, bool> slotResult = acquireSlot(ftFace, params, codepoint, {}, 1.0f);
+    if (!slotResult || slotResult.value()->format != FT_GLYPH_FORMAT_OUTLINE) {
+        return nullptr;
+    }
+
+    const FT_GlyphSlot glyphSlot = slotResult.value();
+
+    auto outline = std::make_unique<LoadedOutline>();
+    const FT_Error error = FT_Get_Glyph(glyphSlot, &outline->glyph);
+    if (!FreetypeHandle::checkOk(error, __func__)) {
+        return nullptr;
+    }
+
+    outline->lsbDelta = glyphSlot->lsb_delta;
+    outline->rsbDelta = glyphSlot->rsb_delta;
+    outline->metrics = glyphSlot->metrics;
+
+    return outline;
+}
+
+GlyphPtr GlyphAcquisitor::render(const LoadedOutline& outline, const Vector2f& offset, const ScaleParams& scale) const
+{
+    FT_Glyph ftGlyph = nullptr;
+    FT_Error error = FT_Glyph_Copy(outline.glyph, &ftGlyph);
+    if (!FreetypeHandle::checkOk(error, __func__)) {
+        return nullptr;
+    }
+
+    // the same transformation FT_Load_Glyph applies to the outline, followed by FT_Render_Glyph
+    FT_Matrix matrix = transformMatrix(scale.vectorScale);
+    FT_Vector delta = transformDelta(offset);
+    error = FT_Glyph_Transform(ftGlyph, &matrix, &delta);
+    if (FreetypeHandle::checkOk(error, __func__)) {
+        error = FT_Glyph_To_Bitmap(&ftGlyph, FT_RENDER_MODE_LIGHT, nullptr, 1);
+    }
+    if (!FreetypeHandle::checkOk(error, __func__)) {
+        FT_Done_Glyph(ftGlyph);
+        return nullptr;
+    }
+
+    const FT_BitmapGlyph bitmapGlyph = reinterpret_cast<FT_BitmapGlyph>(ftGlyph);
+
+    GlyphPtr glyph = std::make_unique<GrayGlyph>();
+    const bool hasBitmap = glyph->putBitmap(bitmapGlyph->bitmap);
+    const int bitmapLeft = bitmapGlyph->left;
+    const int bitmapTop = bitmapGlyph->top;
+    FT_Done_Glyph(ftGlyph);
+
+    if (!hasBitmap) {
+        return nullptr;
+    }
+
+    const RenderScale k = scale.bitmapScale;
+    if (k != 1.f)
+        glyph->scaleBitmap(k);
+
+    glyph->bitmapBearing.x = int(bitmapLeft * k);
+    glyph->bitmapBearing.y = int(bitmapTop * k);
+    glyph->lsb_delta = FreetypeHandle::from26_6fixed(FT_F26Dot6(outline.lsbDelta * k));
+    glyph->rsb_delta = FreetypeHandle::from26_6fixed(FT_F26Dot6(outline.rsbDelta * k));
+    glyph->metricsBearing.x = FreetypeHandle::from26_6fixed(FT_F26Dot6(outline.metrics.horiBearingX));
+    glyph->metricsBearing.y = FreetypeHandle::from26_6fixed(FT_F26Dot6(outline.metrics.horiBearingY));
+
+    return glyph;
+}
+
+FT_Matrix GlyphAcquisitor::transformMatrix(RenderScale scale)
 {
-    FT_Matrix matrix = {FreetypeHandle::to16_16fixed(scale), 0, 0, FreetypeHandle::to16_16fixed(scale)};
-    FT_Vector delta = {
+    return FT_Matrix {FreetypeHandle::to16_16fixed(scale), 0, 0, FreetypeHandle::to16_16fixed(scale)};
+}
+
+FT_Vector GlyphAcquisitor::transformDelta(const Vector2f& offset)
+{
+    return FT_Vector {
         static_cast<FT_Pos>(FreetypeHandle::to26_6fixed(offset.x)),
        -static_cast<FT_Pos>(FreetypeHandle::to26_6fixed(offset.y))
     };
+}
+
+Result<FT_GlyphSlot,bool> GlyphAcquisitor::acquireSlot(FT_Face ftFace, const Parameters& params, FT_UInt codepoint, const Vector2f& offset, RenderScale scale) const
+{
+    FT_Matrix matrix = transformMatrix(scale);
+    FT_Vector delta = transformDelta(offset);
 
-    FT_Set_Transform(ftFace_, &matrix, &delta);
+    FT_Set_Transform(ftFace, &matrix, &delta);
 
-    FreetypeHandle::error = FT_Load_Glyph(ftFace_, codepoint, params_.loadflags);
-    const bool isLoaded = FreetypeHandle::checkOk(__func__);
+    const FT_Error error = FT_Load_Glyph(ftFace, codepoint, params.loadflags);
+    const bool isLoaded = FreetypeHandle::checkOk(error, __func__);
     if (!isLoaded) {
         return false;
     }
 
-    return ftFace_->glyph;
+    return ftFace->glyph;
 }
 
 /*
@@ -144,19 +228,19 @@ Path GlyphAcquisitor::acquireOutline(const FT_GlyphSlot& glyphSlot) const
     }
 
     FT_Glyph ftGlyph;
-    FreetypeHandle::error = FT_Get_Glyph(ftFace_->glyph, &ftGlyph);
-    FreetypeHandle::checkOk(__func__);
+    FT_Error error = FT_Get_Glyph(ftFace_->glyph, &ftGlyph);
+    FreetypeHandle::checkOk(error, __func__);
 
     auto ftOutline = reinterpret_cast<FT_OutlineGlyph>(ftGlyph)->outline; // 26.6 pixels
 
     Decompositor decompositor;
-    FreetypeHandle::error = FT_Outline_Decompose(&ftOutline, &funcs_, &decompositor);
-    FreetypeHandle::checkOk(__func__);
+    error = FT_Outline_Decompose(&ftOutline, &funcs_, &decompositor);
+    FreetypeHandle::checkOk(error, __func__);
 
     // get bounds
     FT_BBox ftBBox;
-    FreetypeHandle::error = FT_Outline_Get_BBox(&ftOutline, &ftBBox);
-    if (!FreetypeHandle::checkOk(__func__)) {
+    error = FT_Outline_Get_BBox(&ftOutline, &ftBBox);
+    if (!FreetypeHandle::checkOk(error, __func__)) {
         Log::instance.log(Log::TEXT_RENDERER, Log::WARNING, "Outline acquisition: cannot get bounds.");
         return DUMMY.clone();
     }
@@ -184,11 +268,11 @@ Path GlyphAcquisitor::acquireOutline(const FT_GlyphSlot& glyphSlot) const
 }
 */
 
-GlyphPtr GlyphAcquisitor::createGlyph(FT_GlyphSlot glyphSlot) const
+GlyphPtr GlyphAcquisitor::createGlyph(const Parameters& params, FT_GlyphSlot glyphSlot) const
 {
-    if (params_.isColor) {
+    if (params.isColor) {
         #if (FREETYPE_MAJOR > 2 || (FREETYPE_MAJOR == 2 && FREETYPE_MINOR >= 10))
-        if (glyphSlot->glyph_index && glyphSlot->bitmap.pixel_mode != FT_PIXEL_MODE_BGRA && !params_.cpalUsed) {
+        if (glyphSlot->glyph_index && glyphSlot->bitmap.pixel_mode != FT_PIXEL_MODE_BGRA && !params.cpalUsed) {
             // REFACTOR
             // Log::instance.logf(Log::TEXT_RENDERER, Log::INFORMATION, "Suspicious pixel mode.");
         }
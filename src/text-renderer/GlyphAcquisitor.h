@@ -5,6 +5,8 @@
 
 #include "../common/result.hpp"
 
+#include <memory>
+
 namespace odtr {
 
 struct ScaleParams
@@ -22,6 +24,8 @@ struct Decompositor
 
 /**
  * @brief Manages glyph retrieval, transformation and rendering.
+ *
+ * The acquisitor holds no state of its own, the face and its parameters are passed to each call.
  */
 class GlyphAcquisitor
 {
@@ -42,27 +46,54 @@ public:
         FT_Int32 loadflags = FT_LOAD_DEFAULT;
     };
 
+    /**
+     * Outline of a glyph loaded at a size without any transformation, to be rendered at any offset and scale.
+     * Keeps the values of the glyph slot rendering needs besides the outline.
+     */
+    struct LoadedOutline
+    {
+        LoadedOutline() = default;
+        LoadedOutline(const LoadedOutline&) = delete;
+        ~LoadedOutline();
+        LoadedOutline& operator=(const LoadedOutline&) = delete;
+
+        FT_Glyph glyph = nullptr;
+        FT_Pos lsbDelta = 0;
+        FT_Pos rsbDelta = 0;
+        FT_Glyph_Metrics metrics {};
+    };
+    using LoadedOutlinePtr = std::unique_ptr<const LoadedOutline>;
+
     GlyphAcquisitor();
 
     /**
-     * @brief Call this before calling acquire() to ensure correct retrieval of glyph.
+     * @brief See Face::acquireGlyph() for info.
      *
-     * @param params    Retrieve from Face
      * @param ftFace    Retrieve from Face
+     * @param params    Retrieve from Face
      */
-    void setup(const Parameters& params, FT_Face ftFace);
+    GlyphPtr acquire(FT_Face ftFace, const Parameters& params, FT_UInt codepoint, const compat::Vector2f& offset, const ScaleParams& scale, bool render) const;
 
     /**
-     * @brief See Face::acquireGlyph() for info.
+     * @brief Loads the outline of a glyph at the active size of the face.
+     *
+     * @return  null if the glyph is not an outline, or the face is a color font rendered by layers
+     */
+    LoadedOutlinePtr loadOutline(FT_Face ftFace, const Parameters& params, FT_UInt codepoint) const;
+
+    /**
+     * @brief Renders a loaded outline, with the same result as acquire() rendering the glyph.
+     *
+     * Only the outline gets transformed and scan converted, the glyph is not loaded again.
      */
-    GlyphPtr acquire(FT_UInt codepoint, const compat::Vector2f& offset, const ScaleParams& scale, bool render) const;
+    GlyphPtr render(const LoadedOutline& outline, const compat::Vector2f& offset, const ScaleParams& scale) const;
 
 private:
     /**
      * @brief Setup and retrieve glyph slot with loaded glyph from face. For more info see Face::acquireGlyph().
      */
 
-    Result<FT_GlyphSlot,bool> acquireSlot(FT_UInt codepoint, const compat::Vector2f& offset, RenderScale scale) const;
+    Result<FT_GlyphSlot,bool> acquireSlot(FT_Face ftFace, const Parameters& params, FT_UInt codepoint, const compat::Vector2f& offset, RenderScale scale) const;
     /**
      * @brief Translate outline from glyph slot to a Path
      *
@@ -82,13 +113,15 @@ private:
      * @return Glyph structure to be filled with data
      */
 
-    GlyphPtr createGlyph(FT_GlyphSlot glyphSlot) const;
+    GlyphPtr createGlyph(const Parameters& params, FT_GlyphSlot glyphSlot) const;
+
+    /// Transformation of glyphs set by FT_Set_Transform, see acquireSlot.
+    static FT_Matrix transformMatrix(RenderScale scale);
+    static FT_Vector transformDelta(const compat::Vector2f& offset);
 
 
     // REFACTOR
     // const FT_Outline_Funcs funcs_;
-    Parameters params_;
-    FT_Face ftFace_ = nullptr;
 };
 
 } // namespace odtr
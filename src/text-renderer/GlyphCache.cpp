@@ -0,0 +1,136 @@
+#include "GlyphCache.h"
+#include "FreetypeHandle.h"
+
+#include "../common/hash_utils.hpp"
+
+namespace odtr {
+
+bool GlyphCache::Key::operator==(const Key& other) const
+{
+    return face == other.face &&
+           codepoint == other.codepoint &&
+           fontSize == other.fontSize &&
+           scale == other.scale &&
+           offsetX == other.offsetX &&
+           offsetY == other.offsetY &&
+           disableHinting == other.disableHinting;
+}
+
+std::size_t GlyphCache::KeyHasher::operator()(const Key& key) const
+{
+    std::size_t seed = 0;
+    hash_combine(seed, key.face);
+    hash_combine(seed, key.codepoint);
+    hash_combine(seed, key.fontSize);
+    hash_combine(seed, key.scale);
+    hash_combine(seed, key.offsetX);
+    hash_combine(seed, key.offsetY);
+    hash_combine(seed, key.disableHinting);
+    return seed;
+}
+
+GlyphCache::GlyphCache(std::size_t byteBudget)
+    : byteBudget_(byteBudget)
+{
+}
+
+GlyphCache::Key GlyphCache::makeKey(const Face* face,
+                                    FT_UInt codepoint,
+                                    float fontSize,
+                                    float scale,
+                                    const compat::Vector2f& offset,
+                                    bool disableHinting)
+{
+    return Key {
+        face,
+        codepoint,
+        fontSize,
+        scale,
+        FreetypeHandle::to26_6fixed(offset.x),
+        FreetypeHandle::to26_6fixed(offset.y),
+        disableHinting
+    };
+}
+
+GlyphPtr GlyphCache::find(const Key& key)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const auto it = index_.find(key);
+    if (it == index_.end()) {
+        ++stats_.misses;
+        return nullptr;
+    }
+
+    ++stats_.hits;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->glyph->clone();
+}
+
+void GlyphCache::insert(const Key& key, const Glyph& glyph)
+{
+    const std::size_t bytes = glyph.bitmapByteSize() + sizeof(Entry);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (bytes > byteBudget_) {
+        return;
+    }
+
+    const auto it = index_.find(key);
+    if (it != index_.end()) {
+        stats_.bytes -= it->second->bytes;
+        entries_.erase(it->second);
+        index_.erase(it);
+    }
+
+    entries_.push_front(Entry { key, glyph.clone(), bytes });
+    index_.emplace(key, entries_.begin());
+    stats_.bytes += bytes;
+
+    evict();
+}
+
+void GlyphCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    entries_.clear();
+    index_.clear();
+    stats_.bytes = 0;
+    stats_.entries = 0;
+}
+
+void GlyphCache::setByteBudget(std::size_t byteBudget)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    byteBudget_ = byteBudget;
+    evict();
+}
+
+std::size_t GlyphCache::byteBudget() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return byteBudget_;
+}
+
+GlyphCache::Statistics GlyphCache::statistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void GlyphCache::evict()
+{
+    while (stats_.bytes > byteBudget_ && !entries_.empty()) {
+        const Entry& last = entries_.back();
+        stats_.bytes -= last.bytes;
+        index_.erase(last.key);
+        entries_.pop_back();
+        ++stats_.evictions;
+    }
+    stats_.entries = entries_.size();
+}
+
+} // namespace odtr
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "base.h"
+#include "Glyph.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace odtr {
+
+class Face;
+
+/**
+ * Least recently used cache of rendered glyph bitmaps.
+ *
+ * Glyphs are identified by the face, glyph index, font size, render scale,
+ * sub-pixel offset and hinting. The offset is quantized to 1/64 px, which is
+ * the precision FreeType positions the outline with, so a cached glyph is
+ * identical to a freshly rendered one. Cached bitmaps are shared with the
+ * glyphs handed out, a hit only costs a copy of the glyph object.
+ *
+ * Entries are evicted once the total size of the cached bitmaps exceeds
+ * the byte budget. The cache is thread-safe, texts may be drawn by multiple
+ * threads.
+ */
+class GlyphCache
+{
+public:
+    struct Key
+    {
+        const Face* face;
+        FT_UInt codepoint;
+        float fontSize;
+        float scale;
+        FT_F26Dot6 offsetX;
+        FT_F26Dot6 offsetY;
+        bool disableHinting;
+
+        bool operator==(const Key& other) const;
+    };
+
+    struct Statistics
+    {
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+        std::size_t evictions = 0;
+        std::size_t entries = 0;
+        std::size_t bytes = 0;
+    };
+
+    /// The default budget is ContextOptions::glyphCacheBudget.
+    explicit GlyphCache(std::size_t byteBudget);
+    GlyphCache(const GlyphCache&) = delete;
+    GlyphCache& operator=(const GlyphCache&) = delete;
+
+    static Key makeKey(const Face* face,
+                       FT_UInt codepoint,
+                       float fontSize,
+                       float scale,
+                       const compat::Vector2f& offset,
+                       bool disableHinting);
+
+    /// Returns a copy of the cached glyph, or null. Counts a hit or a miss.
+    GlyphPtr find(const Key& key);
+    /// Stores a copy of the glyph, evicting the least recently used entries if over budget.
+    void insert(const Key& key, const Glyph& glyph);
+
+    /// Drops all entries, must be called whenever a face gets destroyed.
+    void clear();
+
+    void setByteBudget(std::size_t byteBudget);
+    std::size_t byteBudget() const;
+
+    Statistics statistics() const;
+
+private:
+    struct KeyHasher
+    {
+        std::size_t operator()(const Key& key) const;
+    };
+
+    struct Entry
+    {
+        Key key;
+        GlyphPtr glyph;
+        std::size_t bytes;
+    };
+    using EntryList = std::list<Entry>;
+
+    void evict();
+
+    mutable std::mutex mutex_;
+
+    std::size_t byteBudget_;
+
+    /// Most recently used entries at the front.
+    EntryList entries_;
+    std::unordered_map<Key, EntryList::iterator, KeyHasher> index_;
+
+    Statistics stats_;
+};
+
+} // namespace odtr
@@ -21,9 +21,9 @@ GlyphShape::Scalable GlyphShape::scaledGlyphShape(float scale) const
         ascender * scale,
         descender * scale,
         lineHeight * scale,
-        static_cast<font_size>(std::ceil(format.size * scale)),
-        format.letterSpacing * scale,
-        format.paragraphSpacing * scale,
+        static_cast<font_size>(std::ceil(format->size * scale)),
+        format->letterSpacing * scale,
+        format->paragraphSpacing * scale,
     };
 }
 
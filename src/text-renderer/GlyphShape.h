@@ -13,9 +13,10 @@ namespace priv {
  */
 struct GlyphShape
 {
-    ImmediateFormat format;
+    ImmediateFormatPtr format;  //!< Shared by the glyphs of a style run
     uint32_t codepoint;         //!< Face dependent
     compat::qchar character;    //!< Unicode
+    int cluster;                //!< Index of the first character of the glyph within the paragraph
     TextDirection direction;
     std::optional<bool> lineStart;
 
@@ -2,10 +2,10 @@
 #include "LineBreaker.h"
 
 #include <cmath>
-#include <unicode/brkiter.h>
 
 #include "tabstops.h"
 
+#include "../unicode/Analyzer.h"
 #include "../utils/Log.h"
 
 namespace odtr {
@@ -25,19 +25,16 @@ bool LineBreaker::isSoftBreak(compat::qchar c)
     return c == 0x2028 || c == 0x0003;
 }
 
-LineBreaker::LineStarts LineBreaker::analyzeBreaks(const utils::Log& log, const std::vector<compat::qchar>& text)
+LineBreaker::LineStarts LineBreaker::analyzeBreaks(const utils::Log& log, const ustring& utext, unicode::Analyzer& analyzer)
 {
     std::vector<bool> opportunities;
+    opportunities.assign(utext.length() + 1, false); // The last possible line start is just beyond the last character
 
     auto locale = icu::Locale::getDefault(); // TODO Recognize locale from text
-    UErrorCode error = U_ZERO_ERROR;
-    auto bi = icu::BreakIterator::createLineInstance(locale, error);
-    auto utext = ustring::fromUTF32(reinterpret_cast<const UChar32*>(text.data()), static_cast<int32_t>(text.size()));
-    opportunities.assign(utext.length() + 1, false); // The last possible line start is just beyond the last character
+    icu::BreakIterator* bi = analyzer.lineBreakIterator(locale);
 
-    if (U_FAILURE(error)) {
-        log.error("Cannot instantiate ICU line break iterator: {}.", u_errorName(error));
-        delete bi;
+    if (bi == nullptr) {
+        log.error("Cannot instantiate ICU line break iterator.");
         return opportunities;
     }
 
@@ -46,7 +43,6 @@ LineBreaker::LineStarts LineBreaker::analyzeBreaks(const utils::Log& log, const
         opportunities.at(bi->current()) = true;
     } while (bi->next() != icu::BreakIterator::DONE);
 
-    delete bi;
     return opportunities;
 }
 
@@ -62,7 +58,7 @@ void LineBreaker::breakLines(int maxLineWidth)
         if (startIndex != endIndex) {
             lineSpans_.push_back({startIndex, endIndex, lineWidth, baseDir_, justifiable});
             ctx.resetLine();
-            auto nextlineOffset = newlineOffset(glyphs_[endIndex-1].format.tabStops);
+            auto nextlineOffset = newlineOffset(glyphs_[endIndex-1].format->tabStops);
             ctx.spaceWidth = nextlineOffset.value_or(0.0f);
 
             return true;
@@ -120,13 +116,13 @@ void LineBreaker::breakLines(int maxLineWidth)
 
 void LineBreaker::advanceContext(long i, Context& ctx)
 {
-    const spacing advance = glyphs_[i].horizontalAdvance + glyphs_[i].format.letterSpacing;
+    const spacing advance = glyphs_[i].horizontalAdvance + glyphs_[i].format->letterSpacing;
 
     if (isWhitespace(glyphs_[i].character)) {
         if (isTabStop(glyphs_[i].character)) {
             auto caret = ctx.spaceWidth + ctx.wordWidth + ctx.lineWidth;
-            auto tabstopIt = glyphs_[i].format.tabStops.upper_bound(caret);
-            if (tabstopIt != end(glyphs_[i].format.tabStops)) {
+            auto tabstopIt = glyphs_[i].format->tabStops.upper_bound(caret);
+            if (tabstopIt != end(glyphs_[i].format->tabStops)) {
                 auto tabstop = *tabstopIt;
                 ctx.lineWidth = tabstop;
                 ctx.spaceWidth = 0.0;
@@ -145,11 +141,11 @@ void LineBreaker::advanceContext(long i, Context& ctx)
     //auto advance = glyphs_[i].horizontalAdvance;
 
     //if (isWhitespace(glyphs_[i].character)) {
-    //    ctx.spaceWidth += advance + glyphs_[i].format.letterSpacing;
+    //    ctx.spaceWidth += advance + glyphs_[i].format->letterSpacing;
     //} else {
     //    if (i + 1 < glyphs_.size() && !isWhitespace(glyphs_[i + 1].character)) {
     //        // ads letter spacing unless the letter is the last one within a word
-    //        advance += glyphs_[i].format.letterSpacing;
+    //        advance += glyphs_[i].format->letterSpacing;
     //    }
     //    ctx.wordWidth += advance;
     //}
@@ -160,7 +156,7 @@ void LineBreaker::removeTrailingSpaces()
     for (LineSpan &lineSpan : lineSpans_) {
         for (long i = lineSpan.end - 1; i >= lineSpan.start; --i) {
             if (isWhitespace(glyphs_[i].character)) {
-                lineSpan.lineWidth -= glyphs_[i].horizontalAdvance + glyphs_[i].format.letterSpacing;
+                lineSpan.lineWidth -= glyphs_[i].horizontalAdvance + glyphs_[i].format->letterSpacing;
             } else {
                 lineSpan.end = i + 1;
                 break;
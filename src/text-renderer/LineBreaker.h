@@ -10,6 +10,9 @@
 
 // Forward declaration
 namespace odtr {
+namespace unicode {
+class Analyzer;
+}
 namespace utils {
 class Log;
 }
@@ -32,8 +35,10 @@ public:
 
     /**
      *  Find break opportunities as specified by the Unicode Line Breaking Algorithm
+     *
+     *  @param utext    UTF-16 text of the paragraph, the opportunities are indexed by its code units
      */
-    static LineStarts analyzeBreaks(const utils::Log& log, const std::vector<compat::qchar>& text);
+    static LineStarts analyzeBreaks(const utils::Log& log, const ustring& utext, unicode::Analyzer& analyzer);
 
     /**
      *  Break lines according to previously found breaks.
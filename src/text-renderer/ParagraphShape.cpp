@@ -4,6 +4,7 @@
 #include "tabstops.h"
 
 #include "../fonts/FontManager.h"
+#include "../unicode/SimpleText.h"
 #include "../utils/Log.h"
 
 #include <algorithm>
@@ -34,6 +35,39 @@ static bool isSkipGlyph(qchar c)
     return std::find(skipped.begin(), skipped.end(), c) != skipped.end();
 }
 
+/// A part of a sequence shaped at once.
+struct WordSegment
+{
+    int start, len;
+    /// Whether the segment is shaped without its surrounding characters.
+    bool standalone;
+};
+
+/**
+ * Splits the sequence at the boundaries between spaces and other characters. A word or a run of spaces
+ * bounded by such boundaries (or by the paragraph ends) is shaped on its own. Parts of the sequence next
+ * to a different sequence keep the surrounding characters as context, e.g. for the joining of Arabic letters.
+ *
+ * Other word boundaries (ICU) are not used, as the kerning between a letter and a punctuation would be lost.
+ */
+static std::vector<WordSegment> findWordSegments(const std::vector<qchar>& text, int start, int len)
+{
+    const int textLen = static_cast<int>(text.size());
+    const auto isBoundary = [&text, textLen](int i) {
+        return i == 0 || i == textLen || (text[i - 1] == ' ') != (text[i] == ' ');
+    };
+
+    std::vector<WordSegment> segments;
+    int segmentStart = start;
+    for (int i = start + 1; i <= start + len; ++i) {
+        if (i == start + len || isBoundary(i)) {
+            segments.push_back(WordSegment { segmentStart, i - segmentStart, isBoundary(segmentStart) && isBoundary(i) });
+            segmentStart = i;
+        }
+    }
+    return segments;
+}
+
 static float evaluateAlign(HorizontalAlign align, TextDirection direction)
 {
     switch (align) {
@@ -52,14 +86,6 @@ static float evaluateAlign(HorizontalAlign align, TextDirection direction)
     }
 }
 
-static spacing lineHeightFromFace(const FacePtr face)
-{
-    if (face->isScalable()) {
-        return face->scaleFontUnits(face->getFtFace()->height, true);
-    } else {
-        return FreetypeHandle::from26_6fixed(face->getFtFace()->size->metrics.height);
-    }
-}
 }
 
 
@@ -73,9 +99,8 @@ void ParagraphShape::ReportedFaces::merge(const ReportedFaces& other)
 }
 
 
-ParagraphShape::ParagraphShape(const utils::Log& log, const FaceTable &faceTable) :
-    log_(log),
-    faceTable_(faceTable)
+ParagraphShape::ParagraphShape(const utils::Log& log) :
+    log_(log)
 {
 }
 
@@ -85,50 +110,166 @@ void ParagraphShape::initialize(const GlyphShapes &glyphs,
     shapingResult_.lineSpans_ = lineSpans;
 }
 
-ParagraphShape::ShapeResult ParagraphShape::shape(const FormattedParagraph& paragraph, float width, bool loadGlyphsBearings)
+ParagraphShape::ShapeResult ParagraphShape::shape(const FormattedParagraph& paragraph, float width, bool loadGlyphsBearings, ShapingCache& shapingCache, unicode::Analyzer& analyzer, const FaceTable& faces)
 {
-    if (paragraph.text_.size() != paragraph.format_.size()) {
+    if (static_cast<int>(paragraph.text_.size()) != paragraph.format_.length()) {
         log_.warn("Paragraph shaping error: Text format incorrectly expanded.");
         return false;
     }
 
     // Prepare Unicode line break opportunities
-    const LineBreaker::LineStarts lineStartsOpt = LineBreaker::analyzeBreaks(log_,  paragraph.text_);
+    const LineBreaker::LineStarts lineStartsOpt = paragraph.simple_
+        ? LineBreaker::LineStarts(unicode::findSimpleLineBreaks(paragraph.text_.data(), paragraph.text_.size()))
+        : LineBreaker::analyzeBreaks(log_, paragraph.utext_, analyzer);
 
     ShapeResult result(false);
-    const int textLen = static_cast<int>(paragraph.text_.size());
-    int pos = 0;
+    const FormatRuns::Runs& runs = paragraph.format_.runs();
 
-    // Divide paragraph into sequences with uniform glyph format
-    while (pos < textLen) {
+    // Divide paragraph into sequences with uniform glyph format, made of style runs
+    for (std::size_t r = 0; r < runs.size(); ) {
         Sequence seq;
-        seq.start = pos;
-        seq.len = 1;
-        seq.format = paragraph.format_[pos];
-        ++pos;
+        seq.start = runs[r].start;
+        seq.len = runs[r].end - runs[r].start;
+        seq.format = runs[r].format;
+        ++r;
+
+        while (r < runs.size() && *runs[r].format == *seq.format) {
+            seq.len += runs[r].end - runs[r].start;
+            ++r;
+        }
+
+        shapeSequence(seq, paragraph, faces, lineStartsOpt, loadGlyphsBearings, shapingCache, result);
+    }
 
-        while (pos < textLen && paragraph.format_[pos] == seq.format) {
-            ++pos, ++seq.len;
+    shapingResult_.visualRuns_ = paragraph.visualRuns_;
+    shapingResult_.baseDirection_ = paragraph.baseDirection_;
+
+    if (!breakLines(width)) {
+        return result;
+    }
+
+    result.success = !shapingResult_.glyphs_.empty();
+    return result;
+}
+
+void ParagraphShape::restyle(const FormatRuns& format)
+{
+    // glyphs of a style run share the format, so do the restyled ones
+    ImmediateFormatPtr glyphFormat;
+    ImmediateFormatPtr characterFormat;
+    ImmediateFormatPtr restyledFormat;
+
+    for (GlyphShape& glyph : shapingResult_.glyphs_) {
+        const ImmediateFormatPtr& style = format.formatPtrAt(glyph.cluster);
+
+        if (glyph.format != glyphFormat || style != characterFormat) {
+            glyphFormat = glyph.format;
+            characterFormat = style;
+
+            if (glyph.format->color == style->color && glyph.format->decorations == style->decorations) {
+                restyledFormat = glyph.format;
+            } else {
+                ImmediateFormat restyled = *glyph.format;
+                restyled.color = style->color;
+                restyled.decorations = style->decorations;
+                restyledFormat = std::make_shared<const ImmediateFormat>(std::move(restyled));
+            }
         }
 
-        shapeSequence(seq, paragraph, faceTable_, lineStartsOpt, loadGlyphsBearings, result);
+        glyph.format = restyledFormat;
+    }
+}
+
+bool ParagraphShape::isLinearlyScalable(const FaceTable& faces) const
+{
+    const ImmediateFormat* checkedFormat = nullptr;
+
+    for (const GlyphShape& glyph : shapingResult_.glyphs_) {
+        if (glyph.format.get() == checkedFormat) {
+            continue;
+        }
+        checkedFormat = glyph.format.get();
+
+        const FaceTable::Item* faceItem = faces.getFaceItem(glyph.format->faceHandle);
+        if (faceItem == nullptr || faceItem->face == nullptr || !faceItem->face->isScalable() || faceItem->face->isColorFont()) {
+            return false;
+        }
+        if (glyph.format->size <= 0.0f) {
+            return false;
+        }
     }
 
-    LineBreaker breaker {log_, shapingResult_.glyphs_, paragraph.visualRuns_, paragraph.baseDirection_};
+    return true;
+}
+
+bool ParagraphShape::resize(const FormatRuns& format, const FaceTable& faces)
+{
+    ImmediateFormatPtr glyphFormat;
+    ImmediateFormatPtr characterFormat;
+    ImmediateFormatPtr resizedFormat;
+    float factor = 1.0f;
+    Face::Metrics faceMetrics {};
+    spacing lineHeight = 0.0f;
+
+    for (GlyphShape& glyph : shapingResult_.glyphs_) {
+        const ImmediateFormatPtr& style = format.formatPtrAt(glyph.cluster);
+
+        if (glyph.format != glyphFormat || style != characterFormat) {
+            glyphFormat = glyph.format;
+            characterFormat = style;
+            factor = style->size / glyph.format->size;
+
+            if (factor == 1.0f) {
+                resizedFormat = glyph.format;
+            } else {
+                ImmediateFormat resized = *glyph.format;
+                resized.size = style->size;
+                resizedFormat = std::make_shared<const ImmediateFormat>(std::move(resized));
+            }
+
+            // the metrics of the new size, as if the glyphs were shaped with it
+            const FaceTable::Item* faceItem = faces.getFaceItem(resizedFormat->faceHandle);
+            if (faceItem == nullptr || faceItem->face == nullptr || resizedFormat->size <= 0.0f) {
+                return false;
+            }
+            const FacePtr face = faceItem->face;
+            const Result<font_size,bool> setSizeRes = face->setSize(resizedFormat->size);
+            if (!setSizeRes || setSizeRes.value() != resizedFormat->size) {
+                return false;
+            }
+            faceMetrics = face->getMetrics();
+            lineHeight = evalLineHeight(*resizedFormat, faceMetrics);
+        }
+
+        glyph.format = resizedFormat;
+        glyph.horizontalAdvance *= factor;
+        glyph.bearingX *= factor;
+        glyph.bearingY *= factor;
+        glyph.lineHeight = lineHeight;
+        glyph.defaultLineHeight = faceMetrics.height;
+        glyph.ascender = faceMetrics.ascender;
+        glyph.descender = faceMetrics.descender;
+    }
+
+    return true;
+}
+
+bool ParagraphShape::breakLines(float width)
+{
+    LineBreaker breaker {log_, shapingResult_.glyphs_, shapingResult_.visualRuns_, shapingResult_.baseDirection_};
     breaker.breakLines(static_cast<int>(std::floor(width)));
     const LineSpans &lineSpans = breaker.getLines();
     if (lineSpans.empty()) {
         log_.warn("Paragraph breaking error: No lines present.");
-        return result;
+        return false;
     }
 
     shapingResult_.lineSpans_ = breaker.moveLines();
-
-    result.success = !shapingResult_.glyphs_.empty();
-    return result;
+    return true;
 }
 
 ParagraphShape::DrawResult ParagraphShape::draw(const Context& ctx,
+                                                const FaceTable& faces,
                                                 int left,
                                                 int width,
                                                 float& y,
@@ -136,7 +277,8 @@ ParagraphShape::DrawResult ParagraphShape::draw(const Context& ctx,
                                                 BaselinePolicy baselinePolicy,
                                                 float scale,
                                                 bool last,
-                                                bool alphaMask) const
+                                                bool alphaMask,
+                                                bool metricsOnly) const
 {
     DrawResult result;
 
@@ -145,7 +287,7 @@ ParagraphShape::DrawResult ParagraphShape::draw(const Context& ctx,
         return result;
     }
 
-    const float align = evaluateAlign(shapingResult_.glyphs_[0].format.align, shapingResult_.glyphs_[0].direction);
+    const float align = evaluateAlign(shapingResult_.glyphs_[0].format->align, shapingResult_.glyphs_[0].direction);
 
     Vector2f caret { 0.0f, y };
     for (const LineSpan &lineSpan : shapingResult_.lineSpans_) {
@@ -195,7 +337,7 @@ ParagraphShape::DrawResult ParagraphShape::draw(const Context& ctx,
         caret.x = (lineRtl ? rightLimit : leftLimit)/* * scale*/;
 
         if (isFirstLine) {
-            caret.x += shapingResult_.glyphs_[0].format.paragraphIndent * scale;
+            caret.x += shapingResult_.glyphs_[0].format->paragraphIndent * scale;
         }
 
         // Draw the line
@@ -223,22 +365,22 @@ ParagraphShape::DrawResult ParagraphShape::draw(const Context& ctx,
                 const bool tabStop = isTabStop(unscaledGlyphShape.character);
 
                 if (j == visualRun.start && !isFirstLine && firstRun && !tabStop) {
-                    auto nextlineOffset = newlineOffset(shapingResult_.glyphs_[j].format.tabStops);
+                    auto nextlineOffset = newlineOffset(shapingResult_.glyphs_[j].format->tabStops);
                     if (nextlineOffset.has_value()) {
                         caret.x = nextlineOffset.value() * scale;
                     }
                 }
 
                 if (tabStop) {
-                    auto tabstopIt = unscaledGlyphShape.format.tabStops.upper_bound(caret.x / scale);
-                    if (tabstopIt != end(unscaledGlyphShape.format.tabStops)) {
+                    auto tabstopIt = unscaledGlyphShape.format->tabStops.upper_bound(caret.x / scale);
+                    if (tabstopIt != end(unscaledGlyphShape.format->tabStops)) {
                         caret.x = *tabstopIt * scale;
                         fixedHorizontalAdvance = true;
                     }
                 }
 
-                const FaceId &faceID = unscaledGlyphShape.format.faceId;
-                const FaceTable::Item* faceItem = faceTable_.getFaceItem(faceID);
+                const FaceId &faceID = unscaledGlyphShape.format->faceId;
+                const FaceTable::Item* faceItem = faces.getFaceItem(unscaledGlyphShape.format->faceHandle);
                 if (!faceItem) {
                     log_.warn("Line drawing error: Missing font face \"{}\"", faceID);
                     continue;
@@ -246,7 +388,7 @@ ParagraphShape::DrawResult ParagraphShape::draw(const Context& ctx,
 
                 FacePtr face = faceItem->face;
 
-                const font_size desiredSize = face->isScalable() ? unscaledGlyphShape.format.size : scaledGlyphShape.size;
+                const font_size desiredSize = face->isScalable() ? unscaledGlyphShape.format->size : scaledGlyphShape.size;
                 const Result<font_size,bool> setSizeRes = face->setSize(desiredSize);
                 const float glyphScale = (setSizeRes && !face->isScalable()) ? scaledGlyphShape.ascender / (float)setSizeRes.value() : 1.0f;
 
@@ -255,7 +397,7 @@ ParagraphShape::DrawResult ParagraphShape::draw(const Context& ctx,
                     static_cast<float>(caret.y - std::floor(caret.y)),
                 };
 
-                GlyphPtr glyph = face->acquireGlyph(unscaledGlyphShape.codepoint, offset, {scale,glyphScale}, true, ctx.config.internalDisableHinting);
+                GlyphPtr glyph = face->acquireGlyph(unscaledGlyphShape.codepoint, offset, {scale,glyphScale}, !metricsOnly, ctx.config.internalDisableHinting);
                 if (!glyph) {
                     log_.warn("Rendering glyph #{} from face \"{}\" failed.", unscaledGlyphShape.codepoint, faceID);
                     continue;
@@ -307,9 +449,9 @@ ParagraphShape::DrawResult ParagraphShape::draw(const Context& ctx,
                 caret.x += direction * xShift;
 
                 glyph->setDestination({static_cast<int>(floor(coord.x)), static_cast<int>(floor(coord.y))});
-                glyph->setColor(alphaMask ? ~Pixel32() : unscaledGlyphShape.format.color);
+                glyph->setColor(alphaMask ? ~Pixel32() : unscaledGlyphShape.format->color);
 
-                for (Decoration decoration : unscaledGlyphShape.format.decorations) {
+                for (Decoration decoration : unscaledGlyphShape.format->decorations) {
                     if (decoration != Decoration::NONE) {
                         const Vector2f dStart {
                             coord.x,
@@ -321,7 +463,7 @@ ParagraphShape::DrawResult ParagraphShape::draw(const Context& ctx,
                             dStart,
                             dEnd,
                             decoration,
-                            unscaledGlyphShape.format.color,
+                            unscaledGlyphShape.format->color,
                             face
                         };
                         result.journal.addDecoration(decorationInput, scale, j);
@@ -353,7 +495,7 @@ ParagraphShape::DrawResult ParagraphShape::draw(const Context& ctx,
         // updates the leftmost coords within paragraph
         result.leftmost = std::min(result.leftmost, !lineRtl ? leftLimit : lineSpan.lineWidth - leftLimit);
     }
-    y = caret.y + ((last ? 0 : 1) * (shapingResult_.glyphs_[0].format.paragraphSpacing * scale));
+    y = caret.y + ((last ? 0 : 1) * (shapingResult_.glyphs_[0].format->paragraphSpacing * scale));
 
     return result;
 }
@@ -364,7 +506,7 @@ HorizontalAlign ParagraphShape::firstLineHorizontalAlignment() const
         return HorizontalAlign::LEFT;
     }
 
-    return shapingResult_.glyphs_[0].format.align;
+    return shapingResult_.glyphs_[0].format->align;
 }
 
 bool ParagraphShape::hasExplicitLineHeight() const
@@ -373,7 +515,7 @@ bool ParagraphShape::hasExplicitLineHeight() const
         return false;
     }
 
-    return shapingResult_.glyphs_[0].format.lineHeight != 0;
+    return shapingResult_.glyphs_[0].format->lineHeight != 0;
 }
 
 const GlyphShape &ParagraphShape::glyph(std::size_t index) const
@@ -413,31 +555,19 @@ float ParagraphShape::computeCaretShift(const LineSpan& lineSpan, VerticalPositi
     return yShift;
 }
 
-spacing ParagraphShape::evalLineHeight(const uint32_t codepoint, const ImmediateFormat& fmt, const FacePtr face) const
+spacing ParagraphShape::evalLineHeight(const ImmediateFormat& fmt, const Face::Metrics& faceMetrics) const
 {
     spacing lh = fmt.lineHeight;
 
     if (lh == 0) {
         // implicit line height
-        lh = lineHeightFromFace(face);
+        lh = faceMetrics.height;
 
         if (lh == fmt.size) {
             // line height is typically expected to be larger than fmt.size
             // setting it to span of ascender and descender is one of the options
             // we can do with it to achieve expected results
-
-            spacing ascender = 0.0f;
-            spacing descender = 0.0f;
-
-            if (face->isScalable()) {
-                ascender = face->scaleFontUnits(face->getFtFace()->ascender, true);
-                descender = face->scaleFontUnits(face->getFtFace()->descender, true);
-            } else {
-                ascender = FreetypeHandle::from26_6fixed(face->getFtFace()->size->metrics.ascender);
-                descender = FreetypeHandle::from26_6fixed(face->getFtFace()->size->metrics.descender);
-            }
-
-            lh = ascender - descender;
+            lh = faceMetrics.ascender - faceMetrics.descender;
         }
     }
 
@@ -463,7 +593,7 @@ ParagraphShape::JustifyResult ParagraphShape::justify(const LineSpan& lineSpan,
         return {0.0f, 0.0f, 0.0f, false};
     }
 
-    const bool shouldJustify = shapingResult_.glyphs_[startIdx].format.align == HorizontalAlign::JUSTIFY &&
+    const bool shouldJustify = shapingResult_.glyphs_[startIdx].format->align == HorizontalAlign::JUSTIFY &&
          (lineSpan.justifiable == LineSpan::Justifiable::POSITIVE ||
          (lineSpan.justifiable == LineSpan::Justifiable::DOCUMENT && params.justifyAmbiguous));
 
@@ -475,10 +605,10 @@ ParagraphShape::JustifyResult ParagraphShape::justify(const LineSpan& lineSpan,
         for (int j = static_cast<int>(lineSpan.start); j < static_cast<int>(lineSpan.end); ++j) {
             if (isWhitespace(shapingResult_.glyphs_[j].character)) {
                 spaces++;
-                spaceWidth += shapingResult_.glyphs_[j].horizontalAdvance + shapingResult_.glyphs_[j].format.letterSpacing;
+                spaceWidth += shapingResult_.glyphs_[j].horizontalAdvance + shapingResult_.glyphs_[j].format->letterSpacing;
             } else {
                 nonSpaces++;
-                nonSpaceWidth += shapingResult_.glyphs_[j].horizontalAdvance + shapingResult_.glyphs_[j].format.letterSpacing;
+                nonSpaceWidth += shapingResult_.glyphs_[j].horizontalAdvance + shapingResult_.glyphs_[j].format->letterSpacing;
             }
         }
 
@@ -499,14 +629,14 @@ float ParagraphShape::kern(const FacePtr face, const int idx, float scale) const
 {
     float kernValue = 0.0;
     const bool fontHasKerning = FT_HAS_KERNING(face->getFtFace());
-    const bool glyphHasKerning = shapingResult_.glyphs_[idx].format.kerning;
+    const bool glyphHasKerning = shapingResult_.glyphs_[idx].format->kerning;
 
     if (fontHasKerning && glyphHasKerning) {
         FT_Vector kerning;
         const uint32_t prev = shapingResult_.glyphs_[idx - 1].codepoint;
         const uint32_t curr = shapingResult_.glyphs_[idx].codepoint;
-        FreetypeHandle::error = FT_Get_Kerning(face->getFtFace(), prev, curr, FT_KERNING_DEFAULT, &kerning);
-        FreetypeHandle::checkOk(__func__);
+        const FT_Error error = FT_Get_Kerning(face->getFtFace(), prev, curr, FT_KERNING_DEFAULT, &kerning);
+        FreetypeHandle::checkOk(error, __func__);
         kernValue = scale * FreetypeHandle::from26_6fixed(kerning.x); // grid-fitted kerning distances, see FT_Kerning_Mode
     }
 
@@ -618,32 +748,33 @@ void ParagraphShape::shapeSequence(const Sequence& seq,
                                    const FaceTable& faces,
                                    const LineBreaker::LineStarts &lineStartsOpt,
                                    bool loadGlyphsBearings,
+                                   ShapingCache& shapingCache,
                                    ShapeResult& result)
 {
-    const FaceTable::Item* faceItem = faces.getFaceItem(seq.format.faceId);
+    const FaceTable::Item* faceItem = faces.getFaceItem(seq.format->faceHandle);
     if (!faceItem) {
         bool inserted = false;
-        std::tie(std::ignore, inserted) = reportedFaces_.insert({seq.format.faceId, ReportedFontReason::NO_DATA});
+        std::tie(std::ignore, inserted) = reportedFaces_.insert({seq.format->faceId, ReportedFontReason::NO_DATA});
         if (inserted) {
-            log_.warn("Paragraph shaping error: Missing face item '{}'", seq.format.faceId);
+            log_.warn("Paragraph shaping error: Missing face item '{}'", seq.format->faceId);
         }
         return;
     }
 
     const FacePtr face = faceItem->face;
     if (!face->getFtFace()) {
-        reportedFaces_.insert({seq.format.faceId, ReportedFontReason::LOAD_FAILED});
-        log_.warn("Paragraph shaping error: Missing font face '{}'", seq.format.faceId);
+        reportedFaces_.insert({seq.format->faceId, ReportedFontReason::LOAD_FAILED});
+        log_.warn("Paragraph shaping error: Missing font face '{}'", seq.format->faceId);
         return;
     } else {
-        result.insertFontItem(seq.format.faceId, faceItem->fallback);
+        result.insertFontItem(seq.format->faceId, faceItem->fallback);
     }
 
-    if (face->getPostScriptName() != seq.format.faceId) {
-        reportedFaces_.insert({seq.format.faceId, ReportedFontReason::POSTSCRIPTNAME_MISMATCH});
+    if (face->getPostScriptName() != seq.format->faceId) {
+        reportedFaces_.insert({seq.format->faceId, ReportedFontReason::POSTSCRIPTNAME_MISMATCH});
     }
 
-    const font_size desiredSize = seq.format.size;
+    const font_size desiredSize = seq.format->size;
     const Result<font_size,bool> actualSizeResult = face->setSize(desiredSize);
 
     const float resizeFactor = (actualSizeResult && actualSizeResult.value() != desiredSize)
@@ -655,21 +786,60 @@ void ParagraphShape::shapeSequence(const Sequence& seq,
     hb_buffer_guess_segment_properties(hbBuffer);
     const bool rtl = hb_buffer_get_direction(hbBuffer) == HB_DIRECTION_RTL;
 
-    validateUserFeatures(face, paragraph.format_[seq.start].features);
-    const std::vector<hb_feature_t> hbFeatures = setupFeatures(paragraph.format_[seq.start]);
+    hb_segment_properties_t segmentProperties;
+    hb_buffer_get_segment_properties(hbBuffer, &segmentProperties);
+
+    validateUserFeatures(face, seq.format->features);
+    const std::vector<hb_feature_t> hbFeatures = setupFeatures(*seq.format);
+
+    // Words are shaped and cached one by one, so that they are reused by other runs and texts. This is only possible
+    // if the space glyph doesn't interact with its neighbours, see findWordSegments.
+    const std::vector<WordSegment> segments = face->spaceAffectsShaping()
+        ? std::vector<WordSegment> { WordSegment { seq.start, seq.len, false } }
+        : findWordSegments(paragraph.text_, seq.start, seq.len);
+
+    // glyphs of the sequence in logical order, the clusters are relative to the sequence start
+    ShapingCache::ShapedRun shapedGlyphs;
+    for (const WordSegment& segment : segments) {
+        const ShapingCache::Key cacheKey = ShapingCache::makeKey(face->origin(), desiredSize, hbFeatures, segmentProperties, paragraph.text_, segment.start, segment.len, !segment.standalone);
+        ShapingCache::ShapedRunPtr shapedRun = shapingCache.find(cacheKey);
+        if (!shapedRun) {
+            hb_buffer_clear_contents(hbBuffer);
+            if (segment.standalone) {
+                hb_buffer_add_utf32(hbBuffer, &paragraph.text_[segment.start], segment.len, 0, segment.len);
+            } else {
+                hb_buffer_add_utf32(hbBuffer, &paragraph.text_[0], static_cast<int>(paragraph.text_.size()), segment.start, segment.len);
+            }
+            hb_buffer_set_segment_properties(hbBuffer, &segmentProperties);
+            hb_shape(face->getHbFont(), hbBuffer, hbFeatures.data(), static_cast<unsigned int>(hbFeatures.size()));
+            shapedRun = ShapingCache::makeShapedRun(hbBuffer, segment.standalone ? 0 : segment.start);
+            shapingCache.insert(cacheKey, shapedRun);
+        }
 
-    hb_shape(face->getHbFont(), hbBuffer, hbFeatures.data(), static_cast<unsigned int>(hbFeatures.size()));
+        const std::size_t segmentOffset = shapedGlyphs.size();
+        shapedGlyphs.insert(shapedGlyphs.end(), shapedRun->begin(), shapedRun->end());
+        if (rtl) {
+            std::reverse(shapedGlyphs.begin() + segmentOffset, shapedGlyphs.end());
+        }
+        for (std::size_t g = segmentOffset; g < shapedGlyphs.size(); ++g) {
+            shapedGlyphs[g].cluster += static_cast<uint32_t>(segment.start - seq.start);
+        }
+    }
+
+    hb_buffer_destroy(hbBuffer);
 
     bool isGlyphMissing = false;
 
+    // the metrics are the same for all glyphs of the sequence
+    const Face::Metrics faceMetrics = face->getMetrics();
+    const ImmediateFormat* lineHeightFormat = nullptr;
+    spacing lineHeight = 0.0f;
+
     GlyphShape glyph;
-    const unsigned int hbLen = hb_buffer_get_length(hbBuffer);
-    const hb_glyph_position_t* hbPos = hb_buffer_get_glyph_positions(hbBuffer, nullptr);
-    const hb_glyph_info_t* hbInfo = hb_buffer_get_glyph_infos(hbBuffer, nullptr);
+    const unsigned int hbLen = static_cast<unsigned int>(shapedGlyphs.size());
     for (unsigned i = 0; i < hbLen; ++i) {
-        const int k = rtl ? hbLen - i - 1 : i;
-        const int p = hbInfo[k].cluster;
-        const auto& fmt = paragraph.format_[p];
+        const int p = seq.start + static_cast<int>(shapedGlyphs[i].cluster);
+        const ImmediateFormatPtr& fmt = paragraph.format_.formatPtrAt(p);
 
         // If HB does not evaluate emoji modifiers and ZWJ sequences correctly,
         // force skip those pseudo-glyphs. Known to happen with Apple Color Emoji.
@@ -679,32 +849,28 @@ void ParagraphShape::shapeSequence(const Sequence& seq,
         }
 
         glyph.format = fmt;
-        glyph.codepoint = hbInfo[k].codepoint;
+        glyph.codepoint = shapedGlyphs[i].codepoint;
 
         if (lineStartsOpt)
             glyph.lineStart = std::optional<bool>(lineStartsOpt->at(p));
 
-        if (hbPos[k].x_advance != 0) {
-            glyph.horizontalAdvance = FreetypeHandle::from26_6fixed(hbPos[k].x_advance); // HB has already scaled FT values
+        if (shapedGlyphs[i].xAdvance != 0) {
+            glyph.horizontalAdvance = FreetypeHandle::from26_6fixed(shapedGlyphs[i].xAdvance); // HB has already scaled FT values
         } else {
             glyph.horizontalAdvance = FreetypeHandle::from16_16fixed(face->getGlyphAdvance(glyph.codepoint));
         }
 
         glyph.direction = rtl ? TextDirection::RIGHT_TO_LEFT : TextDirection::LEFT_TO_RIGHT;
         glyph.character = paragraph.text_[p];
-        glyph.lineHeight = evalLineHeight(glyph.codepoint, fmt, face);
-        glyph.defaultLineHeight = lineHeightFromFace(face);
-
-        if (face->isScalable()) {
-            glyph.ascender = face->scaleFontUnits(face->getFtFace()->ascender, true);
-            glyph.descender = face->scaleFontUnits(face->getFtFace()->descender, true);
-        } else {
-            // the values in size->metrics are rounded for historical reasons and therefore less desirable
-            // however "global" values in font units are not present in bitmap fonts
-            // see docs for FT_Size_Metrics and FT_FaceRec for more info
-            glyph.ascender = FreetypeHandle::from26_6fixed(face->getFtFace()->size->metrics.ascender);
-            glyph.descender = FreetypeHandle::from26_6fixed(face->getFtFace()->size->metrics.descender);
+        glyph.cluster = p;
+        if (fmt.get() != lineHeightFormat) {
+            lineHeightFormat = fmt.get();
+            lineHeight = evalLineHeight(*fmt, faceMetrics);
         }
+        glyph.lineHeight = lineHeight;
+        glyph.defaultLineHeight = faceMetrics.height;
+        glyph.ascender = faceMetrics.ascender;
+        glyph.descender = faceMetrics.descender;
 
         if (glyph.codepoint == 0 && !LineBreaker::isSoftBreak(glyph.character)) {
             isGlyphMissing = true;
@@ -715,9 +881,9 @@ void ParagraphShape::shapeSequence(const Sequence& seq,
         }
 
         if (loadGlyphsBearings) {
-            const GlyphPtr loadedGlyph = face->acquireGlyph(glyph.codepoint, {}, {1.0f,1.0f}, false, true);
-            glyph.bearingX = loadedGlyph->metricsBearing.x;
-            glyph.bearingY = loadedGlyph->metricsBearing.y;
+            const Vector2f bearing = face->getGlyphBearing(glyph.codepoint);
+            glyph.bearingX = bearing.x;
+            glyph.bearingY = bearing.y;
         } else {
             glyph.bearingX = glyph.bearingY = 0.0f;
         }
@@ -725,10 +891,8 @@ void ParagraphShape::shapeSequence(const Sequence& seq,
         shapingResult_.glyphs_.push_back(glyph);
     }
 
-    hb_buffer_destroy(hbBuffer);
-
     if (isGlyphMissing) {
-        reportedFaces_.insert({seq.format.faceId, ReportedFontReason::MISSING_GLYPH});
+        reportedFaces_.insert({seq.format->faceId, ReportedFontReason::MISSING_GLYPH});
     }
 }
 
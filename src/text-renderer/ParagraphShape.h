@@ -111,7 +111,7 @@ public:
         void merge(const ReportedFaces& other);
     };
 
-    ParagraphShape(const utils::Log& log, const FaceTable &faceTable);
+    explicit ParagraphShape(const utils::Log& log);
 
     ParagraphShape(const ParagraphShape&) = delete;
     ParagraphShape& operator=(const ParagraphShape&) = delete;
@@ -123,25 +123,59 @@ public:
     /**
      * Transform @a paragraph into text shapes -- ie join characters into ligatures etc.
      *
-     * @param paragraph Formatted paragraph to be transformed
-     * @param width     Text width used for line breaking.
+     * @param paragraph       Formatted paragraph to be transformed
+     * @param width           Text width used for line breaking.
+     * @param shapingCache    Cache of HarfBuzz shaping results, reused for repeated runs.
+     * @param analyzer        ICU objects for the line breaking analysis.
+     * @param faces           Faces used for shaping, possibly another instance of the faces the shape is drawn with.
      */
     ShapeResult shape(const FormattedParagraph& paragraph,
                       float width,
-                      bool loadGlyphsBearings);
+                      bool loadGlyphsBearings,
+                      ShapingCache& shapingCache,
+                      unicode::Analyzer& analyzer,
+                      const FaceTable& faces);
+
+    /// Changes the color and decorations of the glyphs to those of @a format, the new formats of the paragraph characters.
+    void restyle(const FormatRuns& format);
+
+    /**
+     * Whether all the glyphs are of scalable fonts without color glyphs, so that their advances and metrics
+     * scale linearly with the font size.
+     */
+    bool isLinearlyScalable(const FaceTable& faces) const;
+
+    /**
+     * Changes the font sizes of the glyphs to those of @a format, the new formats of the paragraph characters.
+     * The advances and metrics of the glyphs are scaled, the glyphs must be linearly scalable.
+     * The lines have to be broken again.
+     *
+     * @return  false if a face is missing or can't be set to a new size, the glyphs may be partially resized then
+     */
+    bool resize(const FormatRuns& format, const FaceTable& faces);
+
+    /**
+     * Breaks the shaped glyphs into lines of a new @a width, using the break opportunities found by the shaping.
+     *
+     * @return  false if no lines were created
+     */
+    bool breakLines(float width);
 
     /**
      * Transform the shape into glyphs (images).
      *
      * @param[in] ctx              Context with configuration, fonts etc.
+     * @param[in] faces            Faces the glyphs are loaded from, not used by another thread at the same time
      * @param[in] left             Horizontal offset
      * @param[in] width            Text width used for line breaking.
      * @param[inout] y             Vertical offset. Use output for the following paragraph (if any)
      * @param[inout] positioning   Vertical positioning. Use output for the following paragraph (if any)
      * @param[in] scale            Scaling factor
      * @param[last] last           Drawing last paragraph
+     * @param[in] metricsOnly      Only lay out the glyphs, their bitmaps are not rasterized and can't be blitted
      */
     DrawResult draw(const Context& ctx,
+                    const FaceTable& faces,
                     int left,
                     int width,
                     float& y,
@@ -149,7 +183,8 @@ public:
                     BaselinePolicy baselinePolicy,
                     float scale,
                     bool last,
-                    bool alphaMask) const;
+                    bool alphaMask,
+                    bool metricsOnly) const;
 
     HorizontalAlign firstLineHorizontalAlignment() const;
 
@@ -170,7 +205,7 @@ private:
     /// Compute the shift in the caret Y coordinate on the new line.
     float computeCaretShift(const LineSpan& lineSpan, VerticalPositioning positioning, BaselinePolicy baselinePolicy, float scale) const;
 
-    spacing evalLineHeight(const uint32_t codepoint, const ImmediateFormat& fmt, const FacePtr face) const;
+    spacing evalLineHeight(const ImmediateFormat& fmt, const Face::Metrics& faceMetrics) const;
 
     // return {spaceCoef, nonSpaceCoef, lineWidth};
     struct JustifyResult
@@ -270,7 +305,8 @@ private:
     struct Sequence
     {
         int start, len;
-        ImmediateFormat format;
+        /// Format of the first style run, the glyph format is the same for all runs of the sequence.
+        ImmediateFormatPtr format;
     };
 
     /**
@@ -278,6 +314,7 @@ private:
      *
      * @param[in]  seq          Sequence to be shaped
      * @param[in]  paragraph    Paragraph providing characters
+     * @param[in]  shapingCache Cache of HarfBuzz shaping results
      * @param[out] result       Shape result can transfer used fonts.
      */
     void shapeSequence(const Sequence& seq,
@@ -285,6 +322,7 @@ private:
                        const FaceTable& faces,
                        const LineBreaker::LineStarts &lineStartsOpt,
                        bool loadGlyphsBearings,
+                       ShapingCache& shapingCache,
                        ShapeResult& result);
 
 private:
@@ -292,12 +330,14 @@ private:
     struct ShapingResult {
         GlyphShapes glyphs_;
         LineSpans lineSpans_;
+        /// Visual runs and the base direction of the paragraph, to break the glyphs into lines again.
+        std::vector<VisualRun> visualRuns_;
+        TextDirection baseDirection_ = TextDirection::LEFT_TO_RIGHT;
     } shapingResult_;
 
     ReportedFaces reportedFaces_;
 
     const utils::Log &log_;
-    const FaceTable &faceTable_;
 };
 using ParagraphShapePtr = std::unique_ptr<ParagraphShape>;
 using ParagraphShapes = std::vector<ParagraphShapePtr>;
@@ -0,0 +1,138 @@
+#include "PlacedTextCache.h"
+
+#include "../common/hash_utils.hpp"
+#include "../fonts/FaceTable.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace odtr {
+
+namespace {
+bool equalFormatRuns(const priv::FormatRuns& a, const priv::FormatRuns& b)
+{
+    return std::equal(a.runs().begin(), a.runs().end(), b.runs().begin(), b.runs().end(), [](const priv::FormatRuns::Run& ra, const priv::FormatRuns::Run& rb) {
+        return ra.start == rb.start &&
+               ra.end == rb.end &&
+               (ra.format == rb.format || priv::equalFormats(*ra.format, *rb.format));
+    });
+}
+
+/// Hashes the value as compared by the keys, a negative zero equals zero.
+void hashFloat(std::size_t& seed, float value)
+{
+    hash_combine(seed, value == 0.0f ? 0.0f : value);
+}
+}
+
+bool PlacedTextCache::Key::operator==(const Key& other) const
+{
+    return hash == other.hash &&
+           text == other.text &&
+           formattingParams == other.formattingParams &&
+           frameSize == other.frameSize &&
+           textTransform == other.textTransform &&
+           faceGenerations == other.faceGenerations &&
+           equalFormatRuns(format, other.format);
+}
+
+PlacedTextCache::Key PlacedTextCache::makeKey(const priv::TextShapeInput& input, const FaceTable& faces)
+{
+    const priv::FormattedText& formattedText = *input.formattedText;
+
+    Key key {
+        formattedText.text(),
+        formattedText.generateFormat(),
+        formattedText.formattingParams(),
+        input.frameSize,
+        input.textTransform,
+        {},
+        0
+    };
+
+    key.faceGenerations.reserve(input.usedFaces.size());
+    for (const std::string& faceName : input.usedFaces) {
+        key.faceGenerations.emplace_back(faceName, faces.getFaceGeneration(faceName));
+    }
+    std::sort(key.faceGenerations.begin(), key.faceGenerations.end());
+
+    // the rest of the formats is compared only when looking the key up
+    std::size_t seed = 0;
+    for (const compat::qchar c : key.text) {
+        hash_combine(seed, c);
+    }
+    for (const priv::FormatRuns::Run& run : key.format.runs()) {
+        hash_combine(seed, run.end);
+        hash_combine(seed, run.format->faceId);
+        hashFloat(seed, run.format->size);
+        hash_combine(seed, run.format->color);
+    }
+    hash_combine(seed, key.formattingParams.boundsMode);
+    hashFloat(seed, key.formattingParams.baseline);
+    if (key.frameSize.has_value()) {
+        hashFloat(seed, key.frameSize->x);
+        hashFloat(seed, key.frameSize->y);
+    }
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            hashFloat(seed, key.textTransform.m[i][j]);
+        }
+    }
+    for (const auto& [faceName, generation] : key.faceGenerations) {
+        hash_combine(seed, faceName);
+        hash_combine(seed, generation);
+    }
+    key.hash = seed;
+
+    return key;
+}
+
+PlacedTextCache::PlacedTextPtr PlacedTextCache::find(const Key& key)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const auto it = entries_.find(key);
+    PlacedTextPtr placedText = it != entries_.end() ? it->second.lock() : nullptr;
+    if (placedText == nullptr) {
+        ++stats_.misses;
+        return nullptr;
+    }
+
+    ++stats_.hits;
+    return placedText;
+}
+
+void PlacedTextCache::insert(const Key& key, const PlacedTextPtr& placedText)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    entries_.insert_or_assign(key, placedText);
+    if (entries_.size() >= nextExpiryCheck_) {
+        removeExpired();
+    }
+    stats_.entries = entries_.size();
+}
+
+void PlacedTextCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    entries_.clear();
+    stats_.entries = 0;
+}
+
+PlacedTextCache::Statistics PlacedTextCache::statistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void PlacedTextCache::removeExpired()
+{
+    for (auto it = entries_.begin(); it != entries_.end(); ) {
+        it = it->second.expired() ? entries_.erase(it) : std::next(it);
+    }
+    nextExpiryCheck_ = std::max<std::size_t>(64, 2 * entries_.size());
+}
+
+} // namespace odtr
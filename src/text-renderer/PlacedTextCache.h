@@ -0,0 +1,91 @@
+#pragma once
+
+#include "FormatRuns.h"
+#include "FormattedText.h"
+#include "TextShapeInput.h"
+#include "../compat/basic-types.h"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace odtr {
+
+class FaceTable;
+struct PlacedTextData;
+
+/**
+ * Placed texts of the live text shapes, looked up by the content of their inputs.
+ *
+ * Texts of equal inputs, shaped with the same generations of the used faces, are placed identically.
+ * Their text shapes share a single immutable placed text instead of shaping the text again, so the shaping time
+ * and the memory depend on the number of distinct texts rather than the number of text shapes.
+ * The cache only refers to the placed texts, an entry expires once no text shape holds its placed text.
+ * The cache is thread-safe, texts may be shaped by multiple threads.
+ */
+class PlacedTextCache
+{
+public:
+    /// Canonical identity of a text shape input.
+    struct Key
+    {
+        std::vector<compat::qchar> text;
+        priv::FormatRuns format;
+        priv::FormattedText::FormattingParams formattingParams;
+        priv::FrameSizeOpt frameSize;
+        compat::Matrix3f textTransform;
+        /// Names of the used faces in ascending order with their generations, see FaceTable::getFaceGeneration.
+        std::vector<std::pair<std::string, std::size_t>> faceGenerations;
+        /// Hash of all the above.
+        std::size_t hash;
+
+        bool operator==(const Key& other) const;
+    };
+
+    using PlacedTextPtr = std::shared_ptr<const PlacedTextData>;
+
+    struct Statistics
+    {
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+        std::size_t entries = 0;
+    };
+
+    PlacedTextCache() = default;
+    PlacedTextCache(const PlacedTextCache&) = delete;
+    PlacedTextCache& operator=(const PlacedTextCache&) = delete;
+
+    /// Creates the key of a text shape input, with the generations of the used faces in @a faces.
+    static Key makeKey(const priv::TextShapeInput& input, const FaceTable& faces);
+
+    /// Returns the placed text of an input of an equal key still held by a text shape, or null. Counts a hit or a miss.
+    PlacedTextPtr find(const Key& key);
+    /// Refers to the placed text shaped from the input of @a key.
+    void insert(const Key& key, const PlacedTextPtr& placedText);
+
+    void clear();
+
+    Statistics statistics() const;
+
+private:
+    struct KeyHasher
+    {
+        std::size_t operator()(const Key& key) const { return key.hash; }
+    };
+
+    /// Drops the expired entries, once their number may have doubled since the last time.
+    void removeExpired();
+
+    mutable std::mutex mutex_;
+
+    std::unordered_map<Key, std::weak_ptr<const PlacedTextData>, KeyHasher> entries_;
+    std::size_t nextExpiryCheck_ = 64;
+
+    Statistics stats_;
+};
+
+} // namespace odtr
@@ -0,0 +1,339 @@
+#include "PlacedTextDiskCache.h"
+
+#include "Config.h"
+#include "PlacedTextSerialization.h"
+#include "TextShapeInput.h"
+#include "../fonts/FaceTable.h"
+
+#include <open-design-text-renderer/PlacedTextData.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <system_error>
+#include <tuple>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace odtr {
+
+namespace {
+
+const char* const FILE_EXTENSION = ".odtr";
+const char* const TEMPORARY_EXTENSION = ".tmp";
+
+/// Changes whenever the contents of the key change, so that stale files are never matched.
+constexpr std::uint64_t KEY_VERSION = 2;
+/// Increase whenever the library places texts differently, so that files written by older versions are not matched.
+constexpr std::uint64_t LAYOUT_REVISION = 1;
+/// Temporary files older than this are left over by writers which didn't finish.
+constexpr std::chrono::minutes STALE_TEMPORARY_FILE_AGE(10);
+
+void addFlag(ContentHasher& hasher, bool value)
+{
+    hasher.add(static_cast<std::uint64_t>(value));
+}
+
+template <typename E>
+void addEnum(ContentHasher& hasher, E value)
+{
+    hasher.add(static_cast<std::uint64_t>(value));
+}
+
+void addConfig(ContentHasher& hasher, const priv::Config& config)
+{
+    addFlag(hasher, config.floorBaseline);
+    addFlag(hasher, config.limitJustifySpaceWidth);
+    addFlag(hasher, config.justifyAmbiguous);
+    addFlag(hasher, config.cutLastLine);
+    addFlag(hasher, config.disregardFirstBearing);
+    addFlag(hasher, config.disregardLastSpacing);
+    addFlag(hasher, config.enableRtl);
+    addFlag(hasher, config.allowTrueTypeKerning);
+    addFlag(hasher, config.forceTrueTypeKerning);
+    addFlag(hasher, config.infiniteVerticalStretch);
+    addFlag(hasher, config.lastLineDescenderOffset);
+    addFlag(hasher, config.preferRealLineHeightOverExplicit);
+    addFlag(hasher, config.exportOutlines);
+    addFlag(hasher, config.internalDisableHinting);
+    addFlag(hasher, config.enableViewAreaCutout);
+}
+
+void addFormat(ContentHasher& hasher, const ImmediateFormat& format)
+{
+    hasher.add(format.faceId);
+    hasher.add(format.size);
+    addEnum(hasher, format.ligatures);
+    addEnum(hasher, format.direction);
+    hasher.add(static_cast<std::uint64_t>(format.features.size()));
+    for (const TypeFeature& feature : format.features) {
+        hasher.add(feature.tag);
+        hasher.add(static_cast<std::uint64_t>(static_cast<std::int64_t>(feature.value)));
+    }
+    hasher.add(static_cast<std::uint64_t>(format.tabStops.size()));
+    for (const spacing tabStop : format.tabStops) {
+        hasher.add(tabStop);
+    }
+
+    hasher.add(format.lineHeight);
+    hasher.add(format.minLineHeight);
+    hasher.add(format.maxLineHeight);
+    hasher.add(format.letterSpacing);
+    hasher.add(format.paragraphSpacing);
+    hasher.add(format.paragraphIndent);
+    hasher.add(static_cast<std::uint64_t>(format.color));
+    hasher.add(static_cast<std::uint64_t>(format.decorations.size()));
+    for (const Decoration decoration : format.decorations) {
+        addEnum(hasher, decoration);
+    }
+    addEnum(hasher, format.align);
+    addFlag(hasher, format.kerning);
+    addFlag(hasher, format.uppercase);
+    addFlag(hasher, format.lowercase);
+}
+
+/// Identifies the files written by this instance, so that concurrent writers never share a temporary file.
+std::string createWriterId()
+{
+    std::random_device random;
+    return std::to_string(random()) + std::to_string(random());
+}
+
+}
+
+PlacedTextDiskCache::PlacedTextDiskCache(const std::string& directory, std::size_t budget)
+    : budget_(budget)
+{
+    if (directory.empty() || budget == 0) {
+        return;
+    }
+
+    std::error_code error;
+    fs::create_directories(directory, error);
+    if (error || !fs::is_directory(directory, error)) {
+        return;
+    }
+    directory_ = directory;
+
+    const fs::file_time_type staleTime = fs::file_time_type::clock::now() - STALE_TEMPORARY_FILE_AGE;
+    for (fs::directory_iterator it(directory_, error), end; !error && it != end; it.increment(error)) {
+        std::error_code fileError;
+        if (!it->is_regular_file(fileError)) {
+            continue;
+        }
+        if (it->path().extension() == FILE_EXTENSION) {
+            size_ += static_cast<std::size_t>(it->file_size(fileError));
+            ++stats_.entries;
+        } else if (it->path().extension() == TEMPORARY_EXTENSION && it->last_write_time(fileError) < staleTime && !fileError) {
+            fs::remove(it->path(), fileError);
+        }
+    }
+}
+
+std::optional<ContentHash> PlacedTextDiskCache::makeKey(const priv::TextShapeInput& input, const priv::Config& config, const FaceTable& faces)
+{
+    ContentHasher hasher;
+    hasher.add(KEY_VERSION);
+    hasher.add(LAYOUT_REVISION);
+    hasher.add(static_cast<std::uint64_t>(priv::PLACED_TEXT_FORMAT_VERSION));
+    addConfig(hasher, config);
+
+    const priv::FormattedText& formattedText = *input.formattedText;
+    hasher.add(static_cast<std::uint64_t>(formattedText.text().size()));
+    for (const compat::qchar c : formattedText.text()) {
+        hasher.add(static_cast<std::uint64_t>(c));
+    }
+
+    const priv::FormatRuns format = formattedText.generateFormat();
+    hasher.add(static_cast<std::uint64_t>(format.runs().size()));
+    for (const priv::FormatRuns::Run& run : format.runs()) {
+        hasher.add(static_cast<std::uint64_t>(run.end));
+        addFormat(hasher, *run.format);
+    }
+
+    const priv::FormattedText::FormattingParams& params = formattedText.formattingParams();
+    addEnum(hasher, params.verticalAlign);
+    addEnum(hasher, params.boundsMode);
+    hasher.add(params.baseline);
+    addEnum(hasher, params.horizontalPositioning);
+    addEnum(hasher, params.baselinePolicy);
+    addEnum(hasher, params.overflowPolicy);
+
+    addFlag(hasher, input.frameSize.has_value());
+    if (input.frameSize.has_value()) {
+        hasher.add(input.frameSize->x);
+        hasher.add(input.frameSize->y);
+    }
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            hasher.add(input.textTransform.m[i][j]);
+        }
+    }
+
+    // the faces are identified by their content rather than the name they were loaded under
+    std::vector<std::string> faceNames(input.usedFaces.begin(), input.usedFaces.end());
+    std::sort(faceNames.begin(), faceNames.end());
+    for (const std::string& faceName : faceNames) {
+        const FaceTable::Item* faceItem = faces.getFaceItem(faceName);
+        if (faceItem == nullptr || faceItem->face == nullptr) {
+            return std::nullopt;
+        }
+        if (faceItem->fontData == nullptr) {
+            return std::nullopt;
+        }
+        const ContentHash& fontDataHash = faceItem->fontData->hash();
+        hasher.add(faceName);
+        hasher.add(fontDataHash.data(), fontDataHash.size());
+        hasher.add(static_cast<std::uint64_t>(faceItem->face->getFtFace()->face_index));
+        addFlag(hasher, faceItem->fallback);
+    }
+
+    return hasher.finish();
+}
+
+std::unique_ptr<PlacedTextData> PlacedTextDiskCache::find(const ContentHash& key)
+{
+    if (!enabled()) {
+        return nullptr;
+    }
+
+    const std::string path = pathOf(key);
+    std::unique_ptr<PlacedTextData> placedText;
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (file.is_open()) {
+            const std::vector<std::uint8_t> blob((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            if (priv::PlacedTextDeserializeResult result = priv::deserializePlacedText(blob.data(), blob.size())) {
+                placedText = result.moveValue();
+            }
+        }
+    }
+
+    std::error_code error;
+    if (placedText != nullptr) {
+        // the modification time orders the files by their last use
+        fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (placedText == nullptr) {
+        ++stats_.misses;
+        return nullptr;
+    }
+    ++stats_.hits;
+    return placedText;
+}
+
+void PlacedTextDiskCache::insert(const ContentHash& key, const PlacedTextData& placedText)
+{
+    if (!enabled()) {
+        return;
+    }
+
+    static const std::string writerId = createWriterId();
+    static std::atomic<std::size_t> writeCounter(0);
+
+    const std::vector<std::uint8_t> blob = priv::serializePlacedText(placedText, true);
+    const std::string path = pathOf(key);
+    const std::string temporaryPath = path + "." + writerId + "-" + std::to_string(writeCounter++) + TEMPORARY_EXTENSION;
+
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(blob.data()), static_cast<std::streamsize>(blob.size()));
+        if (!file.is_open() || !file.good()) {
+            file.close();
+            std::error_code error;
+            fs::remove(temporaryPath, error);
+            return;
+        }
+    }
+
+    // a file of the same key may have been written meanwhile, it gets replaced
+    std::error_code error;
+    const std::uintmax_t replacedSize = fs::file_size(path, error);
+    const bool replaced = !error;
+    fs::rename(temporaryPath, path, error);
+    if (error) {
+        fs::remove(temporaryPath, error);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (replaced) {
+        size_ -= std::min(size_, static_cast<std::size_t>(replacedSize));
+    } else {
+        ++stats_.entries;
+    }
+    size_ += blob.size();
+    if (size_ > budget_) {
+        evict();
+    }
+}
+
+PlacedTextDiskCache::Statistics PlacedTextDiskCache::statistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Statistics stats = stats_;
+    stats.bytes = size_;
+    return stats;
+}
+
+std::string PlacedTextDiskCache::pathOf(const ContentHash& key) const
+{
+    return (fs::path(directory_) / (toHexString(key) + FILE_EXTENSION)).string();
+}
+
+void PlacedTextDiskCache::evict()
+{
+    struct File
+    {
+        fs::file_time_type lastUse;
+        std::size_t size;
+        fs::path path;
+    };
+
+    // other processes may have written or removed files meanwhile, the sizes are taken anew
+    std::vector<File> files;
+    std::size_t size = 0;
+    std::error_code error;
+    for (fs::directory_iterator it(directory_, error), end; !error && it != end; it.increment(error)) {
+        std::error_code fileError;
+        if (it->path().extension() != FILE_EXTENSION || !it->is_regular_file(fileError)) {
+            continue;
+        }
+        const std::size_t fileSize = static_cast<std::size_t>(it->file_size(fileError));
+        const fs::file_time_type lastUse = it->last_write_time(fileError);
+        if (!fileError) {
+            files.push_back(File { lastUse, fileSize, it->path() });
+            size += fileSize;
+        }
+    }
+
+    std::sort(files.begin(), files.end(), [](const File& a, const File& b) {
+        return std::tie(a.lastUse, a.path) < std::tie(b.lastUse, b.path);
+    });
+
+    const std::size_t targetSize = budget_ / 4 * 3;
+    std::size_t entries = files.size();
+    for (const File& file : files) {
+        if (size <= targetSize) {
+            break;
+        }
+        std::error_code removeError;
+        if (fs::remove(file.path, removeError)) {
+            size -= file.size;
+            --entries;
+            ++stats_.evictions;
+        }
+    }
+
+    size_ = size;
+    stats_.entries = entries;
+}
+
+} // namespace odtr
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "../common/content_hash.h"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace odtr {
+
+class FaceTable;
+struct PlacedTextData;
+
+namespace priv {
+struct Config;
+struct TextShapeInput;
+}
+
+/**
+ * Placed texts stored in a directory, so that texts shaped by one context can be reused by contexts
+ * created later, possibly by other processes sharing the directory.
+ *
+ * Each placed text is a file named by the digest of everything its placement depends on: the parsed text
+ * with its formats, the configuration and the content of the used faces, see makeKey. The files are written
+ * to a temporary file first and renamed, so readers never see a partial file. Reading a file marks it as
+ * recently used, the least recently used files are removed once their total size exceeds the budget.
+ */
+class PlacedTextDiskCache
+{
+public:
+    struct Statistics
+    {
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+        std::size_t evictions = 0;
+        std::size_t entries = 0;
+        std::size_t bytes = 0;
+    };
+
+    /// The cache is disabled if @a directory is empty or can't be created.
+    PlacedTextDiskCache(const std::string& directory, std::size_t budget);
+    PlacedTextDiskCache(const PlacedTextDiskCache&) = delete;
+    PlacedTextDiskCache& operator=(const PlacedTextDiskCache&) = delete;
+
+    bool enabled() const { return !directory_.empty(); }
+
+    /// Creates the key of a text shape input, none if one of the used faces isn't loaded in @a faces.
+    static std::optional<ContentHash> makeKey(const priv::TextShapeInput& input, const priv::Config& config, const FaceTable& faces);
+
+    /// Reads the placed text stored under the key, null if there's none or it can't be read. Counts a hit or a miss.
+    std::unique_ptr<PlacedTextData> find(const ContentHash& key);
+    /// Stores the placed text under the key, removes the least recently used files if the budget is exceeded.
+    void insert(const ContentHash& key, const PlacedTextData& placedText);
+
+    Statistics statistics() const;
+
+private:
+    std::string pathOf(const ContentHash& key) const;
+
+    /// Removes the least recently used files until their size drops to 3/4 of the budget.
+    void evict();
+
+    std::string directory_;
+    std::size_t budget_;
+
+    mutable std::mutex mutex_;
+    /// Size of the files in the directory, estimated between evictions as other processes may write too.
+    std::size_t size_ = 0;
+    Statistics stats_;
+};
+
+} // namespace odtr
@@ -9,26 +9,18 @@
 #include "BitmapWriter.h"
 #include "Glyph.h"
 #include "Face.h"
+#include "GlyphCache.h"
 
 #include "../utils/utils.h"
 
 namespace odtr {
 namespace priv {
 
-GlyphPtr renderPlacedGlyph(const PlacedGlyph &placedGlyph,
+GlyphPtr renderPlacedGlyph(GlyphCache &glyphCache,
+                           const PlacedGlyph &placedGlyph,
                            const FacePtr &face,
                            RenderScale scale,
                            bool internalDisableHinting) {
-    float bitmapGlyphScale = 1.0f;
-    const Result<font_size,bool> setSizeRes = face->setSize(placedGlyph.fontSize);
-
-    if (setSizeRes && !face->isScalable()) {
-        const float resizeFactor = placedGlyph.fontSize / setSizeRes.value();
-        const float ascender = FreetypeHandle::from26_6fixed(face->getFtFace()->size->metrics.ascender) * resizeFactor;
-
-        bitmapGlyphScale = (ascender * scale) / setSizeRes.value();
-    }
-
     const Vector2f originOnBitmap {
         std::floor(placedGlyph.originPosition.x * scale),
         std::floor(placedGlyph.originPosition.y * scale),
@@ -37,11 +29,28 @@ GlyphPtr renderPlacedGlyph(const PlacedGlyph &placedGlyph,
         placedGlyph.originPosition.x * scale - originOnBitmap.x,
         placedGlyph.originPosition.y * scale - originOnBitmap.y,
     };
-    const ScaleParams glyphScaleParams { scale, bitmapGlyphScale };
 
-    GlyphPtr glyph = face->acquireGlyph(placedGlyph.codepoint, offset, glyphScaleParams, true, internalDisableHinting);
+    const GlyphCache::Key cacheKey = GlyphCache::makeKey(face->origin(), placedGlyph.codepoint, placedGlyph.fontSize, scale, offset, internalDisableHinting);
+    GlyphPtr glyph = glyphCache.find(cacheKey);
+
     if (!glyph) {
-        return nullptr;
+        float bitmapGlyphScale = 1.0f;
+        const Result<font_size,bool> setSizeRes = face->setSize(placedGlyph.fontSize);
+
+        if (setSizeRes && !face->isScalable()) {
+            const float resizeFactor = placedGlyph.fontSize / setSizeRes.value();
+            const float ascender = face->getMetrics().ascender * resizeFactor;
+
+            bitmapGlyphScale = (ascender * scale) / setSizeRes.value();
+        }
+
+        const ScaleParams glyphScaleParams { scale, bitmapGlyphScale };
+
+        glyph = face->acquireGlyph(placedGlyph.codepoint, offset, glyphScaleParams, true, internalDisableHinting);
+        if (!glyph) {
+            return nullptr;
+        }
+        glyphCache.insert(cacheKey, *glyph);
     }
 
     glyph->setDestination({
@@ -187,7 +196,7 @@ void debug::drawGlyphBoundingRectangle(compat::BitmapRGBA &bitmap, const FacePtr
 
     if (setSizeRes && !face->isScalable()) {
         const float resizeFactor = pg.fontSize / setSizeRes.value();
-        const float ascender = FreetypeHandle::from26_6fixed(face->getFtFace()->size->metrics.ascender) * resizeFactor;
+        const float ascender = face->getMetrics().ascender * resizeFactor;
 
         bitmapGlyphScale = (ascender * scale) / setSizeRes.value();
     }
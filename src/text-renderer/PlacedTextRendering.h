@@ -9,6 +9,7 @@ namespace odtr {
 struct PlacedGlyph;
 struct PlacedDecoration;
 class Glyph;
+class GlyphCache;
 class FacePtr;
 using GlyphPtr = std::unique_ptr<Glyph>;
 typedef float RenderScale;
@@ -17,7 +18,9 @@ typedef float RenderScale;
 namespace odtr {
 namespace priv {
 
-GlyphPtr renderPlacedGlyph(const PlacedGlyph &placedGlyph,
+/// Renders the glyph or retrieves it from the glyph cache.
+GlyphPtr renderPlacedGlyph(GlyphCache &glyphCache,
+                           const PlacedGlyph &placedGlyph,
                            const FacePtr &face,
                            RenderScale scale,
                            bool internalDisableHinting);
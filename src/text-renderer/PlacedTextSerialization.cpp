@@ -0,0 +1,475 @@
+#include "PlacedTextSerialization.h"
+
+#include "../vendor/lz4/lz4.h"
+
+#include <cstring>
+#include <limits>
+#include <string>
+
+namespace odtr {
+namespace priv {
+
+namespace {
+
+constexpr std::uint8_t MAGIC[4] = { 'O', 'D', 'T', 'R' };
+constexpr std::size_t HEADER_SIZE = 12;
+/// LZ4 doesn't compress better than 255:1, larger sizes in a header are corrupted.
+constexpr std::size_t LZ4_MAX_RATIO = 255;
+
+std::uint32_t floatBits(float value)
+{
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+float bitsFloat(std::uint32_t bits)
+{
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+class BlobWriter
+{
+public:
+    explicit BlobWriter(std::vector<std::uint8_t> &bytes) : bytes_(bytes) { }
+
+    void u8(std::uint8_t value)
+    {
+        bytes_.push_back(value);
+    }
+
+    void u16(std::uint16_t value)
+    {
+        u8(static_cast<std::uint8_t>(value));
+        u8(static_cast<std::uint8_t>(value >> 8));
+    }
+
+    void u32(std::uint32_t value)
+    {
+        u16(static_cast<std::uint16_t>(value));
+        u16(static_cast<std::uint16_t>(value >> 16));
+    }
+
+    void f32(float value)
+    {
+        u32(floatBits(value));
+    }
+
+    void varint(std::uint64_t value)
+    {
+        while (value >= 0x80) {
+            u8(static_cast<std::uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        u8(static_cast<std::uint8_t>(value));
+    }
+
+    void svarint(std::int64_t value)
+    {
+        varint((static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+    }
+
+    /// Writes @a value as the difference of its bits from @a previous, exact unlike a difference of the floats.
+    void floatDelta(float value, float previous)
+    {
+        svarint(static_cast<std::int64_t>(floatBits(value)) - static_cast<std::int64_t>(floatBits(previous)));
+    }
+
+    void string(const std::string &value)
+    {
+        varint(value.size());
+        bytes_.insert(bytes_.end(), value.begin(), value.end());
+    }
+
+    void rectangle(const FRectangle &rect)
+    {
+        f32(rect.l);
+        f32(rect.t);
+        f32(rect.w);
+        f32(rect.h);
+    }
+
+private:
+    std::vector<std::uint8_t> &bytes_;
+};
+
+/// Reads a blob written by BlobWriter, reading past the end fails all the subsequent reads.
+class BlobReader
+{
+public:
+    BlobReader(const std::uint8_t *data, std::size_t length) : data_(data), end_(data + length) { }
+
+    bool ok() const { return ok_; }
+    void fail() { ok_ = false; }
+    bool atEnd() const { return data_ == end_; }
+    std::size_t remaining() const { return static_cast<std::size_t>(end_ - data_); }
+
+    std::uint8_t u8()
+    {
+        if (!ok_ || data_ == end_) {
+            fail();
+            return 0;
+        }
+        return *data_++;
+    }
+
+    std::uint16_t u16()
+    {
+        const std::uint16_t low = u8();
+        return static_cast<std::uint16_t>(low | (u8() << 8));
+    }
+
+    std::uint32_t u32()
+    {
+        const std::uint32_t low = u16();
+        return low | (static_cast<std::uint32_t>(u16()) << 16);
+    }
+
+    float f32()
+    {
+        return bitsFloat(u32());
+    }
+
+    std::uint64_t varint()
+    {
+        std::uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const std::uint8_t byte = u8();
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        fail();
+        return 0;
+    }
+
+    std::int64_t svarint()
+    {
+        const std::uint64_t value = varint();
+        return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+    }
+
+    float floatDelta(float previous)
+    {
+        const std::int64_t bits = static_cast<std::int64_t>(floatBits(previous)) + svarint();
+        if (bits < 0 || bits > static_cast<std::int64_t>(UINT32_MAX)) {
+            fail();
+            return 0.0f;
+        }
+        return bitsFloat(static_cast<std::uint32_t>(bits));
+    }
+
+    std::uint32_t u32varint()
+    {
+        const std::uint64_t value = varint();
+        if (value > UINT32_MAX) {
+            fail();
+            return 0;
+        }
+        return static_cast<std::uint32_t>(value);
+    }
+
+    /// Reads an index as the difference from @a previous, fails if it is negative or out of range.
+    std::size_t indexDelta(std::size_t previous)
+    {
+        const std::int64_t delta = svarint();
+        const std::int64_t base = static_cast<std::int64_t>(previous);
+        if (delta < -base || delta > std::numeric_limits<std::int64_t>::max() - base) {
+            fail();
+            return 0;
+        }
+        return static_cast<std::size_t>(base + delta);
+    }
+
+    /// Reads a number of items of at least one byte each, fails if there can't be as many.
+    std::size_t count()
+    {
+        const std::uint64_t value = varint();
+        if (value > remaining()) {
+            fail();
+            return 0;
+        }
+        return static_cast<std::size_t>(value);
+    }
+
+    std::string string()
+    {
+        const std::size_t len = count();
+        if (!ok_) {
+            return {};
+        }
+        std::string value(reinterpret_cast<const char *>(data_), len);
+        data_ += len;
+        return value;
+    }
+
+    FRectangle rectangle()
+    {
+        FRectangle rect;
+        rect.l = f32();
+        rect.t = f32();
+        rect.w = f32();
+        rect.h = f32();
+        return rect;
+    }
+
+private:
+    const std::uint8_t *data_;
+    const std::uint8_t *end_;
+    bool ok_ = true;
+};
+
+/// Writes the runs of equal values of the glyphs' property.
+template <typename Value, typename Getter>
+void writeRuns(BlobWriter &writer, const PlacedGlyphs &glyphs, const Getter &get, void (BlobWriter::*write)(Value))
+{
+    std::vector<std::pair<std::size_t, Value>> runs;
+    for (const PlacedGlyph &glyph : glyphs) {
+        if (runs.empty() || runs.back().second != get(glyph)) {
+            runs.emplace_back(0, get(glyph));
+        }
+        ++runs.back().first;
+    }
+
+    writer.varint(runs.size());
+    for (const auto &[length, value] : runs) {
+        writer.varint(length);
+        (writer.*write)(value);
+    }
+}
+
+/// Reads the runs written by writeRuns into the glyphs' property, fails unless they cover all the glyphs.
+template <typename Value, typename Setter>
+void readRuns(BlobReader &reader, PlacedGlyphs &glyphs, const Setter &set, Value (BlobReader::*read)())
+{
+    const std::size_t runCount = reader.count();
+    std::size_t g = 0;
+    for (std::size_t r = 0; r < runCount && reader.ok(); ++r) {
+        const std::uint64_t length = reader.varint();
+        const Value value = (reader.*read)();
+        if (length > glyphs.size() - g) {
+            reader.fail();
+            return;
+        }
+        for (const std::size_t end = g + static_cast<std::size_t>(length); g < end; ++g) {
+            set(glyphs[g], value);
+        }
+    }
+    if (g != glyphs.size()) {
+        reader.fail();
+    }
+}
+
+void writePayload(BlobWriter &writer, const PlacedTextData &placedTextData)
+{
+    writer.rectangle(placedTextData.textBounds);
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            writer.f32(placedTextData.textTransform.m[i][j]);
+        }
+    }
+
+    writer.varint(placedTextData.lineBounds.size());
+    for (const FRectangle &lineBounds : placedTextData.lineBounds) {
+        writer.rectangle(lineBounds);
+    }
+
+    // the faces are named once, the glyphs follow in the same order
+    writer.varint(placedTextData.glyphs.size());
+    for (const auto &fontGlyphs : placedTextData.glyphs) {
+        writer.string(fontGlyphs.first.faceId);
+    }
+
+    for (const auto &fontGlyphs : placedTextData.glyphs) {
+        const PlacedGlyphs &glyphs = fontGlyphs.second;
+        writer.varint(glyphs.size());
+
+        writeRuns(writer, glyphs, [](const PlacedGlyph &glyph) { return glyph.fontSize; }, &BlobWriter::f32);
+        writeRuns(writer, glyphs, [](const PlacedGlyph &glyph) { return glyph.color; }, &BlobWriter::u32);
+
+        PlacedGlyph previous {};
+        for (const PlacedGlyph &glyph : glyphs) {
+            writer.varint(glyph.codepoint);
+            writer.svarint(static_cast<std::int64_t>(glyph.index) - static_cast<std::int64_t>(previous.index));
+            writer.svarint(static_cast<std::int64_t>(glyph.lineIndex) - static_cast<std::int64_t>(previous.lineIndex));
+            writer.floatDelta(glyph.originPosition.x, previous.originPosition.x);
+            writer.floatDelta(glyph.originPosition.y, previous.originPosition.y);
+            writer.floatDelta(glyph.bounds.l, glyph.originPosition.x);
+            writer.floatDelta(glyph.bounds.t, glyph.originPosition.y);
+            writer.floatDelta(glyph.bounds.w, previous.bounds.w);
+            writer.floatDelta(glyph.bounds.h, previous.bounds.h);
+            previous = glyph;
+        }
+    }
+
+    writer.varint(placedTextData.decorations.size());
+    for (const PlacedDecoration &decoration : placedTextData.decorations) {
+        writer.u8(static_cast<std::uint8_t>(decoration.type));
+        writer.f32(decoration.start.x);
+        writer.f32(decoration.start.y);
+        writer.f32(decoration.end.x);
+        writer.f32(decoration.end.y);
+        writer.f32(decoration.thickness);
+        writer.u32(decoration.color);
+    }
+}
+
+PlacedTextDeserializeResult readPayload(BlobReader &reader)
+{
+    PlacedTextDataPtr placedTextData = std::make_unique<PlacedTextData>();
+
+    placedTextData->textBounds = reader.rectangle();
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            placedTextData->textTransform.m[i][j] = reader.f32();
+        }
+    }
+
+    placedTextData->lineBounds.resize(reader.count());
+    for (FRectangle &lineBounds : placedTextData->lineBounds) {
+        lineBounds = reader.rectangle();
+    }
+
+    std::vector<FontSpecifier> fonts(reader.count());
+    for (FontSpecifier &font : fonts) {
+        font.faceId = reader.string();
+    }
+
+    for (const FontSpecifier &font : fonts) {
+        PlacedGlyphs glyphs(reader.count());
+
+        readRuns(reader, glyphs, [](PlacedGlyph &glyph, float fontSize) { glyph.fontSize = fontSize; }, &BlobReader::f32);
+        readRuns(reader, glyphs, [](PlacedGlyph &glyph, std::uint32_t color) { glyph.color = color; }, &BlobReader::u32);
+
+        const std::size_t lineCount = placedTextData->lineBounds.size();
+        PlacedGlyph previous {};
+        for (PlacedGlyph &glyph : glyphs) {
+            glyph.codepoint = reader.u32varint();
+            glyph.index = reader.indexDelta(previous.index);
+            glyph.lineIndex = reader.indexDelta(previous.lineIndex);
+            // glyphs are stored in line order, culling relies on it
+            if (glyph.lineIndex < previous.lineIndex || (lineCount != 0 && glyph.lineIndex >= lineCount)) {
+                return SerializationError::CORRUPTED_DATA;
+            }
+            glyph.originPosition.x = reader.floatDelta(previous.originPosition.x);
+            glyph.originPosition.y = reader.floatDelta(previous.originPosition.y);
+            glyph.bounds.l = reader.floatDelta(glyph.originPosition.x);
+            glyph.bounds.t = reader.floatDelta(glyph.originPosition.y);
+            glyph.bounds.w = reader.floatDelta(previous.bounds.w);
+            glyph.bounds.h = reader.floatDelta(previous.bounds.h);
+            previous = glyph;
+        }
+
+        if (!reader.ok() || !placedTextData->glyphs.emplace(font, std::move(glyphs)).second) {
+            return SerializationError::CORRUPTED_DATA;
+        }
+    }
+
+    placedTextData->decorations.resize(reader.count());
+    for (PlacedDecoration &decoration : placedTextData->decorations) {
+        const std::uint8_t type = reader.u8();
+        if (type > static_cast<std::uint8_t>(PlacedDecoration::Type::STRIKE_THROUGH)) {
+            return SerializationError::CORRUPTED_DATA;
+        }
+        decoration.type = static_cast<PlacedDecoration::Type>(type);
+        decoration.start.x = reader.f32();
+        decoration.start.y = reader.f32();
+        decoration.end.x = reader.f32();
+        decoration.end.y = reader.f32();
+        decoration.thickness = reader.f32();
+        decoration.color = reader.u32();
+    }
+
+    if (!reader.ok() || !reader.atEnd()) {
+        return SerializationError::CORRUPTED_DATA;
+    }
+
+    return placedTextData;
+}
+
+} // namespace
+
+std::vector<std::uint8_t> serializePlacedText(const PlacedTextData &placedTextData, bool compress)
+{
+    std::vector<std::uint8_t> payload;
+    BlobWriter payloadWriter(payload);
+    writePayload(payloadWriter, placedTextData);
+
+    std::vector<std::uint8_t> compressed;
+    if (compress && payload.size() <= LZ4_MAX_INPUT_SIZE) {
+        const int srcSize = static_cast<int>(payload.size());
+        compressed.resize(static_cast<std::size_t>(LZ4_compressBound(srcSize)));
+        const int compressedSize = LZ4_compress_default(reinterpret_cast<const char *>(payload.data()),
+                                                        reinterpret_cast<char *>(compressed.data()),
+                                                        srcSize,
+                                                        static_cast<int>(compressed.size()));
+        compressed.resize(compressedSize > 0 && compressedSize < srcSize ? static_cast<std::size_t>(compressedSize) : 0);
+    }
+
+    std::vector<std::uint8_t> blob;
+    BlobWriter writer(blob);
+    for (const std::uint8_t byte : MAGIC) {
+        writer.u8(byte);
+    }
+    writer.u16(PLACED_TEXT_FORMAT_VERSION);
+    writer.u8(compressed.empty() ? 0 : PLACED_TEXT_LZ4);
+    writer.u8(0);
+    writer.u32(static_cast<std::uint32_t>(payload.size()));
+
+    const std::vector<std::uint8_t> &body = compressed.empty() ? payload : compressed;
+    blob.insert(blob.end(), body.begin(), body.end());
+    return blob;
+}
+
+PlacedTextDeserializeResult deserializePlacedText(const std::uint8_t *data, std::size_t length)
+{
+    if (data == nullptr || length < HEADER_SIZE || std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0) {
+        return SerializationError::INVALID_HEADER;
+    }
+
+    BlobReader header(data + sizeof(MAGIC), HEADER_SIZE - sizeof(MAGIC));
+    const std::uint16_t version = header.u16();
+    const std::uint8_t flags = header.u8();
+    header.u8();
+    const std::uint32_t payloadSize = header.u32();
+
+    if (version != PLACED_TEXT_FORMAT_VERSION) {
+        return SerializationError::UNSUPPORTED_VERSION;
+    }
+    if ((flags & ~PLACED_TEXT_LZ4) != 0) {
+        return SerializationError::INVALID_HEADER;
+    }
+
+    const std::uint8_t *body = data + HEADER_SIZE;
+    const std::size_t bodySize = length - HEADER_SIZE;
+
+    if ((flags & PLACED_TEXT_LZ4) == 0) {
+        if (bodySize != payloadSize) {
+            return SerializationError::CORRUPTED_DATA;
+        }
+        BlobReader reader(body, bodySize);
+        return readPayload(reader);
+    }
+
+    if (payloadSize > LZ4_MAX_INPUT_SIZE || bodySize > LZ4_MAX_INPUT_SIZE || payloadSize > bodySize * LZ4_MAX_RATIO) {
+        return SerializationError::DECOMPRESSION_ERROR;
+    }
+
+    std::vector<std::uint8_t> payload(payloadSize);
+    const int decompressedSize = LZ4_decompress_safe(reinterpret_cast<const char *>(body),
+                                                     reinterpret_cast<char *>(payload.data()),
+                                                     static_cast<int>(bodySize),
+                                                     static_cast<int>(payload.size()));
+    if (decompressedSize != static_cast<int>(payloadSize)) {
+        return SerializationError::DECOMPRESSION_ERROR;
+    }
+
+    BlobReader reader(payload.data(), payload.size());
+    return readPayload(reader);
+}
+
+} // namespace priv
+} // namespace odtr
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <open-design-text-renderer/PlacedTextData.h>
+
+#include "errors.h"
+#include "../common/result.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace odtr {
+namespace priv {
+
+/**
+ * Serialized placed text:
+ *
+ *   header     magic "ODTR", u16 format version, u8 flags, u8 reserved, u32 payload size
+ *   payload    raw or LZ4 compressed (see PLACED_TEXT_LZ4), payload size is the uncompressed size
+ *
+ * The payload holds the text bounds and transform, the line bounds, the names of the faces and the glyphs
+ * of each face, followed by the decorations. Glyph positions are stored as differences of the float bits
+ * from the previous glyph, font sizes and colors as runs of equal values. All the numbers are little-endian,
+ * counts and differences are variable-length integers. Face handles are not stored, they are only valid
+ * within a context.
+ */
+constexpr std::uint16_t PLACED_TEXT_FORMAT_VERSION = 1;
+/// Header flag of a LZ4 compressed payload.
+constexpr std::uint8_t PLACED_TEXT_LZ4 = 0x01;
+
+using PlacedTextDeserializeResult = Result<PlacedTextDataPtr, SerializationError>;
+
+/// Serializes the placed text, the payload is compressed if @a compress and the compression reduces its size.
+std::vector<std::uint8_t> serializePlacedText(const PlacedTextData &placedTextData, bool compress);
+
+/// Restores a placed text serialized by serializePlacedText, the faces are identified by name only.
+PlacedTextDeserializeResult deserializePlacedText(const std::uint8_t *data, std::size_t length);
+
+} // namespace priv
+} // namespace odtr
@@ -0,0 +1,182 @@
+#include "ShapingCache.h"
+
+#include "../common/hash_utils.hpp"
+
+#include <algorithm>
+
+namespace odtr {
+
+namespace {
+bool equalFeatures(const std::vector<hb_feature_t>& a, const std::vector<hb_feature_t>& b)
+{
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const hb_feature_t& fa, const hb_feature_t& fb) {
+        return fa.tag == fb.tag && fa.value == fb.value && fa.start == fb.start && fa.end == fb.end;
+    });
+}
+}
+
+bool ShapingCache::Key::operator==(const Key& other) const
+{
+    return face == other.face &&
+           fontSize == other.fontSize &&
+           direction == other.direction &&
+           script == other.script &&
+           language == other.language &&
+           runOffset == other.runOffset &&
+           runLength == other.runLength &&
+           text == other.text &&
+           equalFeatures(features, other.features);
+}
+
+std::size_t ShapingCache::KeyHasher::operator()(const Key& key) const
+{
+    std::size_t seed = 0;
+    hash_combine(seed, key.face);
+    hash_combine(seed, key.fontSize);
+    hash_combine(seed, key.direction);
+    hash_combine(seed, key.script);
+    hash_combine(seed, key.language);
+    hash_combine(seed, key.runOffset);
+    hash_combine(seed, key.runLength);
+    for (const compat::qchar c : key.text) {
+        hash_combine(seed, c);
+    }
+    for (const hb_feature_t& feature : key.features) {
+        hash_combine(seed, feature.tag);
+        hash_combine(seed, feature.value);
+    }
+    return seed;
+}
+
+ShapingCache::ShapingCache(std::size_t byteBudget)
+    : byteBudget_(byteBudget)
+{
+}
+
+ShapingCache::Key ShapingCache::makeKey(const Face* face,
+                                        font_size fontSize,
+                                        const std::vector<hb_feature_t>& features,
+                                        const hb_segment_properties_t& properties,
+                                        const std::vector<compat::qchar>& text,
+                                        int start,
+                                        int len,
+                                        bool withContext)
+{
+    const int textLen = static_cast<int>(text.size());
+    const int contextLength = withContext ? CONTEXT_LENGTH : 0;
+    const int contextStart = std::max(0, start - contextLength);
+    const int contextEnd = std::min(textLen, start + len + contextLength);
+
+    return Key {
+        face,
+        fontSize,
+        features,
+        properties.direction,
+        properties.script,
+        properties.language,
+        std::vector<compat::qchar>(text.begin() + contextStart, text.begin() + contextEnd),
+        start - contextStart,
+        len
+    };
+}
+
+ShapingCache::ShapedRunPtr ShapingCache::makeShapedRun(hb_buffer_t* hbBuffer, int start)
+{
+    const unsigned int hbLen = hb_buffer_get_length(hbBuffer);
+    const hb_glyph_position_t* hbPos = hb_buffer_get_glyph_positions(hbBuffer, nullptr);
+    const hb_glyph_info_t* hbInfo = hb_buffer_get_glyph_infos(hbBuffer, nullptr);
+
+    auto run = std::make_shared<ShapedRun>();
+    run->reserve(hbLen);
+    for (unsigned int i = 0; i < hbLen; ++i) {
+        run->push_back(ShapedGlyph { hbInfo[i].codepoint, hbInfo[i].cluster - static_cast<uint32_t>(start), hbPos[i].x_advance });
+    }
+    return run;
+}
+
+ShapingCache::ShapedRunPtr ShapingCache::find(const Key& key)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const auto it = index_.find(key);
+    if (it == index_.end()) {
+        ++stats_.misses;
+        return nullptr;
+    }
+
+    ++stats_.hits;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->run;
+}
+
+void ShapingCache::insert(const Key& key, const ShapedRunPtr& run)
+{
+    // the key is stored both in the entry and in the index
+    const std::size_t bytes = sizeof(Entry) + sizeof(Key) +
+                              2 * key.text.size() * sizeof(compat::qchar) +
+                              2 * key.features.size() * sizeof(hb_feature_t) +
+                              run->size() * sizeof(ShapedGlyph);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (bytes > byteBudget_) {
+        return;
+    }
+
+    const auto it = index_.find(key);
+    if (it != index_.end()) {
+        stats_.bytes -= it->second->bytes;
+        entries_.erase(it->second);
+        index_.erase(it);
+    }
+
+    entries_.push_front(Entry { key, run, bytes });
+    index_.emplace(key, entries_.begin());
+    stats_.bytes += bytes;
+
+    evict();
+}
+
+void ShapingCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    entries_.clear();
+    index_.clear();
+    stats_.bytes = 0;
+    stats_.entries = 0;
+}
+
+void ShapingCache::setByteBudget(std::size_t byteBudget)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    byteBudget_ = byteBudget;
+    evict();
+}
+
+std::size_t ShapingCache::byteBudget() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return byteBudget_;
+}
+
+ShapingCache::Statistics ShapingCache::statistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void ShapingCache::evict()
+{
+    while (stats_.bytes > byteBudget_ && !entries_.empty()) {
+        const Entry& last = entries_.back();
+        stats_.bytes -= last.bytes;
+        index_.erase(last.key);
+        entries_.pop_back();
+        ++stats_.evictions;
+    }
+    stats_.entries = entries_.size();
+}
+
+} // namespace odtr
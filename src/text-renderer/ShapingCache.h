@@ -0,0 +1,138 @@
+#pragma once
+
+#include "base.h"
+#include "../compat/basic-types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace odtr {
+
+class Face;
+
+/**
+ * Least recently used cache of HarfBuzz shaping results.
+ *
+ * A shaped run is identified by the face, font size, OpenType features,
+ * segment properties (direction, script, language) and the run text. HarfBuzz
+ * looks at a few characters around the run when shaping, so these are part
+ * of the key as well, unless the run is a word shaped on its own. Words repeat
+ * across runs and texts far more often than whole runs do, see
+ * ParagraphShape::shapeSequence. Only the glyph ids, clusters (relative to
+ * the run start) and advances are kept, which is all the paragraph shaping needs.
+ *
+ * Entries are evicted once their total size exceeds the byte budget.
+ * The cache is thread-safe, texts may be shaped by multiple threads.
+ */
+class ShapingCache
+{
+public:
+    /// Number of characters before and after the run HarfBuzz considers as context.
+    static constexpr int CONTEXT_LENGTH = 5;
+
+    struct Key
+    {
+        const Face* face;
+        font_size fontSize;
+        std::vector<hb_feature_t> features;
+        hb_direction_t direction;
+        hb_script_t script;
+        hb_language_t language;
+        /// The run text surrounded by up to CONTEXT_LENGTH characters of context on each side.
+        std::vector<compat::qchar> text;
+        int runOffset;
+        int runLength;
+
+        bool operator==(const Key& other) const;
+    };
+
+    struct ShapedGlyph
+    {
+        hb_codepoint_t codepoint;
+        /// Index of the first character of the glyph's cluster, relative to the run start.
+        uint32_t cluster;
+        hb_position_t xAdvance;
+    };
+    using ShapedRun = std::vector<ShapedGlyph>;
+    using ShapedRunPtr = std::shared_ptr<const ShapedRun>;
+
+    struct Statistics
+    {
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+        std::size_t evictions = 0;
+        std::size_t entries = 0;
+        std::size_t bytes = 0;
+    };
+
+    /// The default budget is ContextOptions::shapingCacheBudget.
+    explicit ShapingCache(std::size_t byteBudget);
+    ShapingCache(const ShapingCache&) = delete;
+    ShapingCache& operator=(const ShapingCache&) = delete;
+
+    /**
+     * Creates the key of a run.
+     *
+     * @param text          Text of the whole paragraph
+     * @param start         Start of the run within @a text
+     * @param len           Length of the run
+     * @param withContext   Whether the run is shaped with the surrounding characters as context
+     */
+    static Key makeKey(const Face* face,
+                       font_size fontSize,
+                       const std::vector<hb_feature_t>& features,
+                       const hb_segment_properties_t& properties,
+                       const std::vector<compat::qchar>& text,
+                       int start,
+                       int len,
+                       bool withContext = true);
+
+    /// Extracts the shaping result of a run starting at @a start from a shaped buffer, in the buffer order.
+    static ShapedRunPtr makeShapedRun(hb_buffer_t* hbBuffer, int start);
+
+    /// Returns the cached shaping result, or null. Counts a hit or a miss.
+    ShapedRunPtr find(const Key& key);
+    /// Stores the shaping result, evicting the least recently used entries if over budget.
+    void insert(const Key& key, const ShapedRunPtr& run);
+
+    /// Drops all entries, must be called whenever a face gets destroyed.
+    void clear();
+
+    void setByteBudget(std::size_t byteBudget);
+    std::size_t byteBudget() const;
+
+    Statistics statistics() const;
+
+private:
+    struct KeyHasher
+    {
+        std::size_t operator()(const Key& key) const;
+    };
+
+    struct Entry
+    {
+        Key key;
+        ShapedRunPtr run;
+        std::size_t bytes;
+    };
+    using EntryList = std::list<Entry>;
+
+    void evict();
+
+    mutable std::mutex mutex_;
+
+    std::size_t byteBudget_;
+
+    /// Most recently used entries at the front.
+    EntryList entries_;
+    std::unordered_map<Key, EntryList::iterator, KeyHasher> index_;
+
+    Statistics stats_;
+};
+
+} // namespace odtr
@@ -4,6 +4,7 @@
 #include <open-design-text-renderer/PlacedTextData.h>
 
 #include "text-renderer.h"
+#include "TextShapeData.h"
 #include "TextShapeInput.h"
 
 namespace odtr {
@@ -13,6 +14,8 @@ TextShape::TextShape(InputPtr &&input, DataPtr &&data) :
     data(std::move(data)) {
 }
 
+TextShape::~TextShape() = default;
+
 void TextShape::deactivate()
 {
     active = false;
@@ -27,6 +30,14 @@ void TextShape::onFontFaceChanged(const std::string &postScriptName)
 {
     if (input->usedFaces.find(postScriptName) != std::end(input->usedFaces)) {
         dirty = true;
+        shapeData.reset();
+    }
+}
+
+void TextShape::onFontFaceAdded(const std::string &postScriptName)
+{
+    if (input->usedFaces.find(postScriptName) != std::end(input->usedFaces)) {
+        shapeData.reset();
     }
 }
 
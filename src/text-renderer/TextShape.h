@@ -8,19 +8,24 @@
 namespace odtr {
 
 struct PlacedTextData;
-namespace priv { struct TextShapeInput; }
+namespace priv { struct TextShapeInput; struct TextShapeData; }
 
 struct TextShape
 {
     using InputPtr = std::unique_ptr<priv::TextShapeInput>;
-    using DataPtr = std::unique_ptr<PlacedTextData>;
+    using DataPtr = std::shared_ptr<const PlacedTextData>;
+    using ShapeDataPtr = std::unique_ptr<priv::TextShapeData>;
 
     /* implicit */ TextShape(InputPtr &&input, DataPtr &&data);
+    ~TextShape();
 
     /// Input data.
     InputPtr input;
-    /// Shaped text data.
+    /// Shaped text data, shared with the text shapes of identical texts. Never modified, replaced instead.
     DataPtr data;
+    /// Paragraph shapes of the last shaping, reused by reshaping for the paragraphs which didn't change.
+    /// Null if the shaped text data was taken over from another text shape.
+    ShapeDataPtr shapeData;
 
     bool active = true;
     /// Gets labeled as "dirty" on font face change. Shaping needs to be called again.
@@ -33,6 +38,9 @@ struct TextShape
 
     /// Handle font face change - if a used font changed, mark as dirty.
     void onFontFaceChanged(const std::string &postScriptName);
+
+    /// Handle font face addition - the retained paragraph shapes may use a fallback instead of the added face.
+    void onFontFaceAdded(const std::string &postScriptName);
 };
 
 }
@@ -1,14 +1,105 @@
 
 #include "TextShapeData.h"
 
+#include <algorithm>
+
 namespace odtr {
 namespace priv {
 
+namespace {
+
+/// Whether the formats are equal for all characters, compared with @a equal for each pair of overlapping runs.
+template <typename Equal>
+bool equalRuns(const FormatRuns& a, const FormatRuns& b, const Equal& equal)
+{
+    if (a.length() != b.length()) {
+        return false;
+    }
+
+    const FormatRuns::Runs& runsA = a.runs();
+    const FormatRuns::Runs& runsB = b.runs();
+
+    for (std::size_t i = 0, j = 0; i < runsA.size() && j < runsB.size(); ) {
+        if (runsA[i].format != runsB[j].format && !equal(*runsA[i].format, *runsB[j].format)) {
+            return false;
+        }
+
+        const int end = std::min(runsA[i].end, runsB[j].end);
+        i += runsA[i].end == end;
+        j += runsB[j].end == end;
+    }
+
+    return true;
+}
+
+}
+
+ParagraphSource::ParagraphSource(const FormattedParagraph& paragraph)
+    : text(paragraph.getText(), paragraph.getText() + paragraph.getLength()),
+      format(paragraph.getFormat())
+{ }
+
+bool ParagraphSource::operator==(const ParagraphSource& other) const
+{
+    if (text != other.text) {
+        return false;
+    }
+
+    const FormatRuns::Runs& runs = format.runs();
+    const FormatRuns::Runs& otherRuns = other.format.runs();
+    if (runs.size() != otherRuns.size()) {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < runs.size(); ++i) {
+        if (runs[i].start != otherRuns[i].start || runs[i].end != otherRuns[i].end) {
+            return false;
+        }
+        if (runs[i].format != otherRuns[i].format && !equalFormats(*runs[i].format, *otherRuns[i].format)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ParagraphSource::operator!=(const ParagraphSource& other) const
+{
+    return !(*this == other);
+}
+
+bool ParagraphSource::equalLayout(const ParagraphSource& other) const
+{
+    return text == other.text && equalRuns(format, other.format, equalLayoutFormats);
+}
+
+bool ParagraphSource::equalDecorations(const ParagraphSource& other) const
+{
+    return text == other.text && equalRuns(format, other.format, [](const ImmediateFormat& a, const ImmediateFormat& b) {
+        return a.decorations == b.decorations;
+    });
+}
+
+bool ParagraphSource::equalExceptSizes(const ParagraphSource& other) const
+{
+    return text == other.text && equalRuns(format, other.format, [](const ImmediateFormat& a, const ImmediateFormat& b) {
+        ImmediateFormat resized = a;
+        resized.size = b.size;
+        return equalFormats(resized, b);
+    });
+}
+
 TextShapeData::TextShapeData(ParagraphShapes&& shapes,
+                             ParagraphSources&& sources,
+                             float shapingWidth,
+                             bool glyphsBearings,
                              const compat::FRectangle& boundsNoTransform,
                              const compat::FRectangle& boundsTransformed,
                              float baseline)
     : paragraphShapes(std::move(shapes)),
+      paragraphSources(std::move(sources)),
+      shapingWidth(shapingWidth),
+      glyphsBearings(glyphsBearings),
       textBoundsNoTransform(boundsNoTransform),
       textBoundsTransformed(boundsTransformed),
       baseline(baseline)
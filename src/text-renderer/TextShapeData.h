@@ -1,7 +1,7 @@
-
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "FormattedText.h"
 #include "ParagraphShape.h"
@@ -12,17 +12,51 @@ namespace priv {
 using UsedFaces = std::unordered_set<std::string>;
 using FrameSizeOpt = std::optional<compat::Vector2f>;
 
+/// Characters and formats of a paragraph before its analysis, identifying the input of a paragraph shape.
+struct ParagraphSource
+{
+    explicit ParagraphSource(const FormattedParagraph& paragraph);
+
+    bool operator==(const ParagraphSource& other) const;
+    bool operator!=(const ParagraphSource& other) const;
+
+    /// Whether the paragraphs have the same characters, with formats differing at most in the color and decorations.
+    bool equalLayout(const ParagraphSource& other) const;
+    /// Whether the paragraphs have the same characters with the same decorations.
+    bool equalDecorations(const ParagraphSource& other) const;
+    /// Whether the paragraphs have the same characters, with formats differing at most in the font sizes.
+    bool equalExceptSizes(const ParagraphSource& other) const;
+
+    std::vector<compat::qchar> text;
+    FormatRuns format;
+};
+using ParagraphSources = std::vector<ParagraphSource>;
+
 struct TextShapeData
 {
     TextShapeData(ParagraphShapes&& shapes,
+                  ParagraphSources&& sources,
+                  float shapingWidth,
+                  bool glyphsBearings,
                   const compat::FRectangle& boundsNoTransform,
                   const compat::FRectangle& boundsTransformed,
                   float baseline);
 
     ParagraphShapes paragraphShapes;
+    /// Sources of the paragraph shapes, the shapes of unchanged paragraphs are reused when the text is reshaped.
+    ParagraphSources paragraphSources;
+    /// Width the paragraphs were broken into lines with.
+    float shapingWidth;
+    /// Whether the bearings of the glyphs were loaded.
+    bool glyphsBearings;
     compat::FRectangle textBoundsNoTransform;
     compat::FRectangle textBoundsTransformed;
     float baseline;
+
+    /// Glyph shapes of the placed glyphs in the order of PlacedTextData::glyphs, to restyle the placed text in place.
+    std::vector<const GlyphShape*> placedGlyphShapes;
+    /// Glyph shapes the placed decorations take the color from, in the order of PlacedTextData::decorations.
+    std::vector<const GlyphShape*> placedDecorationShapes;
 };
 using TextShapeDataPtr = std::unique_ptr<TextShapeData>;
 
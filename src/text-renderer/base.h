@@ -7,6 +7,7 @@
 #include FT_ADVANCES_H
 #include FT_GLYPH_H
 #include FT_BBOX_H
+#include FT_SIZES_H
 #include <hb-ft.h>
 #include <hb.h>
 
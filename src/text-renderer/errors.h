@@ -26,4 +26,27 @@ constexpr const char *errorToString(TextShapeError error) {
     }
 }
 
+enum class SerializationError
+{
+    INVALID_HEADER,         // 0
+    UNSUPPORTED_VERSION,    // 1
+    DECOMPRESSION_ERROR,    // 2
+    CORRUPTED_DATA          // 3
+};
+
+constexpr const char *errorToString(SerializationError error) {
+    switch (error) {
+        case SerializationError::INVALID_HEADER:
+            return "INVALID_HEADER";
+        case SerializationError::UNSUPPORTED_VERSION:
+            return "UNSUPPORTED_VERSION";
+        case SerializationError::DECOMPRESSION_ERROR:
+            return "DECOMPRESSION_ERROR";
+        case SerializationError::CORRUPTED_DATA:
+            return "CORRUPTED_DATA";
+        default:
+            return "???";
+    }
+}
+
 }
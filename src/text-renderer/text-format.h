@@ -5,12 +5,18 @@
 // #include "../base/Bitmap.hpp"
 // #include "../base/basic-types.h"
 #include "../common/sorted_vector.hpp"
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
 typedef float font_size;
 typedef float spacing;
 typedef std::string FaceId;
+/// Index of a face within the face table, see FaceTable::getFaceHandle
+typedef std::uint32_t FaceHandle;
+
+constexpr FaceHandle INVALID_FACE_HANDLE = UINT32_MAX;
 
 /// A 32-bit RGBA pixel, with LE alignment (0xAABBGGRR)
 typedef std::uint32_t Pixel32;
@@ -172,6 +178,8 @@ struct GlyphFormat
     };
 
     FaceId faceId;
+    /// Resolved from faceId when the paragraph gets formatted, see FormattedParagraph
+    FaceHandle faceHandle = INVALID_FACE_HANDLE;
     font_size size;
     Ligatures ligatures;
     TextDirection direction;
@@ -209,6 +217,8 @@ struct ImmediateFormat : GlyphFormat
     bool uppercase;
     bool lowercase;
 };
+/// Format shared by all characters / glyphs of a style run
+typedef std::shared_ptr<const ImmediateFormat> ImmediateFormatPtr;
 
 /// Specifies a change in format for the substring in the range [start, end)
 struct FormatModifier
@@ -19,14 +19,23 @@
 #include "../compat/basic-types.h"
 #include "../compat/Bitmap.hpp"
 
+#include "../fonts/FontManager.h"
+
 #include "../utils/utils.h"
+#include "../utils/ThreadPool.h"
+#include "../common/hash_utils.hpp"
 
 #include <octopus/text.h>
 
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <iterator>
+#include <limits>
+#include <memory>
 #include <optional>
+#include <unordered_map>
+#include <vector>
 
 namespace odtr {
 
@@ -34,6 +43,9 @@ namespace {
 FRectangle convertRect(const compat::FRectangle& r) {
     return FRectangle{r.l, r.t, r.w, r.h};
 }
+compat::FRectangle convertRect(const FRectangle& r) {
+    return compat::FRectangle{r.l, r.t, r.w, r.h};
+}
 Matrix3f convertMatrix(const compat::Matrix3f &m) {
     return Matrix3f {
         m.m[0][0], m.m[0][1], m.m[0][2],
@@ -54,6 +66,38 @@ namespace priv {
 
 namespace {
 
+/// Margin around the glyph bounds (at scale 1) used for view area culling.
+constexpr float VIEW_AREA_CULLING_MARGIN = 2.0f;
+
+/// Minimal number of paragraphs of a text to be shaped in parallel, shorter texts are not worth the overhead.
+constexpr std::size_t PARALLEL_PARAGRAPHS_MIN_COUNT = 8;
+
+/**
+ * Calls @a task for each of @a count paragraphs with the faces to use. Long texts are processed
+ * by the context thread pool, each worker with its own instance of the faces. Within a worker
+ * of the pool, the paragraphs are processed inline with the caller's @a faces.
+ */
+template <typename ParagraphTask>
+void forEachParagraph(Context &ctx, const FaceTable &faces, std::size_t count, const ParagraphTask &task)
+{
+    utils::ThreadPool* threadPool = count >= PARALLEL_PARAGRAPHS_MIN_COUNT ? ctx.getThreadPool() : nullptr;
+    if (threadPool == nullptr || threadPool->isCurrentThreadWorker()) {
+        for (std::size_t i = 0; i < count; ++i) {
+            task(i, faces);
+        }
+        return;
+    }
+
+    std::vector<std::unique_ptr<FacesTableLease>> workerFaces(threadPool->threadCount());
+    threadPool->parallelFor(count, [&ctx, &task, &workerFaces](std::size_t i, std::size_t workerIndex) {
+        std::unique_ptr<FacesTableLease> &lease = workerFaces[workerIndex];
+        if (!lease) {
+            lease = std::make_unique<FacesTableLease>(ctx.getFontManager().leaseFacesTable());
+        }
+        task(i, **lease);
+    });
+}
+
 /**
  * Returns stretched bounds containing bitmap bounds of all the glyphs
  * within typeset journal in @a paragraphResults.
@@ -87,13 +131,14 @@ compat::FRectangle stretchBounds(const compat::FRectangle& baseBounds, const com
 }
 
 /**
- * Split text into formatted paragraphs.
+ * Split text into formatted paragraphs, which are analyzed only when they are shaped.
  */
-std::vector<FormattedParagraph> splitText(const utils::Log& log, const FormattedText& text, FontManager& fontManager)
+std::vector<FormattedParagraph> splitText(Context &ctx, const FormattedText& text)
 {
-    // Generate format per characters
-    std::vector<ImmediateFormat> textFormat;
-    text.generateFormat(textFormat);
+    const utils::Log& log = ctx.getLogger();
+
+    // Generate style runs of the text
+    const FormatRuns textFormat = text.generateFormat();
 
     // Split text & format into paragraphs
     std::vector<FormattedParagraph> paragraphs;
@@ -102,23 +147,54 @@ std::vector<FormattedParagraph> splitText(const utils::Log& log, const Formatted
     }
 
     const compat::qchar* textPtr = text.getText();
-    const ImmediateFormat* formatPtr = textFormat.data();
 
-    for (int limit = text.getLength(); limit > 0; ) {
+    for (int start = 0, limit = text.getLength(); limit > 0; ) {
         paragraphs.emplace_back(FormattedParagraph(log));
-        const int parLen = FormattedParagraph::extractParagraph(paragraphs.back(), textPtr, formatPtr, limit);
+        const int parLen = FormattedParagraph::extractParagraph(paragraphs.back(), textPtr, textFormat, start, limit);
 
-        textPtr += parLen;
-        formatPtr += parLen;
+        start += parLen;
         limit -= parLen;
     }
 
-    for (FormattedParagraph &p : paragraphs) {
-        p.analyzeBidi();
-        p.applyFormatModifiers(fontManager);
+    return paragraphs;
+}
+
+/**
+ * Moves the shapes of unchanged paragraphs from the @a previous shaping to @a shapes.
+ * The paragraphs are matched by their sources wherever they are, so that edited, inserted,
+ * removed or moved paragraphs don't prevent the reuse of the others.
+ */
+void reuseParagraphShapes(TextShapeData &previous, const ParagraphSources &sources, ParagraphShapes &shapes)
+{
+    const auto textHash = [](const ParagraphSource &source) {
+        std::size_t seed = source.text.size();
+        for (const compat::qchar c : source.text) {
+            hash_combine(seed, c);
+        }
+        return seed;
+    };
+
+    const std::size_t previousCount = std::min(previous.paragraphSources.size(), previous.paragraphShapes.size());
+    std::unordered_map<std::size_t, std::vector<std::size_t>> previousByText;
+    for (std::size_t i = 0; i < previousCount; ++i) {
+        if (previous.paragraphShapes[i]) {
+            previousByText[textHash(previous.paragraphSources[i])].push_back(i);
+        }
     }
 
-    return paragraphs;
+    for (std::size_t index = 0; index < sources.size(); ++index) {
+        const auto it = previousByText.find(textHash(sources[index]));
+        if (it == previousByText.end()) {
+            continue;
+        }
+        // the first unused of the equal previous paragraphs, a reused shape is moved out
+        for (const std::size_t previousIndex : it->second) {
+            if (previous.paragraphShapes[previousIndex] && previous.paragraphSources[previousIndex] == sources[index]) {
+                shapes[index] = std::move(previous.paragraphShapes[previousIndex]);
+                break;
+            }
+        }
+    }
 }
 
 void preserveFixedDimensions(BoundsMode mode, const std::optional<compat::Vector2f>& frameSize, float& w, float& h)
@@ -211,46 +287,78 @@ compat::Rectangle computeDrawBounds(Context &ctx,
         : utils::outerRect(stretchedTextBounds);
 }
 
-TextShapeParagraphsResult shapeTextInner(Context &ctx,
-                                         const TextShapeInput &textShapeInput) {
-    const utils::Log &log = ctx.getLogger();
-    const FormattedText &text = *textShapeInput.formattedText;
+/// Width used for breaking the paragraphs into lines, zero for unlimited lines.
+float resolveShapingWidth(const TextShapeInput &textShapeInput)
+{
+    return textShapeInput.formattedText->boundsMode() == BoundsMode::AUTO_WIDTH
+        ? 0.0f
+        : textShapeInput.frameSize.value_or(compat::Vector2f{0,0}).x;
+}
 
-    // Split the text into paragraphs
-    const FormattedParagraphs paragraphs = splitText(log, text, ctx.getFontManager());
-    if (paragraphs.empty()) {
-        return std::make_pair(TextShapeError::NO_PARAGRAPHS, ParagraphShape::DrawResults {});
+/**
+ * Splits the text into paragraph sources, if it consists of the same characters with the same formatting
+ * parameters as the text of the retained @a shapeData, and all the paragraphs were shaped.
+ */
+bool splitUnchangedText(Context &ctx,
+                        const TextShapeInput &previousInput,
+                        const TextShapeInput &textShapeInput,
+                        const TextShapeData *shapeData,
+                        ParagraphSources &sources)
+{
+    if (shapeData == nullptr) {
+        return false;
     }
 
-    float maxWidth = text.boundsMode() == BoundsMode::AUTO_WIDTH ? 0.0f : textShapeInput.frameSize.value_or(compat::Vector2f{0,0}).x;
-
-    const bool loadGlyphsBearings = text.baselinePolicy() == BaselinePolicy::OFFSET_BEARING;
-    // Shape the paragraphs
-    ParagraphShapes shapes;
-    for (const FormattedParagraph& paragraph : paragraphs) {
-        ParagraphShapePtr paragraphShape = std::make_unique<ParagraphShape>(log, ctx.getFontManager().facesTable());
-        const ParagraphShape::ShapeResult shapeResult = paragraphShape->shape(paragraph, maxWidth, loadGlyphsBearings);
+    const FormattedText &previousText = *previousInput.formattedText;
+    const FormattedText &text = *textShapeInput.formattedText;
+    if (previousText.text() != text.text() ||
+        previousText.formattingParams() != text.formattingParams() ||
+        previousInput.frameSize != textShapeInput.frameSize ||
+        !(previousInput.textTransform == textShapeInput.textTransform)) {
+        return false;
+    }
 
-        if (shapeResult.success) {
-            shapes.emplace_back(std::move(paragraphShape));
-        }
+    const FormattedParagraphs paragraphs = splitText(ctx, text);
+    if (paragraphs.size() != shapeData->paragraphSources.size() || paragraphs.size() != shapeData->paragraphShapes.size()) {
+        return false;
     }
 
-    if (shapes.empty()) {
-        return std::make_pair(TextShapeError::NO_PARAGRAPHS, ParagraphShape::DrawResults {});
+    sources.reserve(paragraphs.size());
+    for (const FormattedParagraph &paragraph : paragraphs) {
+        sources.emplace_back(paragraph);
     }
 
+    return true;
+}
+
+/**
+ * Stacks the paragraph shapes vertically and computes the bounds of the text.
+ */
+TextShapeParagraphsResult layoutParagraphs(Context &ctx,
+                                           const FaceTable &faces,
+                                           const TextShapeInput &textShapeInput,
+                                           ParagraphShapes &&shapes,
+                                           ParagraphSources &&shapeSources,
+                                           float shapingWidth,
+                                           bool loadGlyphsBearings) {
+    const utils::Log &log = ctx.getLogger();
+    const FormattedText &text = *textShapeInput.formattedText;
+
+    float maxWidth = shapingWidth;
+
     float y = 0.0f;
     ParagraphShape::DrawResults paragraphResults = drawParagraphsInner(ctx,
+                                                                       faces,
                                                                        shapes,
                                                                        text.overflowPolicy(),
                                                                        static_cast<int>(std::floor(maxWidth)),
                                                                        1.0f,
                                                                        VerticalPositioning::TOP_BOUND,
                                                                        text.baselinePolicy(),
-                                                                       y);
+                                                                       y,
+                                                                       true);
 
-    // Rerun glyph bitmaps if previous justification was nonsense (zero width for auto-width bounds)
+    // Rerun the layout if previous justification was nonsense (zero width for auto-width bounds)
     if (text.boundsMode() == BoundsMode::AUTO_WIDTH) {
         log.debug("Running second pass for text '{}", text.getPreview());
 
@@ -261,13 +369,15 @@ TextShapeParagraphsResult shapeTextInner(Context &ctx,
         }
 
         paragraphResults = drawParagraphsInner(ctx,
+                                               faces,
                                                shapes,
                                                text.overflowPolicy(),
                                                static_cast<int>(std::floor(maxWidth)),
                                                1.0f,
                                                VerticalPositioning::TOP_BOUND,
                                                text.baselinePolicy(),
-                                               y);
+                                               y,
+                                               true);
     }
 
     if (paragraphResults.empty()) {
@@ -301,12 +411,269 @@ TextShapeParagraphsResult shapeTextInner(Context &ctx,
     const float baseline = resolveBaselinePosition(p0, text.baselinePolicy(), text.verticalAlign());
 
     TextShapeDataPtr tsd = std::make_unique<TextShapeData>(std::move(shapes),
+                                                           std::move(shapeSources),
+                                                           shapingWidth,
+                                                           loadGlyphsBearings,
                                                            textBoundsNoTransform,
                                                            textBoundsTransform,
                                                            baseline);
     return std::make_pair(std::move(tsd), std::move(paragraphResults));
 }
 
+TextShapeParagraphsResult shapeTextInner(Context &ctx,
+                                         const FaceTable &faces,
+                                         const TextShapeInput &textShapeInput,
+                                         TextShapeData *previous) {
+    const utils::Log &log = ctx.getLogger();
+    const FormattedText &text = *textShapeInput.formattedText;
+
+    // Split the text into paragraphs
+    FormattedParagraphs paragraphs = splitText(ctx, text);
+    if (paragraphs.empty()) {
+        return std::make_pair(TextShapeError::NO_PARAGRAPHS, ParagraphShape::DrawResults {});
+    }
+
+    const float shapingWidth = resolveShapingWidth(textShapeInput);
+
+    const bool loadGlyphsBearings = text.baselinePolicy() == BaselinePolicy::OFFSET_BEARING;
+
+    ParagraphSources sources;
+    sources.reserve(paragraphs.size());
+    for (const FormattedParagraph &paragraph : paragraphs) {
+        sources.emplace_back(paragraph);
+    }
+
+    ParagraphShapes paragraphShapes(paragraphs.size());
+    if (previous != nullptr && previous->shapingWidth == shapingWidth && previous->glyphsBearings == loadGlyphsBearings) {
+        reuseParagraphShapes(*previous, sources, paragraphShapes);
+    }
+
+    std::vector<std::size_t> changedParagraphs;
+    for (std::size_t i = 0; i < paragraphShapes.size(); ++i) {
+        if (!paragraphShapes[i]) {
+            changedParagraphs.push_back(i);
+        }
+    }
+
+    // Analyze and shape the changed paragraphs, they are independent until stacked vertically
+    forEachParagraph(ctx, faces, changedParagraphs.size(), [&](std::size_t k, const FaceTable &paragraphFaces) {
+        const std::size_t i = changedParagraphs[k];
+        const unicode::AnalyzerPool::Lease analyzer = ctx.unicodeAnalyzers.lease();
+        paragraphs[i].analyzeBidi(*analyzer);
+        paragraphs[i].applyFormatModifiers(paragraphFaces, ctx.getFontManager());
+
+        ParagraphShapePtr paragraphShape = std::make_unique<ParagraphShape>(log);
+        const ParagraphShape::ShapeResult shapeResult = paragraphShape->shape(paragraphs[i], shapingWidth, loadGlyphsBearings, ctx.shapingCache, *analyzer, paragraphFaces);
+
+        if (shapeResult.success) {
+            paragraphShapes[i] = std::move(paragraphShape);
+        }
+    });
+
+    ParagraphShapes shapes;
+    ParagraphSources shapeSources;
+    for (std::size_t i = 0; i < paragraphShapes.size(); ++i) {
+        if (paragraphShapes[i]) {
+            shapes.emplace_back(std::move(paragraphShapes[i]));
+            shapeSources.emplace_back(std::move(sources[i]));
+        }
+    }
+
+    if (shapes.empty()) {
+        return std::make_pair(TextShapeError::NO_PARAGRAPHS, ParagraphShape::DrawResults {});
+    }
+
+    return layoutParagraphs(ctx, faces, textShapeInput, std::move(shapes), std::move(shapeSources), shapingWidth, loadGlyphsBearings);
+}
+
+/**
+ * Places the glyphs and decorations of the laid out paragraphs, their shapes are moved to @a shapeData.
+ */
+PlacedTextResult placeText(Context &ctx, const TextShapeInput &textShapeInput, TextShapeParagraphsResult &res, TextShapeDataPtr &shapeData)
+{
+    const TextShapeDataPtr &textShapeData = res.first.value();
+    const ParagraphShape::DrawResults &paragraphResults = res.second;
+    const FormattedText::FormattingParams &textParams = textShapeInput.formattedText->formattingParams();
+    const compat::FRectangle &textBounds = textShapeData->textBoundsNoTransform;
+
+    // account for descenders of last paragraph's last line
+    const float caretVerticalPos = roundCaretPosition(textShapeData->baseline, ctx.config.floorBaseline);
+    const spacing textBottom = caretVerticalPos - paragraphResults.back().lastlineDescender;
+
+    const spacing baselineOffset = resolveBaselineOffset(paragraphResults.front(), textParams.baselinePolicy, textParams.verticalAlign);
+    const float verticalOffset = resolveVerticalOffset(textParams.boundsMode, textParams.verticalAlign, textBounds, textBottom, baselineOffset);
+
+    const bool unlimitedVerticalStretch =
+        textParams.overflowPolicy == OverflowPolicy::EXTEND_ALL ||
+        textParams.boundsMode == BoundsMode::AUTO_HEIGHT ||
+        textParams.verticalAlign != VerticalAlign::TOP;
+
+    const float verticalStretchLimit = unlimitedVerticalStretch ? 0.0f : textBounds.h;
+    compat::Rectangle stretchedGlyphsBounds {};
+    if (textParams.boundsMode != BoundsMode::FIXED || textParams.overflowPolicy != OverflowPolicy::NO_OVERFLOW) {
+        stretchedGlyphsBounds = stretchedBounds(paragraphResults, int(verticalOffset), verticalStretchLimit);
+    }
+
+    // Vertical align offset
+    const float verticalAlignOffset = verticalOffset - stretchedGlyphsBounds.t;
+
+    const compat::Matrix3f translationMatrix = compat::translationMatrix(compat::Vector2f { textBounds.l, textBounds.t });
+    const compat::FRectangle textBoundsCentered { 0.0f, 0.0f, textBounds.w, textBounds.h };
+    const compat::FRectangle textBoundsNotScaled = stretchBounds(textBoundsCentered, stretchedGlyphsBounds);
+    const Matrix3f transformMatrix = convertMatrix(translationMatrix*textShapeInput.textTransform);
+
+    PlacedGlyphsPerFont placedGlyphs;
+    // Placed glyphs of each font indexed by the face handle, to look up the fonts by name only once
+    std::vector<PlacedGlyphs *> placedGlyphsPerHandle;
+    // Glyph shapes of the placed glyphs of each font, the placed text can be restyled by them
+    std::vector<std::vector<const GlyphShape *>> glyphShapesPerHandle;
+    std::vector<const GlyphShape *> placedDecorationShapes;
+    PlacedDecorations placedDecorations;
+    std::vector<FRectangle> lineBounds;
+
+    size_t glyphIndex = 0;
+
+    const std::vector<compat::qchar> &inText = textShapeInput.formattedText->text();
+
+    for (size_t i = 0; i < paragraphResults.size(); ++i) {
+        const ParagraphShapePtr &paragraphShape = textShapeData->paragraphShapes[i];
+        const GlyphShapes &glyphShapes = paragraphShape->glyphs();
+        const LineSpans &paragraphLineSpans = paragraphShape->lineSpans();
+
+        const ParagraphShape::DrawResult &drawResult = paragraphResults[i];
+        const std::vector<TypesetJournal::LineRecord> &linesDrawn = drawResult.journal.getLines();
+
+        if (paragraphLineSpans.size() != linesDrawn.size()) {
+            continue;
+        }
+
+        for (size_t k = 0; k < linesDrawn.size(); ++k) {
+            const LineSpan &lineSpan = paragraphLineSpans[k];
+            const TypesetJournal::LineRecord &lineRecord = linesDrawn[k];
+
+            const size_t lineIndex = lineBounds.size();
+            lineBounds.emplace_back();
+
+            const size_t lineGlyphCount = static_cast<size_t>(lineSpan.size());
+            if (lineGlyphCount != lineRecord.glyphJournal_.size()) {
+                continue;
+            }
+
+            compat::FRectangle lineGlyphsBounds {};
+
+            // Properly ordered glyph shapes on the line. Accounting for LTR-RTL combinations and multiple visual runs
+            std::vector<const GlyphShape *> glyphShapesOnLine(lineGlyphCount);
+            long gsi = 0;
+            for (const VisualRun &vr : lineSpan.visualRuns) {
+                for (long vri = vr.start; vri < vr.end; ++vri) {
+                    glyphShapesOnLine[gsi++] = &glyphShapes[vri];
+                }
+            }
+
+            // Add placed glyphs
+            for (size_t li = 0; li < lineRecord.glyphJournal_.size(); ++li) {
+                const GlyphShape *glyphShape = glyphShapesOnLine[li];
+                const GlyphPtr &glyph = lineRecord.glyphJournal_[li];
+
+                // Should not happen
+                if (glyphShape == nullptr) {
+                    ++glyphIndex;
+                    continue;
+                }
+
+                // Skips glyphs with empty bounds - empty spaces, and glyphs without a face
+                if (!glyph->getBitmapBounds() || glyphShape->format->faceHandle == INVALID_FACE_HANDLE) {
+                    ++glyphIndex;
+                    continue;
+                }
+
+                // Find the glyph index
+                for (size_t gi = glyphIndex; gi < inText.size(); ++gi) {
+                    if (inText[gi] != glyphShape->character) {
+                        ++glyphIndex;
+                    } else {
+                        break;
+                    }
+                }
+
+                const FaceHandle faceHandle = glyphShape->format->faceHandle;
+                if (faceHandle >= placedGlyphsPerHandle.size()) {
+                    placedGlyphsPerHandle.resize(faceHandle + 1, nullptr);
+                    glyphShapesPerHandle.resize(faceHandle + 1);
+                }
+                if (placedGlyphsPerHandle[faceHandle] == nullptr) {
+                    placedGlyphsPerHandle[faceHandle] = &placedGlyphs[FontSpecifier { glyphShape->format->faceId, faceHandle }];
+                }
+                PlacedGlyphs &placedGlyphsForFont = *placedGlyphsPerHandle[faceHandle];
+                placedGlyphsForFont.emplace_back();
+                glyphShapesPerHandle[faceHandle].push_back(glyphShape);
+                PlacedGlyph &placedGlyph = placedGlyphsForFont.back();
+
+                placedGlyph.codepoint = glyphShape->codepoint;
+                placedGlyph.color = glyphShape->format->color;
+                placedGlyph.fontSize = glyphShape->format->size;
+                placedGlyph.index = glyphIndex;
+                placedGlyph.originPosition = Vector2f {
+                    glyph->getOrigin().x,
+                    glyph->getOrigin().y + verticalAlignOffset,
+                };
+                placedGlyph.lineIndex = lineIndex;
+
+                const compat::FRectangle glyphBounds {
+                    placedGlyph.originPosition.x + glyph->bitmapBearing.x,
+                    placedGlyph.originPosition.y - glyph->bitmapBearing.y,
+                    static_cast<float>(glyph->bitmapWidth()),
+                    static_cast<float>(glyph->bitmapHeight()),
+                };
+                placedGlyph.bounds = convertRect(glyphBounds);
+                lineGlyphsBounds = lineGlyphsBounds ? (lineGlyphsBounds | glyphBounds) : glyphBounds;
+
+                ++glyphIndex;
+            }
+
+            lineBounds.back() = convertRect(lineGlyphsBounds);
+
+            // Add placed decorations
+            for (const TypesetJournal::DecorationRecord &decoration : lineRecord.decorationJournal_) {
+                placedDecorations.emplace_back();
+                PlacedDecoration &placedDecoration = placedDecorations.back();
+
+                placedDecoration.type = static_cast<PlacedDecoration::Type>(decoration.type);
+                placedDecoration.color = decoration.color;
+
+                placedDecoration.start = Vector2f {
+                    decoration.range.first,
+                    decoration.offset + verticalAlignOffset,
+                };
+                placedDecoration.end = Vector2f {
+                    decoration.range.last,
+                    decoration.offset + verticalAlignOffset,
+                };
+                placedDecoration.thickness = decoration.thickness;
+
+                // the decoration has the color of its first glyph
+                const std::size_t firstGlyph = static_cast<std::size_t>(decoration.indices.low);
+                placedDecorationShapes.push_back(firstGlyph < glyphShapes.size() ? &glyphShapes[firstGlyph] : nullptr);
+            }
+        }
+    }
+
+    textShapeData->placedGlyphShapes.clear();
+    for (const auto &fontGlyphs : placedGlyphs) {
+        const std::vector<const GlyphShape *> &glyphShapesOfFont = glyphShapesPerHandle[fontGlyphs.first.faceHandle];
+        textShapeData->placedGlyphShapes.insert(textShapeData->placedGlyphShapes.end(), glyphShapesOfFont.begin(), glyphShapesOfFont.end());
+    }
+    textShapeData->placedDecorationShapes = std::move(placedDecorationShapes);
+
+    PlacedTextDataPtr placedTextData = std::make_unique<PlacedTextData>(std::move(placedGlyphs),
+                                                                        std::move(placedDecorations),
+                                                                        std::move(lineBounds),
+                                                                        convertRect(textBoundsNotScaled),
+                                                                        transformMatrix);
+    shapeData = res.first.moveValue();
+    return placedTextData;
+}
+
 } // namespace
 
 
@@ -353,7 +720,7 @@ TextShapeInputPtr preprocessText(Context &ctx,
 
 TextShapeResult shapeText(Context &ctx,
                           const TextShapeInput &textShapeInput) {
-    TextShapeParagraphsResult res = shapeTextInner(ctx, textShapeInput);
+    TextShapeParagraphsResult res = shapeTextInner(ctx, ctx.getFontManager().facesTable(), textShapeInput, nullptr);
     return std::move(res.first);
 }
 
@@ -373,6 +740,7 @@ TextDrawResult drawText(Context &ctx,
     const compat::FRectangle viewAreaTextSpace = utils::scaleRect(viewAreaTextSpaceUnscaled, scale);
 
     TextDrawResult drawResult = drawTextInner(ctx,
+                                              ctx.getFontManager().facesTable(),
                                               shapeData.paragraphShapes,
                                               shapeInput.formattedText->formattingParams(),
                                               shapeData.textBoundsNoTransform,
@@ -392,6 +760,7 @@ TextDrawResult drawText(Context &ctx,
 }
 
 TextDrawResult drawTextInner(Context &ctx,
+                             const FaceTable &faces,
                              const ParagraphShapes& paragraphShapes,
                              const FormattedText::FormattingParams &textParams,
                              const compat::FRectangle& unscaledTextBounds,
@@ -407,13 +776,15 @@ TextDrawResult drawTextInner(Context &ctx,
     float caretVerticalPos = roundCaretPosition(baseline * scale, ctx.config.floorBaseline);
 
     const ParagraphShape::DrawResults paragraphResults = drawParagraphsInner(ctx,
+                                                                             faces,
                                                                              paragraphShapes,
                                                                              textParams.overflowPolicy,
                                                                              textBounds.w,
                                                                              scale,
                                                                              VerticalPositioning::BASELINE,
                                                                              textParams.baselinePolicy,
-                                                                             caretVerticalPos);
+                                                                             caretVerticalPos,
+                                                                             dry);
     if (paragraphResults.empty()) {
         return TextDrawError::PARAGRAPHS_TYPESETING_ERROR;
     }
@@ -473,18 +844,21 @@ TextDrawResult drawTextInner(Context &ctx,
 }
 
 ParagraphShape::DrawResults drawParagraphsInner(Context &ctx,
+                                                const FaceTable &faces,
                                                 const ParagraphShapes &shapes,
                                                 OverflowPolicy overflowPolicy,
                                                 int textWidth,
                                                 RenderScale scale,
                                                 VerticalPositioning positioning,
                                                 BaselinePolicy baselinePolicy,
-                                                float &caretVerticalPos) {
+                                                float &caretVerticalPos,
+                                                bool metricsOnly) {
     ParagraphShape::DrawResults drawResults;
 
     for (const ParagraphShapePtr& paragraphShape : shapes) {
         const bool isLast = (paragraphShape == shapes.back());
         ParagraphShape::DrawResult drawResult = paragraphShape->draw(ctx,
+                                                                     faces,
                                                                      0,
                                                                      textWidth,
                                                                      caretVerticalPos,
@@ -492,7 +866,8 @@ ParagraphShape::DrawResults drawParagraphsInner(Context &ctx,
                                                                      baselinePolicy,
                                                                      scale,
                                                                      isLast,
-                                                                     false);
+                                                                     false,
+                                                                     metricsOnly);
 
         const LastLinePolicy lastLinePolicy =
             (overflowPolicy == OverflowPolicy::CLIP_LINE && drawResult.journal.size() > 1)
@@ -508,149 +883,188 @@ ParagraphShape::DrawResults drawParagraphsInner(Context &ctx,
 
 PlacedTextResult shapePlacedText(Context &ctx, const TextShapeInput &textShapeInput)
 {
-    const TextShapeParagraphsResult res = shapeTextInner(ctx, textShapeInput);
+    return shapePlacedText(ctx, ctx.getFontManager().facesTable(), textShapeInput);
+}
+
+PlacedTextResult shapePlacedText(Context &ctx, const FaceTable &faces, const TextShapeInput &textShapeInput)
+{
+    TextShapeDataPtr shapeData;
+    return shapePlacedText(ctx, faces, textShapeInput, shapeData);
+}
+
+PlacedTextResult shapePlacedText(Context &ctx, const FaceTable &faces, const TextShapeInput &textShapeInput, TextShapeDataPtr &shapeData)
+{
+    TextShapeParagraphsResult res = shapeTextInner(ctx, faces, textShapeInput, shapeData.get());
     if (!res.first) {
         ctx.getLogger().error("Text shaping failed with error: {}", errorToString(res.first.error()));
         return TextShapeError::SHAPE_ERROR;
     }
 
-    const TextShapeDataPtr &textShapeData = res.first.value();
-    const ParagraphShape::DrawResults &paragraphResults = res.second;
-    const FormattedText::FormattingParams &textParams = textShapeInput.formattedText->formattingParams();
-    const compat::FRectangle &textBounds = textShapeData->textBoundsNoTransform;
-
-    // account for descenders of last paragraph's last line
-    const float caretVerticalPos = roundCaretPosition(textShapeData->baseline, ctx.config.floorBaseline);
-    const spacing textBottom = caretVerticalPos - paragraphResults.back().lastlineDescender;
-
-    const spacing baselineOffset = resolveBaselineOffset(paragraphResults.front(), textParams.baselinePolicy, textParams.verticalAlign);
-    const float verticalOffset = resolveVerticalOffset(textParams.boundsMode, textParams.verticalAlign, textBounds, textBottom, baselineOffset);
-
-    const bool unlimitedVerticalStretch =
-        textParams.overflowPolicy == OverflowPolicy::EXTEND_ALL ||
-        textParams.boundsMode == BoundsMode::AUTO_HEIGHT ||
-        textParams.verticalAlign != VerticalAlign::TOP;
+    return placeText(ctx, textShapeInput, res, shapeData);
+}
 
-    const float verticalStretchLimit = unlimitedVerticalStretch ? 0.0f : textBounds.h;
-    compat::Rectangle stretchedGlyphsBounds {};
-    if (textParams.boundsMode != BoundsMode::FIXED || textParams.overflowPolicy != OverflowPolicy::NO_OVERFLOW) {
-        stretchedGlyphsBounds = stretchedBounds(paragraphResults, int(verticalOffset), verticalStretchLimit);
+PlacedTextResult reflowPlacedText(Context &ctx, const FaceTable &faces, const TextShapeInput &textShapeInput, TextShapeDataPtr &shapeData)
+{
+    if (shapeData == nullptr) {
+        return shapePlacedText(ctx, faces, textShapeInput, shapeData);
     }
 
-    // Vertical align offset
-    const float verticalAlignOffset = verticalOffset - stretchedGlyphsBounds.t;
-
-    const compat::Matrix3f translationMatrix = compat::translationMatrix(compat::Vector2f { textBounds.l, textBounds.t });
-    const compat::FRectangle textBoundsCentered { 0.0f, 0.0f, textBounds.w, textBounds.h };
-    const compat::FRectangle textBoundsNotScaled = stretchBounds(textBoundsCentered, stretchedGlyphsBounds);
-    const Matrix3f transformMatrix = convertMatrix(translationMatrix*textShapeInput.textTransform);
-
-    PlacedGlyphsPerFont placedGlyphs;
-    PlacedDecorations placedDecorations;
-
-    size_t glyphIndex = 0;
+    const float shapingWidth = resolveShapingWidth(textShapeInput);
+    for (const ParagraphShapePtr &paragraphShape : shapeData->paragraphShapes) {
+        if (shapingWidth != shapeData->shapingWidth && !paragraphShape->breakLines(shapingWidth)) {
+            ctx.getLogger().error("Text reflow failed with error: {}", errorToString(TextShapeError::TYPESET_ERROR));
+            shapeData.reset();
+            return TextShapeError::TYPESET_ERROR;
+        }
+    }
 
-    const std::vector<compat::qchar> &inText = textShapeInput.formattedText->text();
+    TextShapeParagraphsResult res = layoutParagraphs(ctx,
+                                                     faces,
+                                                     textShapeInput,
+                                                     std::move(shapeData->paragraphShapes),
+                                                     std::move(shapeData->paragraphSources),
+                                                     shapingWidth,
+                                                     shapeData->glyphsBearings);
+    shapeData.reset();
+    if (!res.first) {
+        ctx.getLogger().error("Text reflow failed with error: {}", errorToString(res.first.error()));
+        return TextShapeError::SHAPE_ERROR;
+    }
 
-    for (size_t i = 0; i < paragraphResults.size(); ++i) {
-        const ParagraphShapePtr &paragraphShape = textShapeData->paragraphShapes[i];
-        const GlyphShapes &glyphShapes = paragraphShape->glyphs();
-        const LineSpans &paragraphLineSpans = paragraphShape->lineSpans();
+    return placeText(ctx, textShapeInput, res, shapeData);
+}
 
-        const ParagraphShape::DrawResult &drawResult = paragraphResults[i];
-        const std::vector<TypesetJournal::LineRecord> &linesDrawn = drawResult.journal.getLines();
+bool restylePlacedText(Context &ctx,
+                       const FaceTable &faces,
+                       const TextShapeInput &previousInput,
+                       const TextShapeInput &textShapeInput,
+                       TextShapeDataPtr &shapeData,
+                       std::shared_ptr<const PlacedTextData> &placedTextData)
+{
+    ParagraphSources sources;
+    if (placedTextData == nullptr || !splitUnchangedText(ctx, previousInput, textShapeInput, shapeData.get(), sources)) {
+        return false;
+    }
 
-        if (paragraphLineSpans.size() != linesDrawn.size()) {
-            continue;
+    // only the color or decorations may have changed
+    bool equalDecorations = true;
+    for (std::size_t i = 0; i < sources.size(); ++i) {
+        if (!sources[i].equalLayout(shapeData->paragraphSources[i])) {
+            return false;
         }
+        equalDecorations = equalDecorations && sources[i].equalDecorations(shapeData->paragraphSources[i]);
+    }
 
-        for (size_t k = 0; k < linesDrawn.size(); ++k) {
-            const LineSpan &lineSpan = paragraphLineSpans[k];
-            const TypesetJournal::LineRecord &lineRecord = linesDrawn[k];
+    for (std::size_t i = 0; i < sources.size(); ++i) {
+        if (sources[i] != shapeData->paragraphSources[i]) {
+            shapeData->paragraphShapes[i]->restyle(sources[i].format);
+            shapeData->paragraphSources[i] = std::move(sources[i]);
+        }
+    }
 
-            if (lineSpan.size() != lineRecord.glyphJournal_.size()) {
-                continue;
-            }
+    std::size_t placedGlyphsCount = 0;
+    for (const auto &fontGlyphs : placedTextData->glyphs) {
+        placedGlyphsCount += fontGlyphs.second.size();
+    }
 
-            // Properly ordered glyph shapes on the line. Accounting for LTR-RTL combinations and multiple visual runs
-            std::vector<const GlyphShape *> glyphShapesOnLine(lineSpan.size());
-            long gsi = 0;
-            for (const VisualRun &vr : lineSpan.visualRuns) {
-                for (long vri = vr.start; vri < vr.end; ++vri) {
-                    glyphShapesOnLine[gsi++] = &glyphShapes[vri];
-                }
-            }
+    const bool placedInPlace =
+        equalDecorations &&
+        shapeData->placedGlyphShapes.size() == placedGlyphsCount &&
+        shapeData->placedDecorationShapes.size() == placedTextData->decorations.size() &&
+        std::none_of(shapeData->placedDecorationShapes.begin(), shapeData->placedDecorationShapes.end(), [](const GlyphShape *glyphShape) { return glyphShape == nullptr; });
+
+    if (!placedInPlace) {
+        // decorations are laid out with the glyphs
+        PlacedTextResult placedTextResult = reflowPlacedText(ctx, faces, textShapeInput, shapeData);
+        if (!placedTextResult) {
+            return false;
+        }
+        placedTextData = placedTextResult.moveValue();
+        return true;
+    }
 
-            // Add placed glyphs
-            for (size_t li = 0; li < lineRecord.glyphJournal_.size(); ++li) {
-                const GlyphShape *glyphShape = glyphShapesOnLine[li];
-                const GlyphPtr &glyph = lineRecord.glyphJournal_[li];
+    // only the colors changed, the placed glyphs and decorations are updated in a copy, the placed text may be shared
+    PlacedTextDataPtr restyledTextData = std::make_unique<PlacedTextData>(*placedTextData);
+    std::vector<const GlyphShape *>::const_iterator glyphShapeIt = shapeData->placedGlyphShapes.begin();
+    for (auto &fontGlyphs : restyledTextData->glyphs) {
+        for (PlacedGlyph &placedGlyph : fontGlyphs.second) {
+            placedGlyph.color = (*glyphShapeIt++)->format->color;
+        }
+    }
 
-                // Should not happen
-                if (glyphShape == nullptr) {
-                    ++glyphIndex;
-                    continue;
-                }
+    for (std::size_t i = 0; i < restyledTextData->decorations.size(); ++i) {
+        restyledTextData->decorations[i].color = shapeData->placedDecorationShapes[i]->format->color;
+    }
 
-                // Skips glyphs with empty bounds - empty spaces
-                if (!glyph->getBitmapBounds()) {
-                    ++glyphIndex;
-                    continue;
-                }
+    placedTextData = std::move(restyledTextData);
+    return true;
+}
 
-                // Find the glyph index
-                for (size_t gi = glyphIndex; gi < inText.size(); ++gi) {
-                    if (inText[gi] != glyphShape->character) {
-                        ++glyphIndex;
-                    } else {
-                        break;
-                    }
-                }
+bool resizePlacedText(Context &ctx,
+                      const FaceTable &faces,
+                      const TextShapeInput &previousInput,
+                      const TextShapeInput &textShapeInput,
+                      TextShapeDataPtr &shapeData,
+                      std::shared_ptr<const PlacedTextData> &placedTextData)
+{
+    // hinted glyphs don't scale linearly
+    if (!ctx.config.internalDisableHinting) {
+        return false;
+    }
 
-                PlacedGlyphs &placedGlyphsForFont = placedGlyphs[FontSpecifier { glyphShape->format.faceId }];
-                placedGlyphsForFont.emplace_back();
-                PlacedGlyph &placedGlyph = placedGlyphsForFont.back();
+    ParagraphSources sources;
+    if (!splitUnchangedText(ctx, previousInput, textShapeInput, shapeData.get(), sources)) {
+        return false;
+    }
 
-                placedGlyph.codepoint = glyphShape->codepoint;
-                placedGlyph.color = glyphShape->format.color;
-                placedGlyph.fontSize = glyphShape->format.size;
-                placedGlyph.index = glyphIndex;
-                placedGlyph.originPosition = Vector2f {
-                    glyph->getOrigin().x,
-                    glyph->getOrigin().y + verticalAlignOffset,
-                };
+    // only the font sizes may have changed, of fonts with linearly scalable glyphs
+    for (std::size_t i = 0; i < sources.size(); ++i) {
+        if (!sources[i].equalExceptSizes(shapeData->paragraphSources[i])) {
+            return false;
+        }
+    }
+    for (std::size_t i = 0; i < sources.size(); ++i) {
+        if (sources[i] != shapeData->paragraphSources[i] && !shapeData->paragraphShapes[i]->isLinearlyScalable(faces)) {
+            return false;
+        }
+    }
 
-                ++glyphIndex;
+    for (std::size_t i = 0; i < sources.size(); ++i) {
+        if (sources[i] != shapeData->paragraphSources[i]) {
+            const ParagraphShapePtr &paragraphShape = shapeData->paragraphShapes[i];
+            if (!paragraphShape->resize(sources[i].format, faces)) {
+                // the partially resized glyphs don't match the sources anymore
+                shapeData.reset();
+                return false;
             }
+            shapeData->paragraphSources[i] = std::move(sources[i]);
 
-            // Add placed decorations
-            for (const TypesetJournal::DecorationRecord &decoration : lineRecord.decorationJournal_) {
-                placedDecorations.emplace_back();
-                PlacedDecoration &placedDecoration = placedDecorations.back();
-
-                placedDecoration.type = static_cast<PlacedDecoration::Type>(decoration.type);
-                placedDecoration.color = decoration.color;
-
-                placedDecoration.start = Vector2f {
-                    decoration.range.first,
-                    decoration.offset + verticalAlignOffset,
-                };
-                placedDecoration.end = Vector2f {
-                    decoration.range.last,
-                    decoration.offset + verticalAlignOffset,
-                };
-                placedDecoration.thickness = decoration.thickness;
+            if (!paragraphShape->breakLines(shapeData->shapingWidth)) {
+                shapeData.reset();
+                return false;
             }
         }
     }
 
-    return std::make_unique<PlacedTextData>(std::move(placedGlyphs),
-                                            std::move(placedDecorations),
-                                            convertRect(textBoundsNotScaled),
-                                            transformMatrix);
+    // the resized glyphs are laid out and placed again
+    PlacedTextResult placedTextResult = reflowPlacedText(ctx, faces, textShapeInput, shapeData);
+    if (!placedTextResult) {
+        return false;
+    }
+    placedTextData = placedTextResult.moveValue();
+    return true;
+}
+
+TextDrawResult drawPlacedText(Context &ctx,
+                              const PlacedTextData &placedTextData,
+                              float scale,
+                              const compat::Rectangle &viewArea,
+                              void *pixels, int width, int height) {
+    return drawPlacedText(ctx, ctx.getFontManager().facesTable(), placedTextData, scale, viewArea, pixels, width, height);
 }
 
 TextDrawResult drawPlacedText(Context &ctx,
+                              const FaceTable &faces,
                               const PlacedTextData &placedTextData,
                               float scale,
                               const compat::Rectangle &viewArea,
@@ -658,6 +1072,7 @@ TextDrawResult drawPlacedText(Context &ctx,
     const compat::FRectangle viewAreaTextSpace = utils::scaleRect(utils::toFRectangle(viewArea), scale);
 
     TextDrawResult drawResult = drawPlacedTextInner(ctx,
+                                                    faces,
                                                     placedTextData,
                                                     scale,
                                                     viewAreaTextSpace,
@@ -680,6 +1095,7 @@ TextDrawResult drawPlacedText(Context &ctx,
 }
 
 TextDrawResult drawPlacedTextInner(Context &ctx,
+                                   const FaceTable &faces,
                                    const PlacedTextData &placedTextData,
                                    RenderScale scale,
                                    const compat::FRectangle& viewArea,
@@ -688,14 +1104,63 @@ TextDrawResult drawPlacedTextInner(Context &ctx,
 
     const compat::Rectangle viewAreaBounds = (ctx.config.enableViewAreaCutout) ? utils::outerRect(viewArea) : compat::INFINITE_BOUNDS;
 
+    // Lines and glyphs outside of the view area are skipped before rasterization, using their bounds at scale 1.
+    // The margin covers the differences of the rasterized bitmaps caused by hinting and rounding.
+    const bool cullByBounds = ctx.config.enableViewAreaCutout && !placedTextData.lineBounds.empty();
+    const float cullingMargin = VIEW_AREA_CULLING_MARGIN * std::max(scale, 1.0f);
+    const auto isInViewArea = [&](const FRectangle &unscaledBounds) {
+        const compat::FRectangle bounds = utils::scaleRect(convertRect(unscaledBounds), scale);
+        const compat::FRectangle extendedBounds {
+            bounds.l - cullingMargin,
+            bounds.t - cullingMargin,
+            bounds.w + 2.0f * cullingMargin,
+            bounds.h + 2.0f * cullingMargin,
+        };
+        return static_cast<bool>(utils::outerRect(extendedBounds) & viewAreaBounds);
+    };
+
+    // Lines are ordered top to bottom, the visible ones are within [firstVisibleLine, lastVisibleLine].
+    std::vector<bool> visibleLines;
+    size_t firstVisibleLine = 0;
+    size_t lastVisibleLine = std::numeric_limits<size_t>::max();
+    if (cullByBounds) {
+        visibleLines.resize(placedTextData.lineBounds.size());
+        firstVisibleLine = visibleLines.size();
+        lastVisibleLine = 0;
+        for (size_t i = 0; i < visibleLines.size(); ++i) {
+            if (placedTextData.lineBounds[i].w > 0.0f && isInViewArea(placedTextData.lineBounds[i])) {
+                visibleLines[i] = true;
+                firstVisibleLine = std::min(firstVisibleLine, i);
+                lastVisibleLine = i;
+            }
+        }
+    }
+
     for (const auto &pgIt : placedTextData.glyphs) {
         const FontSpecifier &fontSpecifier = pgIt.first;
         const PlacedGlyphs &placedGlyphs = pgIt.second;
 
-        const FaceTable::Item* faceItem = ctx.getFontManager().facesTable().getFaceItem(fontSpecifier.faceId);
+        // placed glyphs not created by the shaping are only identified by the name
+        const FaceTable::Item* faceItem = fontSpecifier.faceHandle != INVALID_FACE_HANDLE
+            ? faces.getFaceItem(fontSpecifier.faceHandle)
+            : faces.getFaceItem(fontSpecifier.faceId);
         if (faceItem != nullptr && faceItem->face != nullptr) {
-            for (const PlacedGlyph &pg : placedGlyphs) {
-                const GlyphPtr renderedGlyph = renderPlacedGlyph(pg,
+            // Glyphs of each font are stored in line order
+            PlacedGlyphs::const_iterator pgBegin = placedGlyphs.begin();
+            if (cullByBounds) {
+                pgBegin = std::lower_bound(placedGlyphs.begin(), placedGlyphs.end(), firstVisibleLine,
+                    [](const PlacedGlyph &pg, size_t line) { return pg.lineIndex < line; });
+            }
+
+            for (PlacedGlyphs::const_iterator it = pgBegin; it != placedGlyphs.end() && it->lineIndex <= lastVisibleLine; ++it) {
+                const PlacedGlyph &pg = *it;
+
+                if (cullByBounds && (pg.lineIndex >= visibleLines.size() || !visibleLines[pg.lineIndex] || !isInViewArea(pg.bounds))) {
+                    continue;
+                }
+
+                const GlyphPtr renderedGlyph = renderPlacedGlyph(ctx.glyphCache,
+                                                                 pg,
                                                                  faceItem->face,
                                                                  scale,
                                                                  ctx.config.internalDisableHinting);
@@ -16,6 +16,7 @@ namespace octopus {
 }
 namespace odtr {
     struct Context;
+    class FaceTable;
 }
 
 namespace odtr {
@@ -67,6 +68,7 @@ TextDrawResult drawText(Context &ctx,
                         bool dry); // Only compute the boundaries, the actual drawing does not take place.
 
 TextDrawResult drawTextInner(Context &ctx,
+                             const FaceTable &faces,
                              const ParagraphShapes& paragraphShapes,
                              const FormattedText::FormattingParams &textParams,
                              const compat::FRectangle& unscaledTextBounds,
@@ -76,19 +78,72 @@ TextDrawResult drawTextInner(Context &ctx,
                              Pixel32* pixels, int width, int height,
                              bool dry); // Only compute the boundaries, the actual drawing does not take place.
 
-/// Draw individual ParagraphShapes.
+/// Draw individual ParagraphShapes. With metricsOnly, the glyphs are only laid out, not rasterized.
 ParagraphShape::DrawResults drawParagraphsInner(Context &ctx,
+                                                const FaceTable &faces,
                                                 const ParagraphShapes &shapes,
                                                 OverflowPolicy overflowPolicy,
                                                 int textWidth,
                                                 RenderScale scale,
                                                 VerticalPositioning positioning,
                                                 BaselinePolicy baselinePolicy,
-                                                float &caretVerticalPos);
+                                                float &caretVerticalPos,
+                                                bool metricsOnly);
 
 PlacedTextResult shapePlacedText(Context &ctx,
                                  const TextShapeInput &textShapeInput);
 
+/// Shapes the text using the given faces, which must not be used by another thread at the same time.
+PlacedTextResult shapePlacedText(Context &ctx,
+                                 const FaceTable &faces,
+                                 const TextShapeInput &textShapeInput);
+
+/**
+ * Shapes the text and retains its paragraph shapes in @a shapeData. If @a shapeData contains shapes
+ * of a previous shaping of the text, the shapes of the paragraphs which didn't change are reused.
+ */
+PlacedTextResult shapePlacedText(Context &ctx,
+                                 const FaceTable &faces,
+                                 const TextShapeInput &textShapeInput,
+                                 TextShapeDataPtr &shapeData);
+
+/**
+ * Lays out the paragraph shapes retained in @a shapeData for the frame size of @a textShapeInput, without shaping
+ * the text again. Only the line breaking and the placement are repeated. Shapes the text if @a shapeData is null.
+ */
+PlacedTextResult reflowPlacedText(Context &ctx,
+                                  const FaceTable &faces,
+                                  const TextShapeInput &textShapeInput,
+                                  TextShapeDataPtr &shapeData);
+
+/**
+ * Restyles the placed text, if @a textShapeInput only changes the color or decorations of the characters
+ * of @a previousInput. The colors are changed in a copy of @a placedTextData, which may be shared by other text shapes,
+ * changed decorations are laid out with the shapes retained in @a shapeData.
+ *
+ * @return  false if the text has to be shaped instead
+ */
+bool restylePlacedText(Context &ctx,
+                       const FaceTable &faces,
+                       const TextShapeInput &previousInput,
+                       const TextShapeInput &textShapeInput,
+                       TextShapeDataPtr &shapeData,
+                       std::shared_ptr<const PlacedTextData> &placedTextData);
+
+/**
+ * Lays out the text again without shaping it, if @a textShapeInput only changes the font sizes
+ * of the characters of @a previousInput. The advances and metrics of the glyphs retained in @a shapeData
+ * are scaled, which is only possible for unhinted glyphs of scalable fonts, not bitmap or color ones.
+ *
+ * @return  false if the text has to be shaped instead
+ */
+bool resizePlacedText(Context &ctx,
+                      const FaceTable &faces,
+                      const TextShapeInput &previousInput,
+                      const TextShapeInput &textShapeInput,
+                      TextShapeDataPtr &shapeData,
+                      std::shared_ptr<const PlacedTextData> &placedTextData);
+
 // Draw text in the PlacedText representation into bitmap. Clip by viewArea.
 TextDrawResult drawPlacedText(Context &ctx,
                               const PlacedTextData &placedTextData,
@@ -96,8 +151,17 @@ TextDrawResult drawPlacedText(Context &ctx,
                               const compat::Rectangle &viewArea,
                               void *pixels, int width, int height);
 
+// Draw text using the given faces, which must not be used by another thread at the same time.
+TextDrawResult drawPlacedText(Context &ctx,
+                              const FaceTable &faces,
+                              const PlacedTextData &placedTextData,
+                              float scale,
+                              const compat::Rectangle &viewArea,
+                              void *pixels, int width, int height);
+
 // Draw text in the PlacedText representation into bitmap. Clip by viewArea.
 TextDrawResult drawPlacedTextInner(Context &ctx,
+                                   const FaceTable &faces,
                                    const PlacedTextData &placedTextData,
                                    RenderScale scale,
                                    const compat::FRectangle& viewArea,
@@ -0,0 +1,94 @@
+#include "Analyzer.h"
+
+namespace odtr {
+namespace unicode {
+
+Analyzer::Analyzer(AnalyzerPool& pool)
+    : pool_(pool)
+{
+}
+
+Analyzer::~Analyzer()
+{
+    if (bidi_ != nullptr) {
+        ubidi_close(bidi_);
+    }
+}
+
+icu::BreakIterator* Analyzer::lineBreakIterator(const icu::Locale& locale)
+{
+    auto it = lineBreakIterators_.find(locale.getName());
+    if (it == std::end(lineBreakIterators_)) {
+        std::unique_ptr<icu::BreakIterator> iterator = pool_.createLineBreakIterator(locale);
+        if (!iterator) {
+            return nullptr;
+        }
+        it = lineBreakIterators_.emplace(locale.getName(), std::move(iterator)).first;
+    }
+
+    return it->second.get();
+}
+
+UBiDi* Analyzer::bidi()
+{
+    if (bidi_ == nullptr) {
+        // allocates memory on demand, as the paragraphs get longer
+        bidi_ = ubidi_open();
+    }
+
+    return bidi_;
+}
+
+AnalyzerPool::Lease::Lease(AnalyzerPool& pool, std::unique_ptr<Analyzer> analyzer)
+    : pool_(&pool),
+      analyzer_(std::move(analyzer))
+{
+}
+
+AnalyzerPool::Lease::~Lease()
+{
+    if (analyzer_) {
+        pool_->giveBack(std::move(analyzer_));
+    }
+}
+
+AnalyzerPool::Lease AnalyzerPool::lease()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (!analyzers_.empty()) {
+            std::unique_ptr<Analyzer> analyzer = std::move(analyzers_.back());
+            analyzers_.pop_back();
+            return Lease(*this, std::move(analyzer));
+        }
+    }
+
+    return Lease(*this, std::make_unique<Analyzer>(*this));
+}
+
+std::unique_ptr<icu::BreakIterator> AnalyzerPool::createLineBreakIterator(const icu::Locale& locale)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = lineBreakPrototypes_.find(locale.getName());
+    if (it == std::end(lineBreakPrototypes_)) {
+        UErrorCode error = U_ZERO_ERROR;
+        std::unique_ptr<icu::BreakIterator> prototype(icu::BreakIterator::createLineInstance(locale, error));
+        if (!prototype || U_FAILURE(error)) {
+            return nullptr;
+        }
+        it = lineBreakPrototypes_.emplace(locale.getName(), std::move(prototype)).first;
+    }
+
+    return std::unique_ptr<icu::BreakIterator>(it->second->clone());
+}
+
+void AnalyzerPool::giveBack(std::unique_ptr<Analyzer> analyzer)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    analyzers_.push_back(std::move(analyzer));
+}
+
+} // namespace unicode
+} // namespace odtr
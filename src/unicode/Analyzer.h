@@ -0,0 +1,87 @@
+#pragma once
+
+#include <unicode/brkiter.h>
+#include <unicode/ubidi.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace odtr {
+namespace unicode {
+
+class AnalyzerPool;
+
+/**
+ * ICU objects reused for the analysis of paragraphs - line break iterators and a BiDi object.
+ *
+ * Creating them takes much longer than analysing a short paragraph.
+ * An analyzer must not be used by multiple threads at once, see AnalyzerPool::lease.
+ */
+class Analyzer
+{
+public:
+    explicit Analyzer(AnalyzerPool& pool);
+    ~Analyzer();
+    Analyzer(const Analyzer&) = delete;
+    Analyzer& operator=(const Analyzer&) = delete;
+
+    /// Returns a line break iterator for the locale, or null if it cannot be created.
+    icu::BreakIterator* lineBreakIterator(const icu::Locale& locale);
+
+    /// Returns the BiDi object, or null if it cannot be allocated.
+    UBiDi* bidi();
+
+private:
+    AnalyzerPool& pool_;
+
+    std::unordered_map<std::string, std::unique_ptr<icu::BreakIterator>> lineBreakIterators_; ///< The key is a locale name
+    UBiDi* bidi_ = nullptr;
+};
+
+/**
+ * Analyzers of a context, one for each thread analysing paragraphs.
+ */
+class AnalyzerPool
+{
+public:
+    /// An analyzer exclusively used by the holder, returned to the pool on destruction.
+    class Lease
+    {
+    public:
+        Lease(Lease&&) = default;
+        Lease& operator=(Lease&&) = delete;
+        ~Lease();
+
+        Analyzer& operator*() const { return *analyzer_; }
+        Analyzer* operator->() const { return analyzer_.get(); }
+
+    private:
+        friend class AnalyzerPool;
+        Lease(AnalyzerPool& pool, std::unique_ptr<Analyzer> analyzer);
+
+        AnalyzerPool* pool_;
+        std::unique_ptr<Analyzer> analyzer_;
+    };
+
+    AnalyzerPool() = default;
+    AnalyzerPool(const AnalyzerPool&) = delete;
+    AnalyzerPool& operator=(const AnalyzerPool&) = delete;
+
+    Lease lease();
+
+    /// Creates a line break iterator for the locale, cloned from the one created on the first call. Null on failure.
+    std::unique_ptr<icu::BreakIterator> createLineBreakIterator(const icu::Locale& locale);
+
+private:
+    void giveBack(std::unique_ptr<Analyzer> analyzer);
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Analyzer>> analyzers_;
+    std::unordered_map<std::string, std::unique_ptr<icu::BreakIterator>> lineBreakPrototypes_; ///< The key is a locale name
+};
+
+} // namespace unicode
+} // namespace odtr
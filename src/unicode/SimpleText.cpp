@@ -0,0 +1,129 @@
+#include "SimpleText.h"
+
+#include <unicode/uchar.h>
+
+#include <array>
+#include <cstdint>
+
+namespace odtr {
+namespace unicode {
+
+using namespace compat;
+
+namespace {
+
+/// Line breaking classes of the simple characters, see UAX #14.
+enum class SimpleClass : std::uint8_t
+{
+    OTHER,              ///< Not simple
+    ALPHABETIC,         ///< AL
+    NUMERIC,            ///< NU
+    INFIX_SEPARATOR,    ///< IS
+    HYPHEN,             ///< HY
+    SPACE,              ///< SP
+};
+
+constexpr qchar SIMPLE_LIMIT = 0x80;
+
+using ClassTable = std::array<SimpleClass, SIMPLE_LIMIT>;
+
+ClassTable createClassTable()
+{
+    ClassTable table;
+
+    for (qchar c = 0; c < SIMPLE_LIMIT; ++c) {
+        switch (u_getIntPropertyValue(static_cast<UChar32>(c), UCHAR_LINE_BREAK)) {
+            case U_LB_ALPHABETIC:
+                table[c] = SimpleClass::ALPHABETIC;
+                break;
+            case U_LB_NUMERIC:
+                table[c] = SimpleClass::NUMERIC;
+                break;
+            case U_LB_INFIX_NUMERIC:
+                table[c] = SimpleClass::INFIX_SEPARATOR;
+                break;
+            case U_LB_HYPHEN:
+                table[c] = SimpleClass::HYPHEN;
+                break;
+            case U_LB_SPACE:
+                table[c] = SimpleClass::SPACE;
+                break;
+            default:
+                table[c] = SimpleClass::OTHER;
+                break;
+        }
+    }
+
+    return table;
+}
+
+const ClassTable& classTable()
+{
+    static const ClassTable table = createClassTable();
+    return table;
+}
+
+SimpleClass classOf(qchar c)
+{
+    return c < SIMPLE_LIMIT ? classTable()[c] : SimpleClass::OTHER;
+}
+
+}
+
+bool isSimpleText(const qchar* text, std::size_t len)
+{
+    if (len == 0) {
+        return false;
+    }
+
+    SimpleClass prev = SimpleClass::SPACE; // the start of text behaves as a space for the rules below
+    for (std::size_t i = 0; i < len; ++i) {
+        const SimpleClass cls = classOf(text[i]);
+
+        if (cls == SimpleClass::OTHER) {
+            return false;
+        }
+        // word-initial hyphens and separators after spaces are treated differently by Unicode versions
+        if (prev == SimpleClass::SPACE && (cls == SimpleClass::HYPHEN || cls == SimpleClass::INFIX_SEPARATOR)) {
+            return false;
+        }
+
+        prev = cls;
+    }
+
+    return true;
+}
+
+bool hasStrongLeftToRight(const qchar* text, std::size_t len)
+{
+    for (std::size_t i = 0; i < len; ++i) {
+        if ((text[i] >= 'A' && text[i] <= 'Z') || (text[i] >= 'a' && text[i] <= 'z')) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::vector<bool> findSimpleLineBreaks(const qchar* text, std::size_t len)
+{
+    std::vector<bool> opportunities(len + 1, false);
+    opportunities.front() = true;
+    opportunities.back() = true;
+
+    for (std::size_t i = 1; i < len; ++i) {
+        const SimpleClass prev = classOf(text[i - 1]);
+        const SimpleClass cls = classOf(text[i]);
+
+        // LB7: no break before spaces, LB18: break after spaces,
+        // LB21: break after a hyphen unless followed by a number, a separator or a hyphen (LB13, LB25)
+        opportunities[i] =
+            cls != SimpleClass::SPACE &&
+            (prev == SimpleClass::SPACE || (prev == SimpleClass::HYPHEN && cls == SimpleClass::ALPHABETIC));
+    }
+
+    return opportunities;
+}
+
+} // namespace unicode
+} // namespace odtr
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../compat/basic-types.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace odtr {
+namespace unicode {
+
+/**
+ * Whether the text consists only of Basic Latin letters, digits, spaces and a few punctuation characters,
+ * whose line breaking is simple enough to be found by findSimpleLineBreaks rather than by ICU.
+ * A simple text contains no strong right-to-left characters, it is a single left-to-right visual run.
+ */
+bool isSimpleText(const compat::qchar* text, std::size_t len);
+
+/// Whether a simple text contains a strong left-to-right character, i.e. a letter.
+bool hasStrongLeftToRight(const compat::qchar* text, std::size_t len);
+
+/**
+ * Finds line break opportunities of a simple text, identical to the ICU line break iterator.
+ *
+ * @return  opportunities indexed by characters, including the end of the text
+ */
+std::vector<bool> findSimpleLineBreaks(const compat::qchar* text, std::size_t len);
+
+} // namespace unicode
+} // namespace odtr
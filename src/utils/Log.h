@@ -4,6 +4,7 @@
 
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 
 namespace odtr {
@@ -59,6 +60,8 @@ private:
     {
         if (logFunc) {
             auto str = fmt::format(fmt, args...);
+            // the callbacks are not required to be thread-safe
+            std::lock_guard<std::mutex> lock(mutex);
             logFunc(str);
         }
     }
@@ -67,6 +70,8 @@ private:
     FuncType warnFunc;
     FuncType infoFunc;
     FuncType debugFunc;
+
+    mutable std::mutex mutex;
 };
 
 } // utils
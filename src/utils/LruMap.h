@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace odtr {
+namespace utils {
+
+/**
+ * Map of a limited number of entries, the least recently used one is evicted when a new one doesn't fit.
+ * Not thread-safe.
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruMap
+{
+public:
+    explicit LruMap(std::size_t capacity) : capacity_(capacity) {}
+
+    /// Returns the value of @a key and marks it as the most recently used, or null if not present.
+    Value* find(const Key& key)
+    {
+        const auto it = index_.find(key);
+        if (it == index_.end()) {
+            return nullptr;
+        }
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return &it->second->second;
+    }
+
+    /// Stores the value of a key not present yet, evicting the least recently used entry if full.
+    Value& insert(const Key& key, Value value)
+    {
+        if (capacity_ > 0 && entries_.size() >= capacity_) {
+            index_.erase(entries_.back().first);
+            entries_.pop_back();
+        }
+        entries_.emplace_front(key, std::move(value));
+        index_.emplace(key, entries_.begin());
+        return entries_.front().second;
+    }
+
+    std::size_t size() const { return entries_.size(); }
+    std::size_t capacity() const { return capacity_; }
+
+    void clear()
+    {
+        index_.clear();
+        entries_.clear();
+    }
+
+private:
+    using Entries = std::list<std::pair<Key, Value>>;
+
+    std::size_t capacity_;
+    /// The most recently used entry first.
+    Entries entries_;
+    std::unordered_map<Key, typename Entries::iterator, Hash> index_;
+};
+
+} // namespace utils
+} // namespace odtr
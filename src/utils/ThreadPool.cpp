@@ -0,0 +1,130 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace odtr {
+namespace utils {
+
+thread_local ThreadPool::CurrentWorker ThreadPool::currentWorker_ = { nullptr, 0 };
+
+ThreadPool::ThreadPool(std::size_t threadCount)
+{
+    workers_.reserve(threadCount);
+    for (std::size_t i = 0; i < threadCount; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (std::size_t i = 0; i < threadCount; ++i) {
+        workers_[i]->thread = std::thread(&ThreadPool::run, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        stopping_ = true;
+    }
+    batchStarted_.notify_all();
+
+    for (const std::unique_ptr<Worker>& worker : workers_) {
+        worker->thread.join();
+    }
+}
+
+void ThreadPool::parallelFor(std::size_t count, const Task& task)
+{
+    if (count == 0) {
+        return;
+    }
+
+    // the workers are busy with the outer batch, waiting for them would never end
+    if (isCurrentThreadWorker()) {
+        for (std::size_t i = 0; i < count; ++i) {
+            task(i, currentWorker_.index);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> batchLock(batchMutex_);
+
+    task_ = &task;
+    remaining_ = count;
+
+    // contiguous chunks keep neighbouring tasks on one worker until stolen
+    const std::size_t chunk = (count + workers_.size() - 1) / workers_.size();
+    for (std::size_t w = 0; w < workers_.size(); ++w) {
+        const std::size_t begin = std::min(count, w * chunk);
+        const std::size_t end = std::min(count, begin + chunk);
+
+        std::lock_guard<std::mutex> lock(workers_[w]->mutex);
+        for (std::size_t i = begin; i < end; ++i) {
+            workers_[w]->queue.push_back(i);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        ++batch_;
+    }
+    batchStarted_.notify_all();
+
+    std::unique_lock<std::mutex> lock(stateMutex_);
+    batchFinished_.wait(lock, [this] { return remaining_ == 0; });
+    task_ = nullptr;
+}
+
+void ThreadPool::run(std::size_t workerIndex)
+{
+    currentWorker_ = { this, workerIndex };
+
+    std::size_t batch = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(stateMutex_);
+            batchStarted_.wait(lock, [this, batch] { return stopping_ || batch_ != batch; });
+            if (stopping_) {
+                return;
+            }
+            batch = batch_;
+        }
+
+        std::size_t index = 0;
+        while (takeTask(workerIndex, index)) {
+            (*task_)(index, workerIndex);
+
+            if (--remaining_ == 0) {
+                std::lock_guard<std::mutex> lock(stateMutex_);
+                batchFinished_.notify_all();
+            }
+        }
+    }
+}
+
+bool ThreadPool::takeTask(std::size_t workerIndex, std::size_t& index)
+{
+    {
+        Worker& own = *workers_[workerIndex];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.queue.empty()) {
+            index = own.queue.front();
+            own.queue.pop_front();
+            return true;
+        }
+    }
+
+    for (std::size_t i = 1; i < workers_.size(); ++i) {
+        Worker& victim = *workers_[(workerIndex + i) % workers_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.queue.empty()) {
+            index = victim.queue.back();
+            victim.queue.pop_back();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+} // namespace utils
+} // namespace odtr
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace odtr {
+namespace utils {
+
+/**
+ * Fixed-size pool of worker threads running batches of indexed tasks.
+ *
+ * The indices of a batch are split into contiguous chunks, one per worker.
+ * Each worker takes tasks from the front of its own queue, once it runs
+ * out, it steals from the back of the other queues, so uneven tasks get
+ * balanced without a shared queue being contended all the time.
+ *
+ * A batch started from within a task of the same pool runs on the calling worker.
+ */
+class ThreadPool
+{
+public:
+    /// Task of a batch, called with the task index and the index of the worker running it.
+    using Task = std::function<void(std::size_t index, std::size_t workerIndex)>;
+
+    explicit ThreadPool(std::size_t threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    std::size_t threadCount() const { return workers_.size(); }
+
+    /// Returns true if called from within a task of this pool, a batch started there runs on the calling worker.
+    bool isCurrentThreadWorker() const { return currentWorker_.pool == this; }
+
+    /// Runs @a task for all indices in [0, count) and waits until all of them are finished.
+    void parallelFor(std::size_t count, const Task& task);
+
+private:
+    /// Pool and index of the worker running on the current thread.
+    struct CurrentWorker
+    {
+        const ThreadPool* pool;
+        std::size_t index;
+    };
+    static thread_local CurrentWorker currentWorker_;
+
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<std::size_t> queue;
+        std::thread thread;
+    };
+
+    void run(std::size_t workerIndex);
+    bool takeTask(std::size_t workerIndex, std::size_t& index);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    /// Serializes batches.
+    std::mutex batchMutex_;
+
+    std::mutex stateMutex_;
+    std::condition_variable batchStarted_;
+    std::condition_variable batchFinished_;
+    std::size_t batch_ = 0;
+    bool stopping_ = false;
+
+    const Task* task_ = nullptr;
+    std::atomic<std::size_t> remaining_ {0};
+};
+
+} // namespace utils
+} // namespace odtr
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "compat/blend-ops.h"
+
+using namespace odtr::compat;
+
+namespace {
+
+Pixel32 randomPremultipliedPixel(std::mt19937 &rng) {
+    const unsigned a = rng() % 256u;
+    return (rng() % (a+1)) | (rng() % (a+1)) << 8 | (rng() % (a+1)) << 16 | a << 24;
+}
+
+void expectWithinOne(const std::vector<Pixel32> &actual, const std::vector<Pixel32> &expected) {
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); ++i) {
+        for (int channel = 0; channel < 4; ++channel) {
+            const int a = actual[i] >> (8*channel) & 0xff;
+            const int e = expected[i] >> (8*channel) & 0xff;
+            ASSERT_LE(std::abs(a - e), 1) << "pixel " << i << ", channel " << channel;
+        }
+    }
+}
+
+}
+
+TEST(BlendOpsTests, maskMatchesReference) {
+    std::mt19937 rng(7);
+    const int width = 37, height = 5;
+
+    for (int iteration = 0; iteration < 200; ++iteration) {
+        std::vector<Pixel32> dst(width*height);
+        std::vector<Pixel8> mask(width*height);
+        for (Pixel32 &p : dst)
+            p = randomPremultipliedPixel(rng);
+        for (Pixel8 &m : mask)
+            m = Pixel8(rng() % 4 == 0 ? 0 : rng() % 256);
+        const Pixel32 color = Pixel32(rng());
+
+        std::vector<Pixel32> expected = dst;
+        blendMask(dst.data(), width, mask.data(), width, width, height, color);
+        blendMaskReference(expected.data(), width, mask.data(), width, width, height, color);
+        expectWithinOne(dst, expected);
+    }
+}
+
+TEST(BlendOpsTests, premultipliedMatchesReference) {
+    std::mt19937 rng(11);
+    const int width = 37, height = 5;
+
+    for (int iteration = 0; iteration < 200; ++iteration) {
+        std::vector<Pixel32> dst(width*height);
+        std::vector<Pixel32> src(width*height);
+        for (Pixel32 &p : dst)
+            p = randomPremultipliedPixel(rng);
+        for (Pixel32 &p : src)
+            p = rng() % 4 == 0 ? 0 : randomPremultipliedPixel(rng);
+
+        std::vector<Pixel32> expected = dst;
+        blendPremultiplied(dst.data(), width, src.data(), width, width, height);
+        blendPremultipliedReference(expected.data(), width, src.data(), width, width, height);
+        expectWithinOne(dst, expected);
+    }
+}
@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "TextRendererApiTests.h"
+
+#include "text-renderer/Face.h"
+
+using namespace odtr;
+
+namespace {
+
+/// The font of the test files, also used by TextRendererApiTests.
+const char *const FONT_NAME = "HelveticaNeue";
+
+class FaceTests : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::string filename;
+        for (const char *extension : { ".ttf", ".otf" }) {
+            const std::string candidate = test::gFontsDirectory + "/" + FONT_NAME + extension;
+            if (std::filesystem::exists(candidate)) {
+                filename = candidate;
+                break;
+            }
+        }
+        if (filename.empty()) {
+            GTEST_SKIP() << FONT_NAME << " not found in the fonts directory";
+        }
+
+        ASSERT_EQ(FT_Init_FreeType(&library), 0);
+        face = std::make_unique<Face>(library, filename.c_str(), 0);
+        ASSERT_TRUE(face->ready());
+        ASSERT_TRUE(face->setSize(24));
+    }
+
+    void TearDown() override {
+        face.reset();
+        if (library != nullptr) {
+            FT_Done_FreeType(library);
+        }
+    }
+
+    FT_UInt glyphIndex(compat::qchar c) const {
+        return FT_Get_Char_Index(face->getFtFace(), c);
+    }
+
+    FT_Library library = nullptr;
+    std::unique_ptr<Face> face;
+};
+
+void expectSameLayout(const Glyph &actual, const Glyph &expected) {
+    EXPECT_EQ(actual.bitmapWidth(), expected.bitmapWidth());
+    EXPECT_EQ(actual.bitmapHeight(), expected.bitmapHeight());
+    EXPECT_EQ(actual.bitmapBearing.x, expected.bitmapBearing.x);
+    EXPECT_EQ(actual.bitmapBearing.y, expected.bitmapBearing.y);
+    EXPECT_EQ(actual.lsb_delta, expected.lsb_delta);
+    EXPECT_EQ(actual.rsb_delta, expected.rsb_delta);
+    EXPECT_EQ(actual.metricsBearing.x, expected.metricsBearing.x);
+    EXPECT_EQ(actual.metricsBearing.y, expected.metricsBearing.y);
+}
+
+std::vector<Pixel32> blitGlyph(const Glyph &glyph) {
+    const GlyphPtr blitted = glyph.clone();
+    blitted->setColor(0xffffffff);
+    blitted->setDestination(IPoint2 { 0, 0 });
+    std::vector<Pixel32> pixels(static_cast<size_t>(glyph.bitmapWidth() * glyph.bitmapHeight()), 0);
+    blitted->blit(pixels.data(), IDims2 { glyph.bitmapWidth(), glyph.bitmapHeight() }, compat::Vector2i { 0, 0 });
+    return pixels;
+}
+
+}
+
+TEST_F(FaceTests, metricsMatchRendering) {
+    // the glyphs carry the bearings and the advance corrections (side bearing deltas) the layout uses
+    for (const compat::qchar c : std::u32string(U"AVg,j@ \u00C5")) {
+        const FT_UInt codepoint = glyphIndex(c);
+        for (const bool disableHinting : { false, true }) {
+            for (const float offset : { 0.0f, 0.3f, 0.75f }) {
+                for (const ScaleParams scale : { ScaleParams { 1.0f, 1.0f }, ScaleParams { 2.5f, 1.0f }, ScaleParams { 1.0f, 0.5f } }) {
+                    const compat::Vector2f glyphOffset { offset, 0.0f };
+                    const GlyphPtr rendered = face->acquireGlyph(codepoint, glyphOffset, scale, true, disableHinting);
+                    const GlyphPtr metrics = face->acquireGlyph(codepoint, glyphOffset, scale, false, disableHinting);
+                    ASSERT_TRUE(rendered != nullptr);
+                    ASSERT_TRUE(metrics != nullptr);
+                    EXPECT_EQ(metrics->bitmapByteSize(), 0);
+                    expectSameLayout(*metrics, *rendered);
+                }
+            }
+        }
+    }
+}
+
+TEST_F(FaceTests, glyphBearing) {
+    for (const compat::qchar c : std::u32string(U"AVg,j@ ")) {
+        const FT_UInt codepoint = glyphIndex(c);
+
+        // the bearing is the one of the unhinted glyph at its origin
+        ASSERT_EQ(FT_Load_Glyph(face->getFtFace(), codepoint, FT_LOAD_NO_HINTING), 0);
+        const FT_Glyph_Metrics &metrics = face->getFtFace()->glyph->metrics;
+        const compat::Vector2f bearing = face->getGlyphBearing(codepoint);
+        EXPECT_FLOAT_EQ(bearing.x, FreetypeHandle::from26_6fixed(metrics.horiBearingX));
+        EXPECT_FLOAT_EQ(bearing.y, FreetypeHandle::from26_6fixed(metrics.horiBearingY));
+
+        // cached per size
+        const compat::Vector2f cachedBearing = face->getGlyphBearing(codepoint);
+        EXPECT_EQ(cachedBearing.x, bearing.x);
+        EXPECT_EQ(cachedBearing.y, bearing.y);
+    }
+}
+
+TEST_F(FaceTests, metricsCacheReuse) {
+    const FT_UInt codepoint = glyphIndex('A');
+    const ScaleParams scale { 1.0f, 1.0f };
+    const GlyphPtr first = face->acquireGlyph(codepoint, {}, scale, false, false);
+    ASSERT_TRUE(first != nullptr);
+
+    // more glyphs than the cache holds, the glyph in use keeps being returned the same
+    for (int i = 0; i < 5000; ++i) {
+        const compat::Vector2f offset { static_cast<float>(i % 64) / 64.0f, static_cast<float>(i / 64) / 64.0f };
+        ASSERT_TRUE(face->acquireGlyph(glyphIndex('a' + i % 26), offset, scale, false, false) != nullptr);
+
+        const GlyphPtr reused = face->acquireGlyph(codepoint, {}, scale, false, false);
+        ASSERT_TRUE(reused != nullptr);
+        expectSameLayout(*reused, *first);
+    }
+}
+
+TEST_F(FaceTests, renderedOutlines) {
+    const GlyphAcquisitor acquisitor;
+    for (const compat::qchar c : std::u32string(U"AVg,j@\u00C5")) {
+        const FT_UInt codepoint = glyphIndex(c);
+        for (const bool disableHinting : { false, true }) {
+            GlyphAcquisitor::Parameters params;
+            params.scalable = true;
+            params.loadflags = disableHinting ? FT_LOAD_NO_HINTING : FT_LOAD_DEFAULT;
+
+            for (const ScaleParams scale : { ScaleParams { 1.0f, 1.0f }, ScaleParams { 2.5f, 1.0f }, ScaleParams { 1.0f, 0.5f } }) {
+                const compat::Vector2f glyphOffset { 0.3f, 0.0f };
+                // rendered from the outline cached by the face, and from the glyph slot
+                const GlyphPtr rendered = face->acquireGlyph(codepoint, glyphOffset, scale, true, disableHinting);
+                const GlyphPtr expected = acquisitor.acquire(face->getFtFace(), params, codepoint, glyphOffset, scale, true);
+                ASSERT_TRUE(rendered != nullptr);
+                ASSERT_TRUE(expected != nullptr);
+                expectSameLayout(*rendered, *expected);
+                EXPECT_EQ(blitGlyph(*rendered), blitGlyph(*expected));
+            }
+        }
+    }
+}
+
+TEST_F(FaceTests, cachedOutlinesReused) {
+    const FT_UInt codepoint = glyphIndex('A');
+    const GlyphPtr first = face->acquireGlyph(codepoint, {}, ScaleParams { 1.0f, 1.0f }, true, false);
+    ASSERT_TRUE(first != nullptr);
+
+    // a cached outline is rendered without loading the glyph into the slot again
+    const FT_UInt otherCodepoint = glyphIndex('g');
+    ASSERT_EQ(FT_Load_Glyph(face->getFtFace(), otherCodepoint, FT_LOAD_DEFAULT), 0);
+    const FT_Glyph_Metrics otherMetrics = face->getFtFace()->glyph->metrics;
+
+    const GlyphPtr second = face->acquireGlyph(codepoint, compat::Vector2f { 0.5f, 0.0f }, ScaleParams { 2.0f, 1.0f }, true, false);
+    ASSERT_TRUE(second != nullptr);
+    EXPECT_EQ(face->getFtFace()->glyph->metrics.horiAdvance, otherMetrics.horiAdvance);
+    EXPECT_EQ(face->getFtFace()->glyph->metrics.height, otherMetrics.height);
+    EXPECT_GT(second->bitmapWidth(), first->bitmapWidth());
+}
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "fonts/FontStorage.h"
+#include "fonts/MappedFile.h"
+
+using namespace odtr;
+
+namespace {
+
+class FontStorageTests : public ::testing::Test {
+protected:
+    void SetUp() override {
+        filename = (std::filesystem::temp_directory_path() / "odtr-font-storage-test.bin").string();
+        content.resize(100000);
+        for (size_t i = 0; i < content.size(); ++i) {
+            content[i] = static_cast<std::uint8_t>(i * 131 + 7);
+        }
+        std::ofstream file(filename, std::ios::binary);
+        file.write(reinterpret_cast<const char *>(content.data()), content.size());
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(filename);
+    }
+
+    std::string filename;
+    std::vector<std::uint8_t> content;
+};
+
+}
+
+TEST_F(FontStorageTests, storeFile) {
+    FontStorage storage;
+    ASSERT_TRUE(storage.storeFile("font", filename, false));
+    ASSERT_TRUE(storage.contains("font"));
+
+    const BufferView data = storage.get("font");
+    ASSERT_EQ(data.size(), content.size());
+    ASSERT_EQ(std::memcmp(data.data(), content.data(), content.size()), 0);
+
+    // the same data whether mapped or read
+    FontStorage mappingStorage;
+    ASSERT_TRUE(mappingStorage.storeFile("font", filename, true));
+    const BufferView mappedData = mappingStorage.get("font");
+    ASSERT_EQ(mappedData.size(), content.size());
+    ASSERT_EQ(std::memcmp(mappedData.data(), content.data(), content.size()), 0);
+
+    // the stored data is replaced by another one
+    std::vector<std::uint8_t> otherContent(10, 42);
+    std::memcpy(storage.alloc("font", otherContent.size()), otherContent.data(), otherContent.size());
+    storage.mark("font", true);
+    const BufferView otherData = storage.get("font");
+    ASSERT_EQ(otherData.size(), otherContent.size());
+    ASSERT_EQ(std::memcmp(otherData.data(), otherContent.data(), otherContent.size()), 0);
+
+    ASSERT_FALSE(storage.storeFile("missing", filename + ".missing", false));
+    ASSERT_FALSE(storage.storeFile("missing", filename + ".missing", true));
+    ASSERT_FALSE(storage.get("missing"));
+}
+
+TEST_F(FontStorageTests, mappedFile) {
+    const std::unique_ptr<MappedFile> mapping = MappedFile::open(filename);
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+    ASSERT_TRUE(mapping != nullptr);
+    ASSERT_EQ(mapping->size(), content.size());
+    ASSERT_EQ(std::memcmp(mapping->data(), content.data(), content.size()), 0);
+#else
+    ASSERT_TRUE(mapping == nullptr);
+#endif
+    ASSERT_TRUE(MappedFile::open(filename + ".missing") == nullptr);
+}
+
+TEST_F(FontStorageTests, equalContents) {
+    FontStorage storage;
+    ASSERT_TRUE(storage.storeFile("file", filename, true));
+    ASSERT_TRUE(storage.storeBytes("bytes", content.data(), content.size()));
+
+    // equal data is stored once, whatever the keys
+    const FontStorage::ContentPtr fileContent = storage.getContent("file");
+    ASSERT_TRUE(fileContent != nullptr);
+    ASSERT_EQ(storage.getContent("bytes"), fileContent);
+    ASSERT_EQ(storage.get("bytes").data(), storage.get("file").data());
+
+    std::vector<std::uint8_t> otherContent = content;
+    otherContent.back() ^= 1;
+    ASSERT_TRUE(storage.storeBytes("other", otherContent.data(), otherContent.size()));
+    ASSERT_NE(storage.getContent("other"), fileContent);
+
+    const std::string otherFilename = filename + ".copy";
+    std::filesystem::copy_file(filename, otherFilename, std::filesystem::copy_options::overwrite_existing);
+    ASSERT_TRUE(storage.storeFile("copy", otherFilename, false));
+    std::filesystem::remove(otherFilename);
+    ASSERT_EQ(storage.getContent("copy"), fileContent);
+
+    // replaced data stays alive while it's held
+    ASSERT_TRUE(storage.storeBytes("file", otherContent.data(), otherContent.size()));
+    ASSERT_EQ(storage.getContent("file"), storage.getContent("other"));
+    ASSERT_EQ(fileContent->view().size(), content.size());
+    ASSERT_EQ(std::memcmp(fileContent->view().data(), content.data(), content.size()), 0);
+
+    ASSERT_FALSE(storage.storeBytes("empty", nullptr, 0));
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "text-renderer/Glyph.h"
+#include "text-renderer/GlyphCache.h"
+
+using namespace odtr;
+
+namespace {
+
+const int GLYPH_SIZE = 32;
+
+GlyphPtr createGlyph(unsigned char value) {
+    std::vector<unsigned char> pixels(GLYPH_SIZE * GLYPH_SIZE, value);
+
+    FT_Bitmap bitmap {};
+    bitmap.width = GLYPH_SIZE;
+    bitmap.rows = GLYPH_SIZE;
+    bitmap.pitch = GLYPH_SIZE;
+    bitmap.buffer = pixels.data();
+    bitmap.num_grays = 256;
+    bitmap.pixel_mode = FT_PIXEL_MODE_GRAY;
+
+    GlyphPtr glyph = std::make_unique<GrayGlyph>();
+    glyph->putBitmap(bitmap);
+    return glyph;
+}
+
+GlyphCache::Key createKey(FT_UInt codepoint) {
+    return GlyphCache::makeKey(nullptr, codepoint, 16.0f, 1.0f, compat::Vector2f { 0.25f, 0.0f }, false);
+}
+
+}
+
+TEST(GlyphCacheTests, findInserted) {
+    GlyphCache cache(1 << 20);
+    EXPECT_EQ(cache.find(createKey(1)), nullptr);
+
+    cache.insert(createKey(1), *createGlyph(0x80));
+    const GlyphPtr glyph = cache.find(createKey(1));
+    ASSERT_NE(glyph, nullptr);
+    EXPECT_EQ(glyph->bitmapWidth(), GLYPH_SIZE);
+    EXPECT_EQ(glyph->bitmapHeight(), GLYPH_SIZE);
+
+    // offsets below the 26.6 precision map to the same key
+    EXPECT_NE(cache.find(GlyphCache::makeKey(nullptr, 1, 16.0f, 1.0f, compat::Vector2f { 0.25f + 1.0f / 256.0f, 0.0f }, false)), nullptr);
+    EXPECT_EQ(cache.find(GlyphCache::makeKey(nullptr, 1, 16.0f, 1.0f, compat::Vector2f { 0.5f, 0.0f }, false)), nullptr);
+    EXPECT_EQ(cache.find(GlyphCache::makeKey(nullptr, 1, 17.0f, 1.0f, compat::Vector2f { 0.25f, 0.0f }, false)), nullptr);
+
+    const GlyphCache::Statistics stats = cache.statistics();
+    EXPECT_EQ(stats.hits, 2);
+    EXPECT_EQ(stats.misses, 3);
+    EXPECT_EQ(stats.entries, 1);
+}
+
+TEST(GlyphCacheTests, byteBudget) {
+    const size_t glyphBytes = createGlyph(0)->bitmapByteSize();
+    const size_t budget = 16 * glyphBytes * 2;
+    GlyphCache cache(budget);
+
+    // a glyph larger than the budget is not stored at all
+    GlyphCache tinyCache(glyphBytes / 2);
+    tinyCache.insert(createKey(1), *createGlyph(0));
+    EXPECT_EQ(tinyCache.statistics().entries, 0);
+
+    for (FT_UInt codepoint = 0; codepoint < 200; ++codepoint) {
+        cache.insert(createKey(codepoint), *createGlyph(static_cast<unsigned char>(codepoint)));
+        EXPECT_LE(cache.statistics().bytes, budget);
+    }
+
+    const GlyphCache::Statistics stats = cache.statistics();
+    EXPECT_GT(stats.evictions, 0);
+    EXPECT_GT(stats.entries, 0);
+    EXPECT_EQ(stats.entries + stats.evictions, 200);
+    EXPECT_GE(stats.bytes, stats.entries * glyphBytes);
+
+    cache.setByteBudget(0);
+    EXPECT_EQ(cache.statistics().entries, 0);
+    EXPECT_EQ(cache.statistics().bytes, 0);
+}
+
+TEST(GlyphCacheTests, leastRecentlyUsedEviction) {
+    const size_t glyphBytes = createGlyph(0)->bitmapByteSize();
+    GlyphCache cache(8 * glyphBytes * 2);
+
+    for (FT_UInt codepoint = 0; codepoint < 4; ++codepoint) {
+        cache.insert(createKey(codepoint), *createGlyph(0));
+    }
+    ASSERT_EQ(cache.statistics().evictions, 0);
+
+    // keep using the first glyph while many others get inserted
+    for (FT_UInt codepoint = 4; codepoint < 40; ++codepoint) {
+        ASSERT_NE(cache.find(createKey(0)), nullptr) << codepoint;
+        cache.insert(createKey(codepoint), *createGlyph(0));
+    }
+
+    EXPECT_NE(cache.find(createKey(0)), nullptr);
+    EXPECT_EQ(cache.find(createKey(1)), nullptr);
+    EXPECT_NE(cache.find(createKey(39)), nullptr);
+    EXPECT_GT(cache.statistics().evictions, 0);
+}
@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "utils/LruMap.h"
+
+using namespace odtr;
+
+TEST(LruMapTests, findInserted) {
+    utils::LruMap<int, std::string> map(4);
+    EXPECT_EQ(map.find(1), nullptr);
+
+    map.insert(1, "one");
+    map.insert(2, "two");
+    ASSERT_NE(map.find(1), nullptr);
+    EXPECT_EQ(*map.find(1), "one");
+    EXPECT_EQ(*map.find(2), "two");
+    EXPECT_EQ(map.size(), 2);
+
+    // values are stored in place, a found value is the same object
+    *map.find(1) = "uno";
+    EXPECT_EQ(*map.find(1), "uno");
+
+    map.clear();
+    EXPECT_EQ(map.size(), 0);
+    EXPECT_EQ(map.find(1), nullptr);
+}
+
+TEST(LruMapTests, leastRecentlyUsedEviction) {
+    utils::LruMap<int, int> map(4);
+    for (int i = 0; i < 4; ++i) {
+        map.insert(i, i);
+    }
+
+    // entries are evicted one at a time, the used ones are kept
+    for (int i = 4; i < 40; ++i) {
+        ASSERT_NE(map.find(0), nullptr) << i;
+        map.insert(i, i);
+        EXPECT_EQ(map.size(), 4);
+    }
+
+    EXPECT_NE(map.find(0), nullptr);
+    EXPECT_EQ(map.find(1), nullptr);
+    EXPECT_EQ(map.find(36), nullptr);
+    EXPECT_NE(map.find(37), nullptr);
+    EXPECT_NE(map.find(39), nullptr);
+}
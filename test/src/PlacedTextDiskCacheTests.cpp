@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <open-design-text-renderer/PlacedTextData.h>
+
+#include "common/content_hash.h"
+#include "text-renderer/PlacedTextDiskCache.h"
+#include "text-renderer/PlacedTextSerialization.h"
+
+using namespace odtr;
+
+namespace {
+
+PlacedTextData createPlacedText(std::uint32_t seed) {
+    PlacedTextData placedText;
+    placedText.textBounds = FRectangle { 0.0f, 0.0f, 100.0f + static_cast<float>(seed), 20.0f };
+    placedText.textTransform = Matrix3f { { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 10.0f, 20.0f, 1.0f } } };
+
+    PlacedGlyphs &glyphs = placedText.glyphs[FontSpecifier { "Roboto-Regular" }];
+    for (std::uint32_t i = 0; i < 64; ++i) {
+        PlacedGlyph glyph;
+        glyph.fontSize = 16.0f;
+        glyph.codepoint = (seed * 31 + i * 7) % 500;
+        glyph.originPosition = Vector2f { 9.5f * static_cast<float>(i), 16.0f };
+        glyph.color = 0xFF000000u + seed;
+        glyph.index = i;
+        glyph.lineIndex = 0;
+        glyph.bounds = FRectangle { glyph.originPosition.x, 2.0f, 9.0f, 14.0f };
+        glyphs.push_back(glyph);
+    }
+    placedText.lineBounds = { placedText.textBounds };
+    return placedText;
+}
+
+ContentHash createKey(std::uint32_t seed) {
+    return ContentHasher().add(static_cast<std::uint64_t>(seed)).finish();
+}
+
+class PlacedTextDiskCacheTests : public ::testing::Test {
+protected:
+    void SetUp() override {
+        directory = std::filesystem::temp_directory_path() / "odtr-placed-text-disk-cache-test";
+        std::filesystem::remove_all(directory);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(directory);
+    }
+
+    std::filesystem::path pathOf(std::uint32_t seed) const {
+        return directory / (toHexString(createKey(seed)) + ".odtr");
+    }
+
+    std::filesystem::path directory;
+};
+
+}
+
+TEST_F(PlacedTextDiskCacheTests, storedTexts) {
+    {
+        PlacedTextDiskCache cache(directory.string(), 1 << 20);
+        ASSERT_TRUE(cache.enabled());
+        EXPECT_TRUE(cache.find(createKey(1)) == nullptr);
+
+        cache.insert(createKey(1), createPlacedText(1));
+        cache.insert(createKey(2), createPlacedText(2));
+    }
+
+    // files written by one instance are read by another one
+    PlacedTextDiskCache cache(directory.string(), 1 << 20);
+    EXPECT_EQ(cache.statistics().entries, 2);
+
+    const std::unique_ptr<PlacedTextData> placedText = cache.find(createKey(2));
+    ASSERT_TRUE(placedText != nullptr);
+    EXPECT_EQ(placedText->textBounds.w, 102.0f);
+    EXPECT_EQ(placedText->glyphs.begin()->second.size(), 64);
+    EXPECT_TRUE(cache.find(createKey(3)) == nullptr);
+
+    const PlacedTextDiskCache::Statistics stats = cache.statistics();
+    EXPECT_EQ(stats.hits, 1);
+    EXPECT_EQ(stats.misses, 1);
+
+    // no temporary files are left
+    for (const auto &entry : std::filesystem::directory_iterator(directory)) {
+        EXPECT_EQ(entry.path().extension(), ".odtr");
+    }
+
+    EXPECT_FALSE(PlacedTextDiskCache(std::string(), 1 << 20).enabled());
+}
+
+TEST_F(PlacedTextDiskCacheTests, corruptedFile) {
+    PlacedTextDiskCache cache(directory.string(), 1 << 20);
+    cache.insert(createKey(1), createPlacedText(1));
+
+    for (const auto &entry : std::filesystem::directory_iterator(directory)) {
+        std::filesystem::resize_file(entry.path(), std::filesystem::file_size(entry.path()) / 2);
+    }
+    EXPECT_TRUE(cache.find(createKey(1)) == nullptr);
+}
+
+TEST_F(PlacedTextDiskCacheTests, leastRecentlyUsedEviction) {
+    const size_t fileSize = priv::serializePlacedText(createPlacedText(0), true).size();
+    PlacedTextDiskCache cache(directory.string(), 8 * fileSize);
+
+    // the files are ordered by their modification times, set explicitly apart as file systems may store whole seconds
+    const std::filesystem::file_time_type past = std::filesystem::file_time_type::clock::now() - std::chrono::hours(1);
+
+    cache.insert(createKey(0), createPlacedText(0));
+    for (std::uint32_t seed = 1; seed < 16; ++seed) {
+        cache.insert(createKey(seed), createPlacedText(seed));
+        if (std::filesystem::exists(pathOf(seed))) {
+            std::filesystem::last_write_time(pathOf(seed), past + std::chrono::seconds(seed));
+        }
+        // the first text is used all the time
+        ASSERT_TRUE(cache.find(createKey(0)) != nullptr) << seed;
+    }
+
+    const PlacedTextDiskCache::Statistics stats = cache.statistics();
+    EXPECT_GT(stats.evictions, 0);
+    EXPECT_LE(stats.bytes, 8 * fileSize + fileSize / 2);
+    EXPECT_TRUE(cache.find(createKey(1)) == nullptr);
+    EXPECT_TRUE(cache.find(createKey(15)) != nullptr);
+}
+
+TEST_F(PlacedTextDiskCacheTests, replacedFile) {
+    PlacedTextDiskCache cache(directory.string(), 1 << 20);
+    cache.insert(createKey(1), createPlacedText(1));
+    const PlacedTextDiskCache::Statistics stats = cache.statistics();
+
+    // another writer may store the same text meanwhile
+    for (int i = 0; i < 3; ++i) {
+        cache.insert(createKey(1), createPlacedText(1));
+    }
+    EXPECT_EQ(cache.statistics().entries, stats.entries);
+    EXPECT_EQ(cache.statistics().bytes, stats.bytes);
+}
+
+TEST_F(PlacedTextDiskCacheTests, staleTemporaryFiles) {
+    PlacedTextDiskCache(directory.string(), 1 << 20).insert(createKey(1), createPlacedText(1));
+
+    const std::filesystem::path stale = directory / "stale.tmp";
+    const std::filesystem::path recent = directory / "recent.tmp";
+    for (const std::filesystem::path &path : { stale, recent }) {
+        std::ofstream(path) << "partial";
+    }
+    std::filesystem::last_write_time(stale, std::filesystem::file_time_type::clock::now() - std::chrono::hours(1));
+
+    // left over by a writer which didn't finish, the recent one may still be written
+    PlacedTextDiskCache cache(directory.string(), 1 << 20);
+    EXPECT_FALSE(std::filesystem::exists(stale));
+    EXPECT_TRUE(std::filesystem::exists(recent));
+    EXPECT_EQ(cache.statistics().entries, 1);
+}
@@ -0,0 +1,208 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <open-design-text-renderer/PlacedTextData.h>
+
+#include "text-renderer/PlacedTextSerialization.h"
+
+using namespace odtr;
+
+namespace {
+
+PlacedTextData createPlacedText() {
+    PlacedTextData placedText;
+    placedText.textBounds = FRectangle { 1.5f, -2.25f, 320.125f, 48.0f };
+    placedText.textTransform = Matrix3f { { { 0.7771f, -0.6293f, 0.0f }, { 0.6293f, 0.7771f, 0.0f }, { 187.285f, 314.067f, 1.0f } } };
+
+    const std::vector<std::string> faces = { "IBMPlexSans-Regular", "NotoColorEmoji", "Roboto-Bold" };
+    for (size_t f = 0; f < faces.size(); ++f) {
+        PlacedGlyphs &glyphs = placedText.glyphs[FontSpecifier { faces[f], static_cast<uint32_t>(f) }];
+        float x = 0.0f;
+        for (size_t i = 0; i < 200; ++i) {
+            PlacedGlyph glyph;
+            glyph.fontSize = i < 120 ? 36.0f : 12.5f;
+            glyph.codepoint = static_cast<uint32_t>(30 + (i * 7 + f) % 90);
+            glyph.originPosition = Vector2f { x, 24.0f + 40.0f * static_cast<float>(i / 50) };
+            glyph.color = i % 40 < 30 ? 0xFF1A1AE6u : 0x80000000u + static_cast<uint32_t>(f);
+            glyph.index = i * 3 + f;
+            glyph.lineIndex = i / 50;
+            glyph.bounds = FRectangle { x + 0.75f, glyph.originPosition.y - 26.0f, 17.0f + static_cast<float>(i % 3), 27.0f };
+            glyphs.push_back(glyph);
+
+            x = i % 50 == 49 ? 0.0f : x + 19.371f;
+        }
+    }
+
+    placedText.lineBounds = {
+        FRectangle { 0.0f, 0.0f, 300.0f, 40.0f },
+        FRectangle { 0.0f, 40.0f, 280.5f, 40.0f },
+        FRectangle { 0.0f, 80.0f, 290.0f, 40.0f },
+        FRectangle { 0.0f, 120.0f, 150.25f, 40.0f },
+    };
+    placedText.decorations = {
+        PlacedDecoration { PlacedDecoration::Type::UNDERLINE, Vector2f { 0.0f, 27.0f }, Vector2f { 120.0f, 27.0f }, 1.5f, 0xFF0000FFu },
+        PlacedDecoration { PlacedDecoration::Type::STRIKE_THROUGH, Vector2f { 10.0f, 60.0f }, Vector2f { 30.5f, 60.0f }, 2.0f, 0x7F00FF00u },
+    };
+    return placedText;
+}
+
+void expectSameRectangle(const FRectangle &actual, const FRectangle &expected) {
+    EXPECT_EQ(actual.l, expected.l);
+    EXPECT_EQ(actual.t, expected.t);
+    EXPECT_EQ(actual.w, expected.w);
+    EXPECT_EQ(actual.h, expected.h);
+}
+
+void expectSamePlacedText(const PlacedTextData &actual, const PlacedTextData &expected) {
+    expectSameRectangle(actual.textBounds, expected.textBounds);
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            EXPECT_EQ(actual.textTransform.m[i][j], expected.textTransform.m[i][j]);
+        }
+    }
+
+    ASSERT_EQ(actual.lineBounds.size(), expected.lineBounds.size());
+    for (size_t i = 0; i < actual.lineBounds.size(); ++i) {
+        expectSameRectangle(actual.lineBounds[i], expected.lineBounds[i]);
+    }
+
+    ASSERT_EQ(actual.glyphs.size(), expected.glyphs.size());
+    for (const auto &fontGlyphs : expected.glyphs) {
+        ASSERT_EQ(actual.glyphs.count(fontGlyphs.first), 1);
+        const PlacedGlyphs &actualGlyphs = actual.glyphs.at(fontGlyphs.first);
+        ASSERT_EQ(actualGlyphs.size(), fontGlyphs.second.size());
+        for (size_t g = 0; g < actualGlyphs.size(); ++g) {
+            const PlacedGlyph &expectedGlyph = fontGlyphs.second[g];
+            EXPECT_EQ(actualGlyphs[g].fontSize, expectedGlyph.fontSize);
+            EXPECT_EQ(actualGlyphs[g].codepoint, expectedGlyph.codepoint);
+            EXPECT_EQ(actualGlyphs[g].originPosition.x, expectedGlyph.originPosition.x);
+            EXPECT_EQ(actualGlyphs[g].originPosition.y, expectedGlyph.originPosition.y);
+            EXPECT_EQ(actualGlyphs[g].color, expectedGlyph.color);
+            EXPECT_EQ(actualGlyphs[g].index, expectedGlyph.index);
+            EXPECT_EQ(actualGlyphs[g].lineIndex, expectedGlyph.lineIndex);
+            expectSameRectangle(actualGlyphs[g].bounds, expectedGlyph.bounds);
+        }
+    }
+
+    ASSERT_EQ(actual.decorations.size(), expected.decorations.size());
+    for (size_t d = 0; d < actual.decorations.size(); ++d) {
+        EXPECT_EQ(actual.decorations[d].type, expected.decorations[d].type);
+        EXPECT_EQ(actual.decorations[d].start.x, expected.decorations[d].start.x);
+        EXPECT_EQ(actual.decorations[d].start.y, expected.decorations[d].start.y);
+        EXPECT_EQ(actual.decorations[d].end.x, expected.decorations[d].end.x);
+        EXPECT_EQ(actual.decorations[d].end.y, expected.decorations[d].end.y);
+        EXPECT_EQ(actual.decorations[d].thickness, expected.decorations[d].thickness);
+        EXPECT_EQ(actual.decorations[d].color, expected.decorations[d].color);
+    }
+}
+
+}
+
+TEST(PlacedTextSerializationTests, roundTrip) {
+    const PlacedTextData placedText = createPlacedText();
+
+    for (const bool compress : { false, true }) {
+        const std::vector<std::uint8_t> blob = priv::serializePlacedText(placedText, compress);
+        priv::PlacedTextDeserializeResult result = priv::deserializePlacedText(blob.data(), blob.size());
+        ASSERT_TRUE(result);
+
+        const PlacedTextDataPtr restored = result.moveValue();
+        expectSamePlacedText(*restored, placedText);
+        for (const auto &fontGlyphs : restored->glyphs) {
+            EXPECT_EQ(fontGlyphs.first.faceHandle, UINT32_MAX);
+            // the handle is internal to the shaping context and doesn't distinguish the fonts
+            EXPECT_TRUE(placedText.glyphs.find(fontGlyphs.first)->first == fontGlyphs.first);
+        }
+    }
+
+    const PlacedTextData empty {};
+    const std::vector<std::uint8_t> emptyBlob = priv::serializePlacedText(empty, true);
+    priv::PlacedTextDeserializeResult emptyResult = priv::deserializePlacedText(emptyBlob.data(), emptyBlob.size());
+    ASSERT_TRUE(emptyResult);
+    EXPECT_TRUE(emptyResult.value()->glyphs.empty());
+}
+
+TEST(PlacedTextSerializationTests, compactness) {
+    const PlacedTextData placedText = createPlacedText();
+
+    size_t glyphCount = 0;
+    for (const auto &fontGlyphs : placedText.glyphs) {
+        glyphCount += fontGlyphs.second.size();
+    }
+
+    const std::vector<std::uint8_t> raw = priv::serializePlacedText(placedText, false);
+    const std::vector<std::uint8_t> compressed = priv::serializePlacedText(placedText, true);
+    EXPECT_LT(raw.size(), glyphCount * sizeof(PlacedGlyph) / 2);
+    EXPECT_LT(compressed.size(), raw.size());
+}
+
+TEST(PlacedTextSerializationTests, invalidBlobs) {
+    const PlacedTextData placedText = createPlacedText();
+
+    for (const bool compress : { false, true }) {
+        const std::vector<std::uint8_t> blob = priv::serializePlacedText(placedText, compress);
+
+        EXPECT_EQ(priv::deserializePlacedText(nullptr, 0).error(), SerializationError::INVALID_HEADER);
+        EXPECT_EQ(priv::deserializePlacedText(blob.data(), 8).error(), SerializationError::INVALID_HEADER);
+
+        std::vector<std::uint8_t> otherVersion = blob;
+        otherVersion[4] = static_cast<std::uint8_t>(priv::PLACED_TEXT_FORMAT_VERSION + 1);
+        EXPECT_EQ(priv::deserializePlacedText(otherVersion.data(), otherVersion.size()).error(), SerializationError::UNSUPPORTED_VERSION);
+
+        // every truncation is detected
+        for (size_t length = 12; length < blob.size(); length += 7) {
+            EXPECT_FALSE(priv::deserializePlacedText(blob.data(), length)) << length;
+        }
+
+        // corrupted bytes are either detected or decode to some placed text, never read out of bounds
+        for (size_t i = 12; i < blob.size(); i += 5) {
+            std::vector<std::uint8_t> corrupted = blob;
+            corrupted[i] ^= 0xA5;
+            priv::deserializePlacedText(corrupted.data(), corrupted.size());
+        }
+    }
+}
+
+TEST(PlacedTextSerializationTests, invalidGlyphs) {
+    const auto expectCorrupted = [](const PlacedTextData &placedText) {
+        for (const bool compress : { false, true }) {
+            const std::vector<std::uint8_t> blob = priv::serializePlacedText(placedText, compress);
+            EXPECT_EQ(priv::deserializePlacedText(blob.data(), blob.size()).error(), SerializationError::CORRUPTED_DATA);
+        }
+    };
+
+    PlacedTextData negativeIndex = createPlacedText();
+    negativeIndex.glyphs.begin()->second[10].index = SIZE_MAX;
+    expectCorrupted(negativeIndex);
+
+    PlacedTextData lineOutOfBounds = createPlacedText();
+    lineOutOfBounds.glyphs.begin()->second.back().lineIndex = lineOutOfBounds.lineBounds.size();
+    expectCorrupted(lineOutOfBounds);
+
+    PlacedTextData unsortedLines = createPlacedText();
+    PlacedGlyphs &glyphs = unsortedLines.glyphs.begin()->second;
+    std::swap(glyphs.front(), glyphs.back());
+    expectCorrupted(unsortedLines);
+
+    // without the line bounds, any line index is accepted
+    PlacedTextData noLineBounds = createPlacedText();
+    noLineBounds.lineBounds.clear();
+    noLineBounds.glyphs.begin()->second.back().lineIndex = 1000;
+    const std::vector<std::uint8_t> noLineBoundsBlob = priv::serializePlacedText(noLineBounds, false);
+    EXPECT_TRUE(priv::deserializePlacedText(noLineBoundsBlob.data(), noLineBoundsBlob.size()));
+
+    // a codepoint varint of more than 32 bits
+    PlacedTextData maxCodepoint = createPlacedText();
+    maxCodepoint.glyphs.begin()->second.front().codepoint = UINT32_MAX;
+    std::vector<std::uint8_t> blob = priv::serializePlacedText(maxCodepoint, false);
+    ASSERT_TRUE(priv::deserializePlacedText(blob.data(), blob.size()));
+    const std::vector<std::uint8_t> maxVarint = { 0xFF, 0xFF, 0xFF, 0xFF, 0x0F };
+    const auto varintIt = std::search(blob.begin(), blob.end(), maxVarint.begin(), maxVarint.end());
+    ASSERT_TRUE(varintIt != blob.end());
+    varintIt[4] = 0x1F;
+    EXPECT_EQ(priv::deserializePlacedText(blob.data(), blob.size()).error(), SerializationError::CORRUPTED_DATA);
+}
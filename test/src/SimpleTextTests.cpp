@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unicode/brkiter.h>
+#include <unicode/ubidi.h>
+#include <unicode/unistr.h>
+
+#include "unicode/SimpleText.h"
+
+using namespace odtr;
+
+namespace {
+
+std::vector<compat::qchar> toText(const std::string &str) {
+    return std::vector<compat::qchar>(str.begin(), str.end());
+}
+
+std::vector<bool> icuLineBreaks(icu::BreakIterator &iterator, const std::vector<compat::qchar> &text) {
+    const icu::UnicodeString utext = icu::UnicodeString::fromUTF32(reinterpret_cast<const UChar32*>(text.data()), static_cast<int32_t>(text.size()));
+    std::vector<bool> opportunities(utext.length() + 1, false);
+
+    iterator.setText(utext);
+    do {
+        opportunities[iterator.current()] = true;
+    } while (iterator.next() != icu::BreakIterator::DONE);
+
+    return opportunities;
+}
+
+/// Checks that a simple text gets the same line breaks and a single left-to-right run from ICU.
+void expectSameAsIcu(icu::BreakIterator &iterator, UBiDi *bidi, const std::vector<compat::qchar> &text) {
+    const std::string str(text.begin(), text.end());
+
+    ASSERT_EQ(unicode::findSimpleLineBreaks(text.data(), text.size()), icuLineBreaks(iterator, text)) << '"' << str << '"';
+
+    const icu::UnicodeString utext = icu::UnicodeString::fromUTF32(reinterpret_cast<const UChar32*>(text.data()), static_cast<int32_t>(text.size()));
+    UErrorCode error = U_ZERO_ERROR;
+    ubidi_setPara(bidi, utext.getBuffer(), utext.length(), UBIDI_LTR, nullptr, &error);
+    ASSERT_FALSE(U_FAILURE(error));
+    ASSERT_EQ(ubidi_countRuns(bidi, &error), 1) << '"' << str << '"';
+
+    int32_t start = 0, length = 0;
+    ASSERT_EQ(ubidi_getVisualRun(bidi, 0, &start, &length), UBIDI_LTR) << '"' << str << '"';
+
+    const UBiDiDirection baseDirection = unicode::hasStrongLeftToRight(text.data(), text.size()) ? UBIDI_LTR : UBIDI_NEUTRAL;
+    ASSERT_EQ(ubidi_getBaseDirection(utext.getBuffer(), utext.length()), baseDirection) << '"' << str << '"';
+}
+
+}
+
+class SimpleTextTests : public ::testing::Test {
+protected:
+    void SetUp() override {
+        UErrorCode error = U_ZERO_ERROR;
+        lineIterator.reset(icu::BreakIterator::createLineInstance(icu::Locale::getDefault(), error));
+        ASSERT_FALSE(U_FAILURE(error));
+
+        bidi = ubidi_open();
+        ASSERT_NE(bidi, nullptr);
+    }
+
+    void TearDown() override {
+        ubidi_close(bidi);
+    }
+
+    std::unique_ptr<icu::BreakIterator> lineIterator;
+    UBiDi *bidi = nullptr;
+};
+
+TEST_F(SimpleTextTests, detection) {
+    EXPECT_TRUE(unicode::isSimpleText(toText("Hello world").data(), 11));
+    EXPECT_TRUE(unicode::isSimpleText(toText("well-known 3.14, a:b").data(), 20));
+
+    EXPECT_FALSE(unicode::isSimpleText(nullptr, 0));
+    EXPECT_FALSE(unicode::isSimpleText(toText("Hello!").data(), 6));
+    EXPECT_FALSE(unicode::isSimpleText(toText("(a)").data(), 3));
+    EXPECT_FALSE(unicode::isSimpleText(toText("a\tb").data(), 3));
+    EXPECT_FALSE(unicode::isSimpleText(toText("-a").data(), 2));
+    EXPECT_FALSE(unicode::isSimpleText(toText("a .5").data(), 4));
+
+    const std::vector<compat::qchar> hebrew = { 0x05D0, 0x05D1 };
+    EXPECT_FALSE(unicode::isSimpleText(hebrew.data(), hebrew.size()));
+}
+
+TEST_F(SimpleTextTests, corpusMatchesIcu) {
+    const std::vector<std::string> corpus = {
+        "Sign in",
+        "Lorem ipsum dolor sit amet, consectetur adipiscing elit",
+        "Version 2.1.0, released 2021-06-30",
+        "state-of-the-art user@example.com",
+        "A  double  spaced   label   ",
+        "Total: 1,234.56 USD",
+        "x=1;y=2 a*b #tag & more_text ~tilde",
+        "e-mail, re-do--again",
+        "12-ab 3.c d.4 9-9",
+    };
+
+    for (const std::string &str : corpus) {
+        const std::vector<compat::qchar> text = toText(str);
+        ASSERT_TRUE(unicode::isSimpleText(text.data(), text.size())) << '"' << str << '"';
+        expectSameAsIcu(*lineIterator, bidi, text);
+    }
+}
+
+TEST_F(SimpleTextTests, allShortTextsMatchIcu) {
+    // every short string of characters representing the simple classes and their combinations
+    const std::string alphabet = "aZ1 .,:-#@_";
+    const size_t maxLength = 4;
+
+    for (size_t length = 1; length <= maxLength; ++length) {
+        std::vector<size_t> indices(length, 0);
+        std::vector<compat::qchar> text(length);
+
+        for (bool done = false; !done; ) {
+            for (size_t i = 0; i < length; ++i) {
+                text[i] = alphabet[indices[i]];
+            }
+
+            if (unicode::isSimpleText(text.data(), text.size())) {
+                expectSameAsIcu(*lineIterator, bidi, text);
+            }
+
+            size_t k = 0;
+            while (k < length && ++indices[k] == alphabet.size()) {
+                indices[k++] = 0;
+            }
+            done = k == length;
+        }
+    }
+}
@@ -1,7 +1,16 @@
 
 #include "TextRendererApiTests.h"
 
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
 #include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 #include <gtest/gtest.h>
 
 #include <octopus/octopus.h>
@@ -13,7 +22,12 @@
 #include <open-design-text-renderer/text-renderer-api.h>
 #include <open-design-text-renderer/PlacedTextData.h>
 
+#include "fonts/FaceTable.h"
+#include "fonts/FontManager.h"
+#include "text-renderer/Context.h"
+#include "text-renderer/Face.h"
 #include "text-renderer/TextShape.h"
+#include "text-renderer/TextShapeData.h"
 
 
 namespace odtr {
@@ -46,16 +60,35 @@ protected:
         context = odtr::createContext(contextOptions());
     }
 
+    virtual void TearDown() override {
+        if (expectedContext != nullptr) {
+            odtr::destroyContext(expectedContext);
+        }
+    }
+
     void addMissingFonts(const octopus::Text &text) {
-        const std::vector<std::string> missingFonts = listMissingFonts(context, text);
+        addMissingFonts(context, text);
+    }
+
+    static void addMissingFonts(odtr::ContextHandle targetContext, const octopus::Text &text) {
+        const std::vector<std::string> missingFonts = listMissingFonts(targetContext, text);
         for (const std::string &missingFont : missingFonts) {
             const bool isAdded =
-                addFontFile(context, missingFont, std::string(), (std::string) (odtr::test::gFontsDirectory+"/"+(missingFont+".ttf")), false) ||
-                addFontFile(context, missingFont, std::string(), (std::string) (odtr::test::gFontsDirectory+"/"+(missingFont+".otf")), false);
+                addFontFile(targetContext, missingFont, std::string(), (std::string) (odtr::test::gFontsDirectory+"/"+(missingFont+".ttf")), false) ||
+                addFontFile(targetContext, missingFont, std::string(), (std::string) (odtr::test::gFontsDirectory+"/"+(missingFont+".otf")), false);
             ASSERT_TRUE(isAdded);
         }
     }
 
+    /// Shapes the text in a separate context, an identical text shape in the tested context would share its placed text.
+    odtr::TextShapeHandle shapeExpectedText(const octopus::Text &text) {
+        if (expectedContext == nullptr) {
+            expectedContext = odtr::createContext(contextOptions());
+        }
+        addMissingFonts(expectedContext, text);
+        return odtr::shapeText(expectedContext, text);
+    }
+
     static void readOctopusFile(const std::string &octopusFilePath, octopus::Octopus &octopusData) {
         std::string octopusJson;
         ASSERT_TRUE(ode::readFile(octopusFilePath, octopusJson));
@@ -74,7 +107,78 @@ protected:
         ASSERT_FALSE(octopusData.content->layers->empty());
     }
 
+    /// Reads the text of the decorations test file, its fonts are not added to any context.
+    void loadDecorationsText(octopus::Text &text) const {
+        octopus::Octopus octopusData;
+        ASSERT_NO_FATAL_FAILURE(readOctopusFile(decorationsOctopusPath, octopusData));
+
+        const nonstd::optional<octopus::Text> &decorationsText = octopusData.content->layers->front().text;
+        ASSERT_TRUE(decorationsText.has_value());
+        text = *decorationsText;
+    }
+
+    static odtr::DrawTextResult draw(odtr::ContextHandle context, odtr::TextShapeHandle textShape,
+                                     ode::Bitmap &bitmap, const odtr::DrawOptions &drawOptions) {
+        return odtr::drawText(context, textShape, bitmap.pixels(), bitmap.width(), bitmap.height(), drawOptions);
+    }
+
+    static odtr::DrawTextResult draw(odtr::ContextHandle context, const odtr::PlacedTextData &shapedText,
+                                     ode::Bitmap &bitmap, const odtr::DrawOptions &drawOptions) {
+        return odtr::drawShapedText(context, shapedText, bitmap.pixels(), bitmap.width(), bitmap.height(), drawOptions);
+    }
+
+    /// Asserts that both texts (text shapes or deserialized shaped texts) are drawn into buffers of the same dimensions with the same pixels.
+    template <typename TextA, typename TextB>
+    static void assertSameRendering(odtr::ContextHandle contextA, const TextA &textA,
+                                    odtr::ContextHandle contextB, const TextB &textB) {
+        const odtr::DrawOptions drawOptions { 2.0f, std::nullopt };
+        const odtr::Dimensions dimensions = odtr::getDrawBufferDimensions(contextA, textA, drawOptions);
+        const odtr::Dimensions dimensionsB = odtr::getDrawBufferDimensions(contextB, textB, drawOptions);
+        ASSERT_EQ(dimensionsB.width, dimensions.width);
+        ASSERT_EQ(dimensionsB.height, dimensions.height);
+
+        ode::Bitmap bitmapA(ode::PixelFormat::RGBA, ode::Vector2i(dimensions.width, dimensions.height));
+        bitmapA.clear();
+        ASSERT_FALSE(draw(contextA, textA, bitmapA, drawOptions).error);
+
+        ode::Bitmap bitmapB(ode::PixelFormat::RGBA, ode::Vector2i(dimensions.width, dimensions.height));
+        bitmapB.clear();
+        ASSERT_FALSE(draw(contextB, textB, bitmapB, drawOptions).error);
+
+        ASSERT_EQ(std::memcmp(bitmapA.pixels(), bitmapB.pixels(), 4 * dimensions.width * dimensions.height), 0);
+    }
+
+    static void assertSamePlacedText(const odtr::PlacedTextData &actual, const odtr::PlacedTextData &expected) {
+        ASSERT_EQ(actual.textBounds.w, expected.textBounds.w);
+        ASSERT_EQ(actual.textBounds.h, expected.textBounds.h);
+        ASSERT_EQ(actual.lineBounds.size(), expected.lineBounds.size());
+        ASSERT_EQ(actual.glyphs.size(), expected.glyphs.size());
+
+        for (const auto &fontGlyphs : expected.glyphs) {
+            ASSERT_EQ(actual.glyphs.count(fontGlyphs.first), 1);
+            const odtr::PlacedGlyphs &actualGlyphs = actual.glyphs.at(fontGlyphs.first);
+            ASSERT_EQ(actualGlyphs.size(), fontGlyphs.second.size());
+            for (size_t g = 0; g < actualGlyphs.size(); ++g) {
+                ASSERT_EQ(actualGlyphs[g].codepoint, fontGlyphs.second[g].codepoint);
+                ASSERT_EQ(actualGlyphs[g].index, fontGlyphs.second[g].index);
+                ASSERT_EQ(actualGlyphs[g].lineIndex, fontGlyphs.second[g].lineIndex);
+                ASSERT_EQ(actualGlyphs[g].originPosition.x, fontGlyphs.second[g].originPosition.x);
+                ASSERT_EQ(actualGlyphs[g].originPosition.y, fontGlyphs.second[g].originPosition.y);
+                ASSERT_EQ(actualGlyphs[g].color, fontGlyphs.second[g].color);
+            }
+        }
+
+        ASSERT_EQ(actual.decorations.size(), expected.decorations.size());
+        for (size_t d = 0; d < actual.decorations.size(); ++d) {
+            ASSERT_EQ(actual.decorations[d].type, expected.decorations[d].type);
+            ASSERT_EQ(actual.decorations[d].color, expected.decorations[d].color);
+            ASSERT_EQ(actual.decorations[d].start.x, expected.decorations[d].start.x);
+            ASSERT_EQ(actual.decorations[d].end.x, expected.decorations[d].end.x);
+        }
+    }
+
     odtr::ContextHandle context;
+    odtr::ContextHandle expectedContext = nullptr;
 
     const std::string singleLetterOctopusPath = std::string(TESTING_OCTOPUS_DIR) + "SingleLetter.json";
     const std::string decorationsOctopusPath = std::string(TESTING_OCTOPUS_DIR) + "Decorations.json";
@@ -112,6 +216,16 @@ TEST_F(TextRendererApiTests, singleLetter) {
     ASSERT_EQ(pg.index, 0);
     ASSERT_EQ(pg.originPosition.x, 0.0f);
     ASSERT_EQ(pg.originPosition.y, 571.203125f);
+    ASSERT_EQ(pg.lineIndex, 0);
+    ASSERT_GT(pg.bounds.w, 0.0f);
+    ASSERT_GT(pg.bounds.h, 0.0f);
+
+    ASSERT_EQ(textShape->data->lineBounds.size(), 1);
+    const FRectangle &lineBounds = textShape->data->lineBounds.front();
+    ASSERT_EQ(lineBounds.l, pg.bounds.l);
+    ASSERT_EQ(lineBounds.t, pg.bounds.t);
+    ASSERT_EQ(lineBounds.w, pg.bounds.w);
+    ASSERT_EQ(lineBounds.h, pg.bounds.h);
 
     ode::BitmapPtr bitmap = nullptr;
 
@@ -169,3 +283,654 @@ TEST_F(TextRendererApiTests, decorations) {
     const DrawTextResult drawResult = drawText(context, textShape, bitmap->pixels(), bitmap->width(), bitmap->height(), drawOptions);
     ASSERT_FALSE(drawResult.error);
 }
+
+TEST_F(TextRendererApiTests, faceHandles) {
+    using namespace odtr;
+
+    octopus::Text text;
+    ASSERT_NO_FATAL_FAILURE(loadDecorationsText(text));
+    addMissingFonts(text);
+
+    const TextShapeHandle textShape = shapeText(context, text);
+    ASSERT_TRUE(textShape != nullptr);
+
+    // the shaped glyphs refer to the faces of the context by their handles
+    const FaceTable &faces = context->fontManager->facesTable();
+    for (const auto &fontGlyphs : textShape->getData().glyphs) {
+        const FontSpecifier &fontSpecifier = fontGlyphs.first;
+        ASSERT_EQ(fontSpecifier.faceHandle, faces.getFaceHandle(fontSpecifier.faceId));
+        ASSERT_TRUE(faces.getFaceItem(fontSpecifier.faceHandle) != nullptr);
+        ASSERT_EQ(faces.getFaceItem(fontSpecifier.faceHandle), faces.getFaceItem(fontSpecifier.faceId));
+    }
+
+    // without the handles, as in texts of other contexts, the faces are looked up by their ids
+    PlacedTextData unresolvedText = textShape->getData();
+    unresolvedText.glyphs.clear();
+    for (const auto &fontGlyphs : textShape->getData().glyphs) {
+        unresolvedText.glyphs.emplace(FontSpecifier { fontGlyphs.first.faceId }, fontGlyphs.second);
+    }
+    assertSameRendering(context, textShape, context, unresolvedText);
+}
+
+TEST_F(TextRendererApiTests, viewAreaCulling) {
+    using namespace odtr;
+
+    octopus::Text text;
+    ASSERT_NO_FATAL_FAILURE(loadDecorationsText(text));
+    text.styles.reset();
+    text.value.clear();
+    ASSERT_TRUE(text.frame.has_value());
+    text.frame->mode = octopus::TextFrame::Mode::AUTO_WIDTH;
+    for (int i = 0; i < 30; ++i) {
+        text.value += "Line number " + std::to_string(i) + "\n";
+    }
+    addMissingFonts(text);
+
+    const TextShapeHandle textShape = shapeText(context, text);
+    ASSERT_TRUE(textShape != nullptr);
+    const std::vector<FRectangle> &lineBounds = textShape->getData().lineBounds;
+    ASSERT_GE(lineBounds.size(), 30);
+
+    const DrawOptions drawOptions { 1.0f, std::nullopt };
+    const Dimensions dimensions = getDrawBufferDimensions(context, textShape, drawOptions);
+
+    ode::Bitmap expected(ode::PixelFormat::RGBA, ode::Vector2i(dimensions.width, dimensions.height));
+    expected.clear();
+    const CacheStatistics statsBefore = getGlyphCacheStatistics(context);
+    ASSERT_FALSE(drawText(context, textShape, expected.pixels(), expected.width(), expected.height(), drawOptions).error);
+    const CacheStatistics statsAfter = getGlyphCacheStatistics(context);
+    const size_t allGlyphs = (statsAfter.hits + statsAfter.misses) - (statsBefore.hits + statsBefore.misses);
+
+    // a band of three lines in the middle, drawn into a buffer of the whole text
+    const int top = static_cast<int>(std::ceil(lineBounds[12].t));
+    const int bottom = static_cast<int>(std::floor(lineBounds[14].t + lineBounds[14].h));
+    const DrawOptions viewAreaOptions { 1.0f, Rectangle { 0, top, dimensions.width, bottom - top } };
+
+    ode::Bitmap bitmap(ode::PixelFormat::RGBA, ode::Vector2i(dimensions.width, dimensions.height));
+    bitmap.clear();
+    ASSERT_FALSE(drawText(context, textShape, bitmap.pixels(), bitmap.width(), bitmap.height(), viewAreaOptions).error);
+    const CacheStatistics viewAreaStats = getGlyphCacheStatistics(context);
+    const size_t drawnGlyphs = (viewAreaStats.hits + viewAreaStats.misses) - (statsAfter.hits + statsAfter.misses);
+
+    // glyphs outside of the view area are not rendered, the view area is drawn the same
+    ASSERT_GT(drawnGlyphs, 0);
+    ASSERT_LT(3 * drawnGlyphs, allGlyphs);
+    ASSERT_EQ(viewAreaStats.misses, statsAfter.misses);
+
+    const size_t rowSize = 4 * static_cast<size_t>(dimensions.width);
+    const std::uint8_t *expectedPixels = reinterpret_cast<const std::uint8_t *>(expected.pixels());
+    const std::uint8_t *pixels = reinterpret_cast<const std::uint8_t *>(bitmap.pixels());
+    for (int y = top; y < bottom; ++y) {
+        ASSERT_EQ(std::memcmp(pixels + y * rowSize, expectedPixels + y * rowSize, rowSize), 0) << y;
+    }
+    const int firstLineBottom = static_cast<int>(std::floor(lineBounds[0].t + lineBounds[0].h));
+    const std::vector<std::uint8_t> emptyRow(rowSize, 0);
+    for (int y = 0; y < firstLineBottom; ++y) {
+        ASSERT_EQ(std::memcmp(pixels + y * rowSize, emptyRow.data(), rowSize), 0) << y;
+    }
+}
+
+TEST_F(TextRendererApiTests, shapingCache) {
+    using namespace odtr;
+
+    octopus::Text text;
+    ASSERT_NO_FATAL_FAILURE(loadDecorationsText(text));
+
+    addMissingFonts(text);
+
+    const TextShapeHandle firstShape = shapeText(context, text);
+    ASSERT_TRUE(firstShape != nullptr);
+
+    // words repeated within the text may already be found in the cache
+    const CacheStatistics firstStats = getShapingCacheStatistics(context);
+    ASSERT_GT(firstStats.misses, 0);
+    ASSERT_GT(firstStats.entries, 0);
+
+    // a moved text isn't identical, but its runs are shaped the same
+    octopus::Text movedText = text;
+    movedText.transform[4] += 10.0;
+    const TextShapeHandle secondShape = shapeText(context, movedText);
+    ASSERT_TRUE(secondShape != nullptr);
+
+    const CacheStatistics secondStats = getShapingCacheStatistics(context);
+    ASSERT_EQ(secondStats.hits, firstStats.hits + firstStats.misses);
+    ASSERT_EQ(secondStats.misses, firstStats.misses);
+
+    const PlacedGlyphs &firstGlyphs = firstShape->data->glyphs.at(fontHelveticaNeue);
+    const PlacedGlyphs &secondGlyphs = secondShape->data->glyphs.at(fontHelveticaNeue);
+    ASSERT_EQ(firstGlyphs.size(), secondGlyphs.size());
+    for (size_t i = 0; i < firstGlyphs.size(); ++i) {
+        ASSERT_EQ(firstGlyphs[i].codepoint, secondGlyphs[i].codepoint);
+        ASSERT_EQ(firstGlyphs[i].originPosition.x, secondGlyphs[i].originPosition.x);
+        ASSERT_EQ(firstGlyphs[i].originPosition.y, secondGlyphs[i].originPosition.y);
+    }
+}
+
+TEST_F(TextRendererApiTests, shapingCacheWords) {
+    using namespace odtr;
+
+    octopus::Text text;
+    ASSERT_NO_FATAL_FAILURE(loadDecorationsText(text));
+    text.styles.reset();
+    text.value = "alpha beta gamma";
+    addMissingFonts(text);
+
+    const FaceTable::Item *faceItem = context->fontManager->facesTable().getFaceItem(fontHelveticaNeue.faceId);
+    ASSERT_TRUE(faceItem != nullptr);
+    if (faceItem->face->spaceAffectsShaping()) {
+        GTEST_SKIP() << "words of " << fontHelveticaNeue.faceId << " are shaped in context of the spaces";
+    }
+
+    ASSERT_TRUE(shapeText(context, text) != nullptr);
+    const CacheStatistics firstStats = getShapingCacheStatistics(context);
+    ASSERT_GT(firstStats.misses, 0);
+
+    // the same words in a different text are shaped once
+    text.value = "gamma alpha beta";
+    ASSERT_TRUE(shapeText(context, text) != nullptr);
+    const CacheStatistics secondStats = getShapingCacheStatistics(context);
+    ASSERT_EQ(secondStats.misses, firstStats.misses);
+    ASSERT_GT(secondStats.hits, firstStats.hits);
+}
+
+TEST_F(TextRendererApiTests, shapeTextsBatch) {
+    using namespace odtr;
+
+    odtr::ContextOptions options = contextOptions();
+    options.threadCount = 4;
+    destroyContext(context);
+    context = createContext(options);
+
+    octopus::Octopus singleLetterOctopus;
+    readOctopusFile(singleLetterOctopusPath, singleLetterOctopus);
+    octopus::Octopus decorationsOctopus;
+    readOctopusFile(decorationsOctopusPath, decorationsOctopus);
+
+    const nonstd::optional<octopus::Text> &singleLetterText = singleLetterOctopus.content->layers->front().text;
+    const nonstd::optional<octopus::Text> &decorationsText = decorationsOctopus.content->layers->front().text;
+    ASSERT_TRUE(singleLetterText.has_value());
+    ASSERT_TRUE(decorationsText.has_value());
+
+    addMissingFonts(*singleLetterText);
+    addMissingFonts(*decorationsText);
+
+    std::vector<octopus::Text> texts;
+    for (int i = 0; i < 8; ++i) {
+        texts.push_back(i % 3 ? *decorationsText : *singleLetterText);
+    }
+
+    std::vector<TextShapeHandle> batchShapes(texts.size());
+    shapeTexts(context, texts.data(), texts.size(), batchShapes.data());
+
+    for (size_t i = 0; i < texts.size(); ++i) {
+        const TextShapeHandle batchShape = batchShapes[i];
+        const TextShapeHandle singleShape = shapeExpectedText(texts[i]);
+        ASSERT_TRUE(batchShape != nullptr);
+        ASSERT_TRUE(singleShape != nullptr);
+
+        assertSamePlacedText(batchShape->getData(), singleShape->getData());
+    }
+}
+
+TEST_F(TextRendererApiTests, drawTextsBatch) {
+    using namespace odtr;
+
+    odtr::ContextOptions options = contextOptions();
+    options.threadCount = 4;
+    destroyContext(context);
+    context = createContext(options);
+
+    octopus::Octopus singleLetterOctopus;
+    readOctopusFile(singleLetterOctopusPath, singleLetterOctopus);
+    octopus::Octopus decorationsOctopus;
+    readOctopusFile(decorationsOctopusPath, decorationsOctopus);
+
+    const nonstd::optional<octopus::Text> &singleLetterText = singleLetterOctopus.content->layers->front().text;
+    const nonstd::optional<octopus::Text> &decorationsText = decorationsOctopus.content->layers->front().text;
+    ASSERT_TRUE(singleLetterText.has_value());
+    ASSERT_TRUE(decorationsText.has_value());
+
+    addMissingFonts(*singleLetterText);
+    addMissingFonts(*decorationsText);
+
+    const TextShapeHandle singleLetterShape = shapeText(context, *singleLetterText);
+    const TextShapeHandle decorationsShape = shapeText(context, *decorationsText);
+    ASSERT_TRUE(singleLetterShape != nullptr);
+    ASSERT_TRUE(decorationsShape != nullptr);
+
+    std::vector<DrawJob> jobs;
+    std::vector<ode::BitmapPtr> bitmaps;
+    for (int i = 0; i < 8; ++i) {
+        const TextShapeHandle textShape = i % 3 ? decorationsShape : singleLetterShape;
+        const DrawOptions drawOptions { 1.0f + 0.5f * i, std::nullopt };
+        const Dimensions dimensions = getDrawBufferDimensions(context, textShape, drawOptions);
+
+        ode::BitmapPtr bitmap = std::make_shared<ode::Bitmap>(ode::PixelFormat::RGBA, ode::Vector2i(dimensions.width, dimensions.height));
+        bitmap->clear();
+        bitmaps.push_back(bitmap);
+        jobs.push_back(DrawJob { textShape, bitmap->pixels(), bitmap->width(), bitmap->height(), drawOptions });
+    }
+
+    std::vector<DrawTextResult> results(jobs.size());
+    drawTexts(context, jobs.data(), jobs.size(), results.data());
+
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        const DrawJob &job = jobs[i];
+        ASSERT_FALSE(results[i].error);
+
+        ode::Bitmap bitmap(ode::PixelFormat::RGBA, ode::Vector2i(job.width, job.height));
+        bitmap.clear();
+        const DrawTextResult drawResult = drawText(context, job.textShape, bitmap.pixels(), bitmap.width(), bitmap.height(), job.drawOptions);
+        ASSERT_FALSE(drawResult.error);
+
+        ASSERT_EQ(results[i].bounds.l, drawResult.bounds.l);
+        ASSERT_EQ(results[i].bounds.t, drawResult.bounds.t);
+        ASSERT_EQ(results[i].bounds.w, drawResult.bounds.w);
+        ASSERT_EQ(results[i].bounds.h, drawResult.bounds.h);
+        ASSERT_EQ(std::memcmp(job.pixels, bitmap.pixels(), 4 * job.width * job.height), 0);
+    }
+}
+
+TEST_F(TextRendererApiTests, concurrentDrawText) {
+    using namespace odtr;
+
+    octopus::Text text;
+    ASSERT_NO_FATAL_FAILURE(loadDecorationsText(text));
+
+    addMissingFonts(text);
+
+    const TextShapeHandle textShape = shapeText(context, text);
+    ASSERT_TRUE(textShape != nullptr);
+
+    const DrawOptions drawOptions { 2.0f, std::nullopt };
+    const Dimensions dimensions = getDrawBufferDimensions(context, textShape, drawOptions);
+
+    ode::Bitmap expected(ode::PixelFormat::RGBA, ode::Vector2i(dimensions.width, dimensions.height));
+    expected.clear();
+    ASSERT_FALSE(drawText(context, textShape, expected.pixels(), expected.width(), expected.height(), drawOptions).error);
+
+    std::vector<std::unique_ptr<ode::Bitmap>> bitmaps;
+    std::vector<std::thread> threads;
+    std::vector<char> errors(4, 0);
+    for (size_t t = 0; t < errors.size(); ++t) {
+        bitmaps.push_back(std::make_unique<ode::Bitmap>(ode::PixelFormat::RGBA, ode::Vector2i(dimensions.width, dimensions.height)));
+        bitmaps.back()->clear();
+    }
+    for (size_t t = 0; t < errors.size(); ++t) {
+        threads.emplace_back([this, t, textShape, &drawOptions, &bitmaps, &errors]() {
+            ode::Bitmap &bitmap = *bitmaps[t];
+            errors[t] = drawText(context, textShape, bitmap.pixels(), bitmap.width(), bitmap.height(), drawOptions).error;
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    for (size_t t = 0; t < errors.size(); ++t) {
+        ASSERT_FALSE(errors[t]);
+        ASSERT_EQ(std::memcmp(bitmaps[t]->pixels(), expected.pixels(), 4 * dimensions.width * dimensions.height), 0);
+    }
+}
+
+TEST_F(TextRendererApiTests, parallelParagraphs) {
+    using namespace odtr;
+
+    octopus::Text text;
+    ASSERT_NO_FATAL_FAILURE(loadDecorationsText(text));
+    text.styles.reset();
+    text.value.clear();
+    for (int i = 0; i < 40; ++i) {
+        text.value += "Paragraph number " + std::to_string(i) + " of a long text\n";
+    }
+
+    odtr::ContextOptions options = contextOptions();
+    options.threadCount = 4;
+    destroyContext(context);
+    context = createContext(options);
+    addMissingFonts(text);
+
+    options.threadCount = 1;
+    ContextHandle serialContext = createContext(options);
+    addMissingFonts(serialContext, text);
+
+    const TextShapeHandle parallelShape = shapeText(context, text);
+    const TextShapeHandle serialShape = shapeText(serialContext, text);
+    ASSERT_TRUE(parallelShape != nullptr);
+    ASSERT_TRUE(serialShape != nullptr);
+
+    assertSamePlacedText(parallelShape->getData(), serialShape->getData());
+
+    destroyContext(serialContext);
+}
+
+TEST_F(TextRendererApiTests, incrementalReshape) {
+    using namespace odtr;
+
+    octopus::Text text;
+    ASSERT_NO_FATAL_FAILURE(loadDecorationsText(text));
+    text.styles.reset();
+    text.value.clear();
+    for (int i = 0; i < 20; ++i) {
+        text.value += "Paragraph number " + std::to_string(i) + " of a long text\n";
+    }
+    addMissingFonts(text);
+
+    const TextShapeHandle textShape = shapeText(context, text);
+    ASSERT_TRUE(textShape != nullptr);
+    ASSERT_TRUE(textShape->shapeData != nullptr);
+
+    std::vector<const priv::ParagraphShape *> originalShapes;
+    for (const priv::ParagraphShapePtr &paragraphShape : textShape->shapeData->paragraphShapes) {
+        originalShapes.push_back(paragraphShape.get());
+    }
+    ASSERT_EQ(originalShapes.size(), 20);
+
+    // edit a single paragraph and insert another one
+    octopus::Text editedText = text;
+    const std::string original = "Paragraph number 7 of";
+    editedText.value.replace(editedText.value.find(original), original.size(), "Paragraph number 7, edited, of");
+    editedText.value.insert(editedText.value.find("Paragraph number 12"), "Inserted paragraph\n");
+
+    ASSERT_TRUE(reshapeText(context, textShape, editedText));
+    ASSERT_TRUE(textShape->shapeData != nullptr);
+
+    const priv::ParagraphShapes &reshapedShapes = textShape->shapeData->paragraphShapes;
+    ASSERT_EQ(reshapedShapes.size(), 21);
+    for (size_t i = 0; i < reshapedShapes.size(); ++i) {
+        // the edited and the inserted paragraphs are shaped, the others are reused
+        if (i != 7 && i != 12) {
+            ASSERT_EQ(reshapedShapes[i].get(), originalShapes[i < 12 ? i : i - 1]);
+        }
+    }
+
+    const TextShapeHandle expectedShape = shapeExpectedText(editedText);
+    ASSERT_TRUE(expectedShape != nullptr);
+    assertSamePlacedText(textShape->getData(), expectedShape->getData());
+    assertSameRendering(context, textShape, expectedContext, expectedShape);
+
+    std::vector<const priv::ParagraphShape *> editedShapes;
+    for (const priv::ParagraphShapePtr &paragraphShape : reshapedShapes) {
+        editedShapes.push_back(paragraphShape.get());
+    }
+
+    // paragraphs are matched wherever they are, a moved paragraph is reused as well
+    octopus::Text movedText = editedText;
+    const std::string firstParagraph = "Paragraph number 0 of a long text\n";
+    ASSERT_EQ(movedText.value.find(firstParagraph), 0);
+    movedText.value.erase(0, firstParagraph.size());
+    movedText.value += firstParagraph;
+
+    ASSERT_TRUE(reshapeText(context, textShape, movedText));
+    ASSERT_TRUE(textShape->shapeData != nullptr);
+
+    const priv::ParagraphShapes &movedShapes = textShape->shapeData->paragraphShapes;
+    ASSERT_EQ(movedShapes.size(), editedShapes.size());
+    for (size_t i = 0; i < movedShapes.size(); ++i) {
+        ASSERT_EQ(movedShapes[i].get(), editedShapes[(i + 1) % editedShapes.size()]);
+    }
+    const TextShapeHandle expectedMovedShape = shapeExpectedText(movedText);
+    ASSERT_TRUE(expectedMovedShape != nullptr);
+    assertSameRendering(context, textShape, expectedContext, expectedMovedShape);
+}
+
+TEST_F(TextRendererApiTests, resizeTextFrame) {
+    using namespace odtr;
+
+    octopus::Text decorationsText;
+    ASSERT_NO_FATAL_FAILURE(loadDecorationsText(decorationsText));
+    ASSERT_TRUE(decorationsText.frame.has_value());
+    addMissingFonts(decorationsText);
+
+    const TextShapeHandle textShape = shapeText(context, decorationsText);
+    ASSERT_TRUE(textShape != nullptr);
+
+    for (const double width : { 120.0, 300.0, 552.0 }) {
+        octopus::Text resizedText = decorationsText;
+        resizedText.frame->size = octopus::Dimensions { width, 240.0 };
+
+        ASSERT_TRUE(resizeTextFrame(context, textShape, static_cast<float>(width), 240.0f));
+
+        const TextShapeHandle expectedShape = shapeExpectedText(resizedText);
+        ASSERT_TRUE(expectedShape != nullptr);
+        assertSamePlacedText(textShape->getData(), expectedShape->getData());
+    }
+}
+
+TEST_F(TextRendererApiTests, restyleText) {
+    using namespace odtr;
+
+    octopus::Text decorationsText;
+    ASSERT_NO_FATAL_FAILURE(loadDecorationsText(decorationsText));
+    addMissingFonts(decorationsText);
+
+    const TextShapeHandle textShape = shapeText(context, decorationsText);
+    ASSERT_TRUE(textShape != nullptr);
+
+    // a color change is applied to a copy of the placed text without laying it out
+    octopus::Text recoloredText = decorationsText;
+    ASSERT_TRUE(recoloredText.defaultStyle.fills.has_value());
+    recoloredText.defaultStyle.fills->front().color = octopus::Color { 0.9, 0.1, 0.2, 0.5 };
+
+    ASSERT_TRUE(reshapeText(context, textShape, recoloredText));
+
+    const TextShapeHandle recoloredShape = shapeExpectedText(recoloredText);
+    ASSERT_TRUE(recoloredShape != nullptr);
+    assertSamePlacedText(textShape->getData(), recoloredShape->getData());
+
+    // changed decorations are laid out again
+    octopus::Text redecoratedText = recoloredText;
+    ASSERT_TRUE(redecoratedText.styles.has_value());
+    redecoratedText.styles->front().style.underline = octopus::TextStyle::Underline::DOUBLE;
+
+    ASSERT_TRUE(reshapeText(context, textShape, redecoratedText));
+
+    const TextShapeHandle redecoratedShape = shapeExpectedText(redecoratedText);
+    ASSERT_TRUE(redecoratedShape != nullptr);
+    assertSamePlacedText(textShape->getData(), redecoratedShape->getData());
+}
+
+TEST_F(TextRendererApiTests, resizeFonts) {
+    using namespace odtr;
+
+    octopus::Text decorationsText;
+    ASSERT_NO_FATAL_FAILURE(loadDecorationsText(decorationsText));
+    addMissingFonts(decorationsText);
+
+    const TextShapeHandle textShape = shapeText(context, decorationsText);
+    ASSERT_TRUE(textShape != nullptr);
+
+    octopus::Text resizedText = decorationsText;
+    ASSERT_TRUE(resizedText.defaultStyle.fontSize.has_value());
+    resizedText.defaultStyle.fontSize = *resizedText.defaultStyle.fontSize * 0.5;
+
+    ASSERT_TRUE(reshapeText(context, textShape, resizedText));
+
+    const TextShapeHandle expectedShape = shapeExpectedText(resizedText);
+    ASSERT_TRUE(expectedShape != nullptr);
+
+    // the scaled advances differ from the shaped ones by the rounding of the shaping
+    const PlacedTextData &actual = textShape->getData();
+    const PlacedTextData &expected = expectedShape->getData();
+    ASSERT_EQ(actual.lineBounds.size(), expected.lineBounds.size());
+    ASSERT_EQ(actual.glyphs.size(), expected.glyphs.size());
+
+    for (const auto &fontGlyphs : expected.glyphs) {
+        ASSERT_EQ(actual.glyphs.count(fontGlyphs.first), 1);
+        const PlacedGlyphs &actualGlyphs = actual.glyphs.at(fontGlyphs.first);
+        ASSERT_EQ(actualGlyphs.size(), fontGlyphs.second.size());
+        for (size_t g = 0; g < actualGlyphs.size(); ++g) {
+            ASSERT_EQ(actualGlyphs[g].codepoint, fontGlyphs.second[g].codepoint);
+            ASSERT_EQ(actualGlyphs[g].fontSize, fontGlyphs.second[g].fontSize);
+            ASSERT_EQ(actualGlyphs[g].lineIndex, fontGlyphs.second[g].lineIndex);
+            ASSERT_NEAR(actualGlyphs[g].originPosition.x, fontGlyphs.second[g].originPosition.x, 1.0f);
+            ASSERT_NEAR(actualGlyphs[g].originPosition.y, fontGlyphs.second[g].originPosition.y, 1.0f);
+        }
+    }
+
+    // a text shaped later doesn't get the approximate layout of the resized text shape
+    const TextShapeHandle laterShape = shapeText(context, resizedText);
+    ASSERT_TRUE(laterShape != nullptr);
+    ASSERT_NE(&laterShape->getData(), &actual);
+    assertSamePlacedText(laterShape->getData(), expected);
+}
+
+TEST_F(TextRendererApiTests, sharedPlacedText) {
+    using namespace odtr;
+
+    octopus::Text decorationsText;
+    ASSERT_NO_FATAL_FAILURE(loadDecorationsText(decorationsText));
+    addMissingFonts(decorationsText);
+
+    // identical texts share the placed text of the first one
+    const TextShapeHandle firstShape = shapeText(context, decorationsText);
+    const TextShapeHandle secondShape = shapeText(context, decorationsText);
+    ASSERT_TRUE(firstShape != nullptr);
+    ASSERT_TRUE(secondShape != nullptr);
+    ASSERT_EQ(&secondShape->getData(), &firstShape->getData());
+    ASSERT_TRUE(firstShape->shapeData != nullptr);
+    ASSERT_TRUE(secondShape->shapeData == nullptr);
+    assertSameRendering(context, secondShape, context, firstShape);
+    const TextShapeHandle expectedShape = shapeExpectedText(decorationsText);
+    assertSameRendering(context, secondShape, expectedContext, expectedShape);
+
+    std::vector<octopus::Text> texts(3, decorationsText);
+    texts[1].transform[4] += 10.0;
+    std::vector<TextShapeHandle> batchShapes(texts.size());
+    shapeTexts(context, texts.data(), texts.size(), batchShapes.data());
+    ASSERT_EQ(&batchShapes[0]->getData(), &firstShape->getData());
+    ASSERT_EQ(&batchShapes[2]->getData(), &firstShape->getData());
+    ASSERT_NE(&batchShapes[1]->getData(), &firstShape->getData());
+
+    // a negative zero equals zero
+    octopus::Text negativeZeroText = decorationsText;
+    ASSERT_EQ(negativeZeroText.transform[1], 0.0);
+    negativeZeroText.transform[1] = -0.0;
+    const TextShapeHandle negativeZeroShape = shapeText(context, negativeZeroText);
+    ASSERT_TRUE(negativeZeroShape != nullptr);
+    ASSERT_EQ(&negativeZeroShape->getData(), &firstShape->getData());
+
+    // reshaping a text shape doesn't change the others
+    octopus::Text recoloredText = decorationsText;
+    ASSERT_TRUE(recoloredText.defaultStyle.fills.has_value());
+    recoloredText.defaultStyle.fills->front().color = octopus::Color { 0.9, 0.1, 0.2, 0.5 };
+
+    ASSERT_TRUE(reshapeText(context, secondShape, recoloredText));
+    ASSERT_NE(&secondShape->getData(), &firstShape->getData());
+    assertSamePlacedText(secondShape->getData(), shapeExpectedText(recoloredText)->getData());
+    assertSamePlacedText(firstShape->getData(), shapeExpectedText(decorationsText)->getData());
+
+    ASSERT_TRUE(reshapeText(context, firstShape, recoloredText));
+    ASSERT_EQ(&firstShape->getData(), &secondShape->getData());
+    ASSERT_EQ(&batchShapes[0]->getData(), &batchShapes[2]->getData());
+}
+
+TEST_F(TextRendererApiTests, serializedShapedText) {
+    using namespace odtr;
+
+    octopus::Text text;
+    ASSERT_NO_FATAL_FAILURE(loadDecorationsText(text));
+
+    addMissingFonts(text);
+
+    const TextShapeHandle textShape = shapeText(context, text);
+    ASSERT_TRUE(textShape != nullptr);
+
+    const std::vector<std::uint8_t> blob = serializeShapedText(context, textShape);
+    ASSERT_FALSE(blob.empty());
+    const std::unique_ptr<PlacedTextData> shapedText = deserializeShapedText(context, blob.data(), blob.size());
+    ASSERT_TRUE(shapedText != nullptr);
+    ASSERT_TRUE(deserializeShapedText(context, blob.data(), blob.size() / 2) == nullptr);
+
+    // the deserialized text is drawn identically to the text shape
+    assertSameRendering(context, textShape, context, *shapedText);
+}
+
+TEST_F(TextRendererApiTests, persistentShapeCache) {
+    using namespace odtr;
+
+    octopus::Text text;
+    ASSERT_NO_FATAL_FAILURE(loadDecorationsText(text));
+
+    const std::filesystem::path cacheDirectory = std::filesystem::temp_directory_path() / "odtr-shape-cache-test";
+    std::filesystem::remove_all(cacheDirectory);
+
+    ContextOptions options = contextOptions();
+    options.shapeCacheDirectory = cacheDirectory.string();
+
+    // the first context shapes the text and stores it
+    ContextHandle storingContext = createContext(options);
+    addMissingFonts(storingContext, text);
+    const TextShapeHandle storedShape = shapeText(storingContext, text);
+    ASSERT_TRUE(storedShape != nullptr);
+    CacheStatistics stats = getShapeDiskCacheStatistics(storingContext);
+    ASSERT_EQ(stats.hits, 0);
+    ASSERT_EQ(stats.misses, 1);
+    ASSERT_EQ(stats.entries, 1);
+    ASSERT_GT(stats.bytes, 0);
+
+    // another context reads it instead of shaping
+    ContextHandle readingContext = createContext(options);
+    addMissingFonts(readingContext, text);
+    const TextShapeHandle readShape = shapeText(readingContext, text);
+    ASSERT_TRUE(readShape != nullptr);
+    stats = getShapeDiskCacheStatistics(readingContext);
+    ASSERT_EQ(stats.hits, 1);
+    ASSERT_EQ(stats.misses, 0);
+    assertSamePlacedText(readShape->getData(), storedShape->getData());
+    assertSameRendering(storingContext, storedShape, readingContext, readShape);
+
+    // a different text is not matched
+    octopus::Text movedText = text;
+    movedText.transform[4] += 10.0;
+    ASSERT_TRUE(shapeText(readingContext, movedText) != nullptr);
+    stats = getShapeDiskCacheStatistics(readingContext);
+    ASSERT_EQ(stats.hits, 1);
+    ASSERT_EQ(stats.misses, 1);
+    ASSERT_EQ(stats.entries, 2);
+
+    destroyContext(storingContext);
+    destroyContext(readingContext);
+    std::filesystem::remove_all(cacheDirectory);
+}
+
+TEST_F(TextRendererApiTests, sharedFontData) {
+    using namespace odtr;
+
+    octopus::Text text;
+    ASSERT_NO_FATAL_FAILURE(loadDecorationsText(text));
+
+    const std::vector<std::string> missingFonts = listMissingFonts(context, text);
+    ASSERT_FALSE(missingFonts.empty());
+    addMissingFonts(text);
+    const std::string &fontName = missingFonts.front();
+
+    std::string filename = odtr::test::gFontsDirectory + "/" + fontName + ".ttf";
+    if (!std::filesystem::exists(filename)) {
+        filename = odtr::test::gFontsDirectory + "/" + fontName + ".otf";
+    }
+    std::ifstream file(filename, std::ios::binary);
+    const std::vector<std::uint8_t> fontData((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    ASSERT_FALSE(fontData.empty());
+
+    // the same font under another name and storage key shares the face
+    ASSERT_TRUE(addFontBytes(context, "Alias-" + fontName, std::string(), fontData.data(), fontData.size(), false));
+    ASSERT_TRUE(getFreetypeFace(context, "Alias-" + fontName) != nullptr);
+    ASSERT_EQ(getFreetypeFace(context, "Alias-" + fontName), getFreetypeFace(context, fontName));
+
+    // the texts using either name are placed identically
+    octopus::Text aliasText = text;
+    aliasText.defaultStyle.font->postScriptName = "Alias-" + fontName;
+    if (aliasText.styles.has_value()) {
+        for (auto &styleRange : aliasText.styles.value()) {
+            if (styleRange.style.font.has_value()) {
+                styleRange.style.font->postScriptName = "Alias-" + fontName;
+            }
+        }
+    }
+    const TextShapeHandle textShape = shapeText(context, text);
+    const TextShapeHandle aliasShape = shapeText(context, aliasText);
+    ASSERT_TRUE(textShape != nullptr);
+    ASSERT_TRUE(aliasShape != nullptr);
+    ASSERT_EQ(getBounds(context, aliasShape).w, getBounds(context, textShape).w);
+    assertSameRendering(context, textShape, context, aliasShape);
+}